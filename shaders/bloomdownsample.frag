@@ -0,0 +1,46 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D texSampler;
+
+layout (location = 0) in VOUT
+{
+    vec2 uv;
+    flat vec2 region;
+} vInput;
+
+layout (location = 0) out vec4 color;
+
+// bilinear taps at the edge of the rendered part must not reach texels outside of it (see present.frag)
+vec3 tap(vec2 a_uv)
+{
+    return texture(texSampler, min(a_uv, vInput.region - 0.5f / vec2(textureSize(texSampler, 0)))).rgb;
+}
+
+// 13 tap filter (Jimenez, "Next generation post processing in Call of Duty: Advanced Warfare")
+void main()
+{
+    vec2 texelSize = 1.0f / vec2(textureSize(texSampler, 0));
+
+    vec3 a = tap(vInput.uv + texelSize * vec2(-2.0f, +2.0f));
+    vec3 b = tap(vInput.uv + texelSize * vec2( 0.0f, +2.0f));
+    vec3 c = tap(vInput.uv + texelSize * vec2(+2.0f, +2.0f));
+    vec3 d = tap(vInput.uv + texelSize * vec2(-2.0f,  0.0f));
+    vec3 e = tap(vInput.uv);
+    vec3 f = tap(vInput.uv + texelSize * vec2(+2.0f,  0.0f));
+    vec3 g = tap(vInput.uv + texelSize * vec2(-2.0f, -2.0f));
+    vec3 h = tap(vInput.uv + texelSize * vec2( 0.0f, -2.0f));
+    vec3 i = tap(vInput.uv + texelSize * vec2(+2.0f, -2.0f));
+    vec3 j = tap(vInput.uv + texelSize * vec2(-1.0f, +1.0f));
+    vec3 k = tap(vInput.uv + texelSize * vec2(+1.0f, +1.0f));
+    vec3 l = tap(vInput.uv + texelSize * vec2(-1.0f, -1.0f));
+    vec3 m = tap(vInput.uv + texelSize * vec2(+1.0f, -1.0f));
+
+    vec3 result = e * 0.125f;
+    result += (a + c + g + i) * 0.03125f;
+    result += (b + d + f + h) * 0.0625f;
+    result += (j + k + l + m) * 0.125f;
+
+    color = vec4(result, 1.0f);
+}
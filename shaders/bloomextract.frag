@@ -0,0 +1,58 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D sceneColor;
+
+layout (location = 0) in VOUT
+{
+    vec2 uv;
+    flat vec2 region;
+} vInput;
+
+layout (location = 0) out vec4 color;
+
+const float threshold = 1.0f;
+const float knee      = 0.5f;
+
+// bilinear taps at the edge of the rendered part must not reach texels outside of it (see present.frag)
+vec3 tap(vec2 a_uv)
+{
+    return texture(sceneColor, min(a_uv, vInput.region - 0.5f / vec2(textureSize(sceneColor, 0)))).rgb;
+}
+
+// 13 tap filter (Jimenez, "Next generation post processing in Call of Duty: Advanced Warfare")
+vec3 downsample(vec2 a_uv)
+{
+    vec2 texelSize = 1.0f / vec2(textureSize(sceneColor, 0));
+
+    vec3 a = tap(a_uv + texelSize * vec2(-2.0f, +2.0f));
+    vec3 b = tap(a_uv + texelSize * vec2( 0.0f, +2.0f));
+    vec3 c = tap(a_uv + texelSize * vec2(+2.0f, +2.0f));
+    vec3 d = tap(a_uv + texelSize * vec2(-2.0f,  0.0f));
+    vec3 e = tap(a_uv);
+    vec3 f = tap(a_uv + texelSize * vec2(+2.0f,  0.0f));
+    vec3 g = tap(a_uv + texelSize * vec2(-2.0f, -2.0f));
+    vec3 h = tap(a_uv + texelSize * vec2( 0.0f, -2.0f));
+    vec3 i = tap(a_uv + texelSize * vec2(+2.0f, -2.0f));
+    vec3 j = tap(a_uv + texelSize * vec2(-1.0f, +1.0f));
+    vec3 k = tap(a_uv + texelSize * vec2(+1.0f, +1.0f));
+    vec3 l = tap(a_uv + texelSize * vec2(-1.0f, -1.0f));
+    vec3 m = tap(a_uv + texelSize * vec2(+1.0f, -1.0f));
+
+    return e * 0.125f + (a + c + g + i) * 0.03125f + (b + d + f + h) * 0.0625f + (j + k + l + m) * 0.125f;
+}
+
+void main()
+{
+    vec3 result = downsample(vInput.uv);
+
+    // soft threshold with quadratic knee
+    float brightness = max(result.r, max(result.g, result.b));
+    float soft = clamp(brightness - threshold + knee, 0.0f, 2.0f * knee);
+    soft = soft * soft / (4.0f * knee + 0.00001f);
+
+    float contribution = max(soft, brightness - threshold) / max(brightness, 0.00001f);
+
+    color = vec4(result * contribution, 1.0f);
+}
@@ -0,0 +1,45 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D texSampler;
+
+layout (location = 0) in VOUT
+{
+    vec2 uv;
+    flat vec2 region;
+} vInput;
+
+layout (location = 0) out vec4 color;
+
+// NOTE: BloomUpsampleConstants() on cpu side
+layout(constant_id = 0) const float filterRadius = 1.0f; // in texels of the smaller (source) level
+
+// bilinear taps at the edge of the rendered part must not reach texels outside of it (see present.frag)
+vec3 tap(vec2 a_uv)
+{
+    return texture(texSampler, min(a_uv, vInput.region - 0.5f / vec2(textureSize(texSampler, 0)))).rgb;
+}
+
+// 3x3 tent filter, result is additively blended into the bigger level
+void main()
+{
+    vec2 texelSize = filterRadius / vec2(textureSize(texSampler, 0));
+
+    vec3 a = tap(vInput.uv + texelSize * vec2(-1.0f, +1.0f));
+    vec3 b = tap(vInput.uv + texelSize * vec2( 0.0f, +1.0f));
+    vec3 c = tap(vInput.uv + texelSize * vec2(+1.0f, +1.0f));
+    vec3 d = tap(vInput.uv + texelSize * vec2(-1.0f,  0.0f));
+    vec3 e = tap(vInput.uv);
+    vec3 f = tap(vInput.uv + texelSize * vec2(+1.0f,  0.0f));
+    vec3 g = tap(vInput.uv + texelSize * vec2(-1.0f, -1.0f));
+    vec3 h = tap(vInput.uv + texelSize * vec2( 0.0f, -1.0f));
+    vec3 i = tap(vInput.uv + texelSize * vec2(+1.0f, -1.0f));
+
+    vec3 result = e * 4.0f;
+    result += (b + d + f + h) * 2.0f;
+    result += (a + c + g + i);
+    result /= 16.0f;
+
+    color = vec4(result, 1.0f);
+}
@@ -7,12 +7,19 @@ layout(set = 0, binding = 0) uniform sampler2D texSampler;
 layout (location = 0) in VOUT
 {
     vec2 uv;
+    flat vec2 region;
 } vInput;
 
 layout (location = 0) out float color;
 
 const int window = 2;
 
+// bilinear taps at the edge of the rendered part must not reach texels outside of it (see present.frag)
+float tap(vec2 a_uv)
+{
+    return texture(texSampler, min(a_uv, vInput.region - 0.5f / vec2(textureSize(texSampler, 0)))).r;
+}
+
 void main() 
 {
     vec2 texelSize = 1.0f / vec2(textureSize(texSampler, 0));
@@ -25,7 +32,7 @@ void main()
         for (int y = -window; y < window; ++y)
         {
             vec2 xy = vec2(float(x), float(y)) * texelSize;
-            color += texture(texSampler, vInput.uv + xy).r;
+            color += tap(vInput.uv + xy);
             num += 1.0f;
         }
     }
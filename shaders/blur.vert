@@ -7,8 +7,17 @@ layout (location = 0) in  vec2 pos;
 layout (location = 0) out VOUT
 {
     vec2 uv;
+    flat vec2 region; // part of the source written by this frame (dynamic resolution), in uv
 } vOut;
 
+layout( push_constant ) uniform constants
+{
+    mat4 dummy1;
+    mat4 dummy2;
+    mat4 dummy3;
+    vec3 region; // xy
+} PushConstants;
+
 void main() 
 {
     vec2 position = pos;
@@ -16,5 +25,7 @@ void main()
     
     vOut.uv   = (vec2(1.0f) + pos) / 2.0f;
     vOut.uv.y = (vOut.uv.y == 1.0f) ? 0.0f : 1.0f;
+
+    vOut.region = PushConstants.region.xy;
 }
 
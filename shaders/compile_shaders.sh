@@ -3,8 +3,8 @@ glslangValidator -V scene.frag -o scene.frag.spv
 glslangValidator -V scene.vert -o scene.vert.spv
 glslangValidator -V shadowmap.vert -o shadowmap.vert.spv
 glslangValidator -V shadowmap.frag -o shadowmap.frag.spv
-glslangValidator -V showcubemap.vert -o showcubemap.vert.spv
-glslangValidator -V showcubemap.frag -o showcubemap.frag.spv
+glslangValidator -V showshadowatlas.vert -o showshadowatlas.vert.spv
+glslangValidator -V showshadowatlas.frag -o showshadowatlas.frag.spv
 glslangValidator -V particle.frag -o particle.frag.spv
 glslangValidator -V particle.vert -o particle.vert.spv
 glslangValidator -V gbuffer.frag -o gbuffer.frag.spv
@@ -13,7 +13,27 @@ glslangValidator -V ssao.frag -o ssao.frag.spv
 glslangValidator -V ssao.vert -o ssao.vert.spv
 glslangValidator -V blur.vert -o blur.vert.spv
 glslangValidator -V blur.frag -o blur.frag.spv
-glslangValidator -V bloom.vert -o bloom.vert.spv
-glslangValidator -V bloom.frag -o bloom.frag.spv
-glslangValidator -V gauss.vert -o gauss.vert.spv
-glslangValidator -V gauss.frag -o gauss.frag.spv
+glslangValidator -V ssao.comp -o ssao.comp.spv
+glslangValidator -V blur.comp -o blur.comp.spv
+glslangValidator -V particles.comp -o particles.comp.spv
+glslangValidator -V particlescull.comp -o particlescull.comp.spv
+glslangValidator -V clusters.comp -o clusters.comp.spv
+glslangValidator -V hiz.comp -o hiz.comp.spv
+glslangValidator -V gbufferdownsample.vert -o gbufferdownsample.vert.spv
+glslangValidator -V gbufferdownsample.frag -o gbufferdownsample.frag.spv
+glslangValidator -V ssaoupsample.vert -o ssaoupsample.vert.spv
+glslangValidator -V ssaoupsample.frag -o ssaoupsample.frag.spv
+glslangValidator -V temporal.vert -o temporal.vert.spv
+glslangValidator -V temporal.frag -o temporal.frag.spv
+glslangValidator -V bloomextract.vert -o bloomextract.vert.spv
+glslangValidator -V bloomextract.frag -o bloomextract.frag.spv
+glslangValidator -V bloomdownsample.vert -o bloomdownsample.vert.spv
+glslangValidator -V bloomdownsample.frag -o bloomdownsample.frag.spv
+glslangValidator -V bloomupsample.vert -o bloomupsample.vert.spv
+glslangValidator -V bloomupsample.frag -o bloomupsample.frag.spv
+glslangValidator -V present.vert -o present.vert.spv
+glslangValidator -V present.frag -o present.frag.spv
+glslangValidator -V oitcomposite.vert -o oitcomposite.vert.spv
+glslangValidator -V oitcomposite.frag -o oitcomposite.frag.spv
+glslangValidator -V particleshadow.vert -o particleshadow.vert.spv
+glslangValidator -V particleshadow.frag -o particleshadow.frag.spv
@@ -2,18 +2,28 @@
 
 #version 450 core
 
-layout (location = 0) out vec4 gPosition;
-layout (location = 1) out vec4 gNormal;
+// position is reconstructed from the depth buffer, so only normals are stored
+layout (location = 0) out vec2 gNormal;
 
 layout (location = 0) in VOUT
 {
-    vec3 position;
     vec3 normal;
     vec2 uv;
 } vInput;
 
+vec2 octWrap(vec2 v)
+{
+    return (1.0f - abs(v.yx)) * vec2((v.x >= 0.0f) ? 1.0f : -1.0f, (v.y >= 0.0f) ? 1.0f : -1.0f);
+}
+
+// unit vector --> [-1..1]^2 (octahedral mapping)
+vec2 encodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    return (n.z >= 0.0f) ? n.xy : octWrap(n.xy);
+}
+
 void main()
 {
-    gPosition   = vec4(vInput.position, 1.0f);
-    gNormal     = vec4(normalize(vInput.normal), 1.0f);
+    gNormal = encodeNormal(normalize(vInput.normal));
 }
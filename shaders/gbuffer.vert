@@ -8,7 +8,6 @@ layout (location = 2) in vec2 vUVCoord;
 
 layout (location = 0) out VOUT
 {
-    vec3 position;
     vec3 normal;
     vec2 uv;
 } vOut;
@@ -21,13 +20,17 @@ layout( push_constant ) uniform constants
     vec3 dummy;
 } PushConstants;
 
+invariant gl_Position;
+
 void main()
 {
-    gl_Position = PushConstants.projection * PushConstants.view * PushConstants.model * vec4(vPosition, 1.0f);
+    // NOTE: same operations as in scene.vert, scene pass tests its depth for EQUAL against this one
+    vec4 worldPosition = PushConstants.model * vec4(vPosition, 1.0f);
+    vec4 viewPosition  = PushConstants.view * worldPosition;
+    gl_Position        = PushConstants.projection * viewPosition;
 
     mat3 normalMatrix = transpose(inverse(mat3(PushConstants.view * PushConstants.model)));
 
     vOut.normal       = normalMatrix * vNormal;
-    vOut.position     = vec4(PushConstants.view * PushConstants.model * vec4(vPosition, 1.0f)).xyz;
     vOut.uv           = vUVCoord;
 }
@@ -0,0 +1,53 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+// SSAO_DOWNSCALE: every low resolution texel covers DOWNSCALE x DOWNSCALE g buffer texels
+layout(constant_id = 0) const int DOWNSCALE = 2;
+
+layout(set = 0, binding = 0) uniform sampler2D gDepth;
+layout(set = 1, binding = 0) uniform sampler2D gNormal;
+
+layout (location = 0) in VOUT
+{
+    vec2 uv;
+} vInput;
+
+layout (location = 0) out float lowResDepth;
+layout (location = 1) out vec2  lowResNormal;
+
+// cleared depth (1.0) is empty background, it should never win over geometry
+float farness(float a_depth)
+{
+    return (a_depth < 1.0f) ? a_depth : -1.0f;
+}
+
+void main()
+{
+    ivec2 frameDim = textureSize(gDepth, 0);
+    // top left texel of the footprint of this low resolution texel
+    ivec2 base = ivec2(gl_FragCoord.xy) * DOWNSCALE;
+
+    // picking (not averaging) keeps depths and normals on the surfaces,
+    // the farthest sample wins so that empty background never hides geometry
+    ivec2 picked = clamp(base, ivec2(0), frameDim - 1);
+    float depth  = texelFetch(gDepth, picked, 0).r;
+
+    for (int x = 0; x < DOWNSCALE; ++x)
+    {
+        for (int y = 0; y < DOWNSCALE; ++y)
+        {
+            ivec2 texel = clamp(base + ivec2(x, y), ivec2(0), frameDim - 1);
+            float d     = texelFetch(gDepth, texel, 0).r;
+
+            if (farness(d) > farness(depth))
+            {
+                depth  = d;
+                picked = texel;
+            }
+        }
+    }
+
+    lowResDepth  = depth;
+    lowResNormal = texelFetch(gNormal, picked, 0).rg;
+}
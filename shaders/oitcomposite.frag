@@ -0,0 +1,23 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+// weighted blended particles of the same pixel (previous subpass)
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput accumulation; // weighted premultiplied color, weighted coverage
+layout(input_attachment_index = 1, set = 1, binding = 0) uniform subpassInput revealageMap; // product of (1 - coverage)
+
+layout (location = 0) out vec4 color;
+
+void main()
+{
+    float revealage = subpassLoad(revealageMap).r;
+    if (revealage == 1.0f)
+    {
+        discard; // no particle covers the pixel
+    }
+
+    vec4 accum = subpassLoad(accumulation);
+
+    // blended over scene color as (average color, 1 - revealage), see "particle composite" pipeline
+    color = vec4(accum.rgb / max(accum.a, 1e-5f), 1.0f - revealage);
+}
@@ -0,0 +1,10 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+layout (location = 0) in  vec2 pos;
+
+void main() 
+{
+    gl_Position = vec4(pos, 0.0f, 1.0f);
+}
@@ -9,9 +9,14 @@ layout (location = 0) in VOUT
     vec4 color;
     float alpha;
     float rotation;
+    float viewDepth;
 } vInput;
 
-layout(location = 0) out vec4 color;
+// NOTE: ParticleConstants() on cpu side
+layout(constant_id = 0) const bool weightedOIT = false;
+
+layout(location = 0) out vec4  color;     // added to scene color, or weighted sum of premultiplied colors and coverages
+layout(location = 1) out float revealage; // weighted oit only: multiplied into the product of (1 - coverage)
 
 void main()
 {
@@ -23,6 +28,24 @@ void main()
 
     vec2 uv = center + (gl_PointCoord.xy - center) * cosinus + vec2(1.0f, -1.0f) * (gl_PointCoord.yx - center) * sinus;
 
-    color = texture(fireSampler, uv) * vInput.color * vInput.alpha;
-    color.w = 0.0f;
+    vec4 texel = texture(fireSampler, uv);
+
+    if (!weightedOIT)
+    {
+        // added to scene color (order independent, see "particle system" pipeline)
+        color = texel * vInput.color * vInput.alpha;
+        color.w = 0.0f;
+        return;
+    }
+
+    // weighted blended order independent transparency (McGuire and Bavoil 2013): coverage fades in and out with the life
+    // of the particle, the depth weight lets nearer particles dominate the average without sorting
+    float coverage = clamp(texel.a * vInput.color.a * alpha, 0.0f, 1.0f);
+    vec3  premultiplied = texel.rgb * vInput.color.rgb * coverage;
+
+    float z = vInput.viewDepth;
+    float weight = coverage * clamp(10.0f / (1e-5f + pow(z / 5.0f, 2.0f) + pow(z / 200.0f, 6.0f)), 1e-2f, 3e3f);
+
+    color     = vec4(premultiplied, coverage) * weight;
+    revealage = coverage;
 }
@@ -13,6 +13,7 @@ layout (location = 0) out VOUT
     vec4 color;
     float alpha;
     float rotation;
+    float viewDepth; // weight of weighted blended oit
 } vOut;
 
 layout( push_constant ) uniform constants
@@ -20,7 +21,7 @@ layout( push_constant ) uniform constants
     mat4 model;
     mat4 view;
     mat4 projection;
-    vec3 dummy;
+    vec3 renderScale; // xy = render scale of the camera passes, z = point size scale (point size is in pixels, follows the height)
 } PushConstants;
 
 void main()
@@ -29,6 +30,9 @@ void main()
     vOut.alpha    = vAlpha;
     vOut.rotation = vRotation;
 
-    gl_Position = PushConstants.projection * PushConstants.view * PushConstants.model * vPosition;
-    gl_PointSize = 3.0f * vSize;
+    vec4 viewPosition = PushConstants.view * PushConstants.model * vPosition;
+    vOut.viewDepth    = -viewPosition.z;
+
+    gl_Position = PushConstants.projection * viewPosition;
+    gl_PointSize = 3.0f * vSize * PushConstants.renderScale.z;
 }
@@ -0,0 +1,37 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D fireSampler;
+
+layout (location = 0) in VOUT
+{
+    float alpha;
+    float rotation;
+    float lightDistance;
+} vInput;
+
+layout (location = 0) out float color;
+
+const float alphaCutoff = 0.5f;
+
+void main()
+{
+    float alpha = (vInput.alpha <= 1.0f) ? vInput.alpha : 2.0f - vInput.alpha;
+
+    // same sprite as particle.frag
+    float center = 0.5f;
+    float cosinus = cos(vInput.rotation);
+    float sinus = sin(vInput.rotation);
+
+    vec2 uv = center + (gl_PointCoord.xy - center) * cosinus + vec2(1.0f, -1.0f) * (gl_PointCoord.yx - center) * sinus;
+
+    // alpha tested: depth is written, nothing is blended
+    if (texture(fireSampler, uv).a * alpha < alphaCutoff)
+    {
+        discard;
+    }
+
+    // distance to light, as shadowmap.frag stores it
+    color = vInput.lightDistance;
+}
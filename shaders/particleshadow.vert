@@ -0,0 +1,41 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+layout(location = 0) in vec4  vPosition;
+layout(location = 1) in vec4  vColor;
+layout(location = 2) in float vAlpha;
+layout(location = 3) in float vSize;
+layout(location = 4) in float vRotation;
+
+layout (location = 0) out VOUT
+{
+    float alpha;
+    float rotation;
+    float lightDistance; // of the particle center, the whole sprite casts at it
+} vOut;
+
+layout( push_constant ) uniform constants
+{
+    mat4  model;
+    mat4  view;
+    mat4  projection;
+    vec3  lightPos;
+    float spriteScale; // pixels of the face per unit of particle size at distance 1 (PARTICLE_SHADOW_SPRITE_SIZE on cpu side)
+} PushConstants;
+
+void main()
+{
+    vOut.alpha         = vAlpha;
+    vOut.rotation      = vRotation;
+    vOut.lightDistance = length(vPosition.xyz - PushConstants.lightPos);
+
+    gl_Position  = PushConstants.projection * PushConstants.view * PushConstants.model * vPosition;
+    gl_PointSize = max(3.0f * vSize * PushConstants.spriteScale / max(gl_Position.w, 0.0001f), 1.0f);
+
+    // dead (waiting for respawn) or fully faded particles are moved out of the clip volume
+    if (vAlpha <= 0.0f || vAlpha > 2.0f || vSize <= 0.0f)
+    {
+        gl_Position = vec4(0.0f, 0.0f, 2.0f, 1.0f);
+    }
+}
@@ -0,0 +1,29 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D sceneColor;
+layout(set = 1, binding = 0) uniform sampler2D bloom;
+
+layout (location = 0) in VOUT
+{
+    vec2 uv;
+    flat vec2 region;
+} vInput;
+
+layout (location = 0) out vec4 color;
+
+const float bloomStrength = 0.5f;
+
+// bilinear taps at the edge of the rendered part must not reach texels outside of it
+vec2 clampToRegion(sampler2D a_texture)
+{
+    return min(vInput.uv, vInput.region - 0.5f / vec2(textureSize(a_texture, 0)));
+}
+
+void main()
+{
+    vec3 result = texture(sceneColor, clampToRegion(sceneColor)).rgb + bloomStrength * texture(bloom, clampToRegion(bloom)).rgb;
+
+    color = vec4(clamp(result, 0.0f, 1.0f), 1.0f);
+}
@@ -8,54 +8,154 @@ layout (location = 0) in VOUT
     vec3 worldModel;
     vec3 worldLight;
     vec2 uv;
+    float emission;
+    vec3 lightColor;
+    float viewDepth;
+    vec4 clipPosition;
 } vInput;
 
 layout(location = 0) out vec4 color;
 
 layout(set = 0, binding = 0) uniform sampler2D   texSampler;
-layout(set = 1, binding = 0) uniform samplerCube shadowMap;
-layout(set = 2, binding = 0) uniform sampler2D   ssaoMap;
+layout(set = 1, binding = 0) uniform sampler2D   shadowAtlas; // the fire light is sampled by the temporal pass, point lights here
+layout(input_attachment_index = 0, set = 2, binding = 0) uniform subpassInput aoShadowMap; // r = ao, g = shadow (accumulated over frames)
 
-const float eps      = 0.15f;
-const float shadow   = 0.5f;
-const float pcfDelta = 0.03f;
+// NOTE: same as clusters.comp (tiles split the targets into clusterX x clusterY, whatever their size)
+const uint  clusterX            = 16;
+const uint  clusterY            = 9;
+const uint  clusterZ            = 24;
+const uint  maxLightsPerCluster = 31;
+const float clusterNear         = 0.5f;
+const float clusterFar          = 70.0f;
 
-float PCF(vec3 a_toLight)
+struct PointLight
 {
-    int size = 1;
-    float sumShadow = 0.0f;
+    vec4 positionRadius;
+    vec4 color;
+};
 
-    for (int y = -size; y <= size; ++y)
+layout(std430, set = 3, binding = 0) readonly buffer LightsSSBO
+{
+    uint       lightCount;
+    PointLight lights[];
+};
+
+layout(std430, set = 4, binding = 0) readonly buffer ClustersSSBO
+{
+    uint clusters[];
+};
+
+// NOTE: SHADOW_FACES, SHADOW_LIGHTS and ShadowFaceData on cpu side
+#define SHADOW_FACES  6
+#define SHADOW_LIGHTS 5
+
+struct ShadowFace
+{
+    mat4 viewProjection;
+    vec4 region;   // xy = atlas uv of the top left corner, z = side in uv (0 = casts nothing)
+    vec4 lightPos;
+    vec4 forward;
+};
+
+layout(std430, set = 5, binding = 0) readonly buffer ShadowFaces
+{
+    ShadowFace faces[SHADOW_LIGHTS * SHADOW_FACES];
+} shadowFaces;
+
+const float pointShadowEps = 0.05f;
+
+// 0 when a_position is hidden from the point light whose faces start at a_firstFace (single tap, as in temporal.frag
+// but without accumulation over frames), the normal offset keeps the surface from shadowing itself
+float pointShadow(uint a_firstFace, vec3 a_position)
+{
+    uint  face    = a_firstFace;
+    float closest = -1.0f;
+
+    for (uint i = a_firstFace; i < a_firstFace + SHADOW_FACES; ++i)
     {
-        for (int x = -size; x <= size; ++x)
+        vec3  toPosition = normalize(a_position - shadowFaces.faces[i].lightPos.xyz);
+        float alignment  = dot(toPosition, shadowFaces.faces[i].forward.xyz);
+
+        if (alignment > closest)
         {
-            for (int z = -size; z <= size; ++z)
-            {
-                vec3 lightVec = a_toLight + pcfDelta * vec3(x, y, z);
-
-                if (length(lightVec) > texture(shadowMap, lightVec).r + eps)
-                {
-                    sumShadow += shadow; 
-                }
-                else
-                {
-                    sumShadow += 1.0f; 
-                }
-            }
+            closest = alignment;
+            face    = i;
         }
     }
 
-    return sumShadow / ((2 * size + 1) * (2 * size + 1) * (2 * size + 1));
+    ShadowFace shadowFace = shadowFaces.faces[face];
+
+    if (shadowFace.region.z == 0.0f)
+    {
+        return 1.0f;
+    }
+
+    vec3 position = a_position + vInput.normal * pointShadowEps;
+
+    // viewports of the faces are flipped like the ones of the camera
+    vec4 clip = shadowFace.viewProjection * vec4(position, 1.0f);
+    vec2 uv   = vec2(clip.x, -clip.y) / clip.w * 0.5f + 0.5f;
+
+    // texels of the neighbouring regions are never read
+    vec2 halfTexel = 0.5f / vec2(textureSize(shadowAtlas, 0));
+    vec2 atlasUV   = shadowFace.region.xy + clamp(uv * shadowFace.region.z, halfTexel, shadowFace.region.zz - halfTexel);
+
+    return (length(position - shadowFace.lightPos.xyz) > texture(shadowAtlas, atlasUV).r + pointShadowEps) ? 0.0f : 1.0f;
+}
+
+// point lights of the cluster this fragment falls into, the ones with faces in the shadow atlas (color.a = first of them)
+// are shadowed
+vec3 clusteredLights(vec3 a_albedo)
+{
+    // viewport is flipped, tile row 0 is at the top (ndc.y = 1), as in clusters.comp
+    vec2  ndc   = vInput.clipPosition.xy / vInput.clipPosition.w;
+    uvec2 tile  = uvec2(clamp(vec2(ndc.x + 1.0f, 1.0f - ndc.y) * 0.5f * vec2(clusterX, clusterY), vec2(0.0f),
+                vec2(clusterX - 1, clusterY - 1)));
+    float depth = max(vInput.viewDepth, clusterNear);
+    uint  slice = min(uint(log(depth / clusterNear) / log(clusterFar / clusterNear) * float(clusterZ)), clusterZ - 1);
+    uint  base  = ((slice * clusterY + tile.y) * clusterX + tile.x) * (maxLightsPerCluster + 1);
+
+    vec3 result = vec3(0.0f);
+
+    uint count = clusters[base];
+    for (uint i = 0; i < count; ++i)
+    {
+        PointLight light = lights[clusters[base + 1 + i]];
+
+        vec3  toLight  = light.positionRadius.xyz - vInput.worldModel;
+        float distance = length(toLight);
+
+        // smooth falloff reaching zero at the radius of influence (the one clusters were built with)
+        float falloff = clamp(1.0f - pow(distance / light.positionRadius.w, 4.0f), 0.0f, 1.0f);
+        float attenuation = falloff * falloff / (distance * distance + 1.0f);
+
+        if (light.color.a >= 0.0f)
+        {
+            attenuation *= pointShadow(uint(light.color.a), vInput.worldModel);
+        }
+
+        result += a_albedo * light.color.rgb * max(dot(vInput.normal, toLight / distance), 0.0f) * attenuation;
+    }
+
+    return result;
 }
 
 void main()
 {
     vec3 toLight = vInput.worldLight -vInput.worldModel;
 
-    vec4 diffuse = vec4(1.0f) * max(dot(vInput.normal, normalize(toLight)), 0.0f);
+    // fire emitter light (see ParticleSystem::getLightColor)
+    vec4 diffuse = vec4(vInput.lightColor, 1.0f) * max(dot(vInput.normal, normalize(toLight)), 0.0f);
+
+    vec4 albedo = texture(texSampler, vInput.uv);
+
+    color = vec4(0.1f) + diffuse * albedo;
+
+    vec2 aoShadow = subpassLoad(aoShadowMap).rg;
+    color.rgb *= aoShadow.g * aoShadow.r;
 
-    color = vec4(0.1f) + diffuse * texture(texSampler, vInput.uv);
+    color.rgb += clusteredLights(albedo.rgb) * aoShadow.r;
 
-    vec3 ssao = vec3(texelFetch(ssaoMap, ivec2(gl_FragCoord.xy), 0).r);
-    color.rgb *= PCF(toLight) * ssao;
+    // glowing objects go above 1.0 and get picked up by bloom
+    color.rgb += albedo.rgb * vInput.emission;
 }
@@ -12,6 +12,10 @@ layout (location = 0) out VOUT
     vec3 worldModel;
     vec3 worldLight;
     vec2 uv;
+    float emission;
+    vec3 lightColor;
+    float viewDepth;    // picks cluster of point lights (with the tile of clipPosition)
+    vec4 clipPosition;
 } vOut;
 
 out gl_PerVertex
@@ -19,12 +23,17 @@ out gl_PerVertex
     vec4 gl_Position;
 };
 
+invariant gl_Position; // depth is tested for EQUAL against the one of gbuffer.vert
+
 layout( push_constant ) uniform constants
 {
     mat4 model;
     mat4 view;
     mat4 projection;
     vec3 lightPos;
+    float emission;
+    uint dummy;
+    vec4 lightColor;
 } PushConstants;
 
 void main() 
@@ -34,12 +43,18 @@ void main()
     vOut.uv         = vUVCoord;
     vOut.worldLight = PushConstants.lightPos;
     vOut.worldModel = worldPosition.xyz;
+    vOut.emission   = PushConstants.emission;
+    vOut.lightColor = PushConstants.lightColor.rgb;
 
     // our toLight vector is in world space coords (normal should be in world space coords too)
     mat3 normalMatrix = transpose(inverse(mat3(PushConstants.model)));
     vOut.normal       = normalize(normalMatrix * vNormal);
 
+    vec4 viewPosition = PushConstants.view * worldPosition;
+    vOut.viewDepth    = -viewPosition.z;
+
     // camera POV
-    gl_Position = PushConstants.projection * PushConstants.view * worldPosition;
+    gl_Position       = PushConstants.projection * viewPosition;
+    vOut.clipPosition = gl_Position;
 }
 
@@ -0,0 +1,17 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+layout (binding = 0) uniform sampler2D atlas;
+
+layout (location = 0) in  vec2 uv;
+layout (location = 0) out vec4 color;
+
+#define EXPOSITION 0.03f
+
+void main()
+{
+    // distances to the light, regions no face was rendered into are black
+    float dist = texture(atlas, uv).r * EXPOSITION;
+    color = vec4(vec3(dist), 1.0);
+}
@@ -0,0 +1,14 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+layout (location = 0) in  vec2 pos;
+layout (location = 0) out vec2 uv;
+
+void main() 
+{
+    // viewport is flipped, so the top left corner of the atlas is shown in the top left corner of the screen
+    uv = vec2(pos.x, -pos.y) * 0.5f + 0.5f;
+
+    gl_Position = vec4(pos, 0.0f, 1.0f);
+}
@@ -2,12 +2,17 @@
 
 #version 450 core
 
-const int   ssaoKernelSize = 30;
-const float ssaoRadius     = 0.2f;
-const float eps            = 0.025f;
+const int   ssaoKernelSize      = 32; // NOTE: SSAO_SAMPLING_KERNEL_SIZE on cpu side (size of the kernel ubo)
+const float eps                 = 0.025f;
+const float goldenAngle         = 2.39996323f;
 
-layout(set = 0, binding = 0) uniform sampler2D gPosition;
-layout(set = 1, binding = 0) uniform sampler2D gNormal;
+// NOTE: SSAOConstants() on cpu side
+layout(constant_id = 0) const int   ssaoSamplesPerFrame = 8;
+layout(constant_id = 1) const float ssaoRadius          = 0.2f;
+const int                           ssaoFrameCycle      = ssaoKernelSize / ssaoSamplesPerFrame;
+
+layout(set = 0, binding = 0) uniform sampler2D gDepth;
+layout(set = 1, binding = 0) uniform sampler2D gNormal; // octahedral
 layout(set = 2, binding = 0) uniform sampler2D noiseSampler;
 layout(set = 3, binding = 0) uniform ssaoKernelUBO
 {
@@ -20,13 +25,37 @@ layout (location = 0) in VOUT
 {
     vec2 uv;
     mat4 projection;
+    flat uint frame;
 } vInput;
 
+vec3 decodeNormal(vec2 e)
+{
+    // [-1..1]^2 --> unit vector (octahedral mapping)
+    vec3 n = vec3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0f, 1.0f);
+    n.xy += vec2((n.x >= 0.0f) ? -t : t, (n.y >= 0.0f) ? -t : t);
+    return normalize(n);
+}
+
+// depth buffer value --> view space z (perspective projection)
+float viewZ(float a_depth, mat4 a_proj)
+{
+    return -a_proj[3][2] / (a_depth + a_proj[2][2]);
+}
+
+// a_proj is y flipped, so uv <--> ndc mapping is the same as for the occluder lookup in main()
+vec3 viewPosition(vec2 a_uv, mat4 a_proj)
+{
+    float z   = viewZ(texture(gDepth, a_uv).r, a_proj);
+    vec2  ndc = a_uv * 2.0f - 1.0f;
+    return vec3(-z * (ndc.x + a_proj[2][0]) / a_proj[0][0], -z * (ndc.y + a_proj[2][1]) / a_proj[1][1], z);
+}
+
 mat3 createTBN()
 {
-    vec3 N = normalize(texture(gNormal, vInput.uv).rgb);
+    vec3 N = decodeNormal(texture(gNormal, vInput.uv).rg);
 
-    ivec2 frameDim = textureSize(gPosition, 0);
+    ivec2 frameDim = textureSize(gDepth, 0);
     ivec2 noiseDim = textureSize(noiseSampler, 0);
     // rescale uv for noice sampling
     vec2  uv = vec2(frameDim.x / noiseDim.x, frameDim.y / noiseDim.y) * vInput.uv;
@@ -34,41 +63,49 @@ mat3 createTBN()
 
     // tangent orthogonal to normal of a (normal, randomVec) plane
     vec3 tangent   = normalize(randomVec - N * dot(randomVec, N));
+    // the pattern is rotated every frame, rotations are accumulated by the temporal pass
+    float angle    = goldenAngle * float(vInput.frame % 64u);
+    tangent        = cos(angle) * tangent + sin(angle) * cross(N, tangent);
     vec3 bitangent = cross(tangent, N);
     return mat3(tangent, bitangent, N);
 }
 
 void main()
 {
-    vec3 position = texture(gPosition, vInput.uv).xyz;
+    mat4 proj = vInput.projection;
+    proj[1][1] *= -1;
+    proj[2][1] *= -1;
+
+    vec3 position = viewPosition(vInput.uv, proj);
     mat3 tbnMatrix = createTBN();
 
     float occlusion = 0.0f;
-    for (int i = 0; i < ssaoKernelSize; ++i)
+    // every frame takes an interleaved subset of the kernel
+    int subset = int(vInput.frame % uint(ssaoFrameCycle));
+
+    for (int i = 0; i < ssaoSamplesPerFrame; ++i)
     {
         // tangent --> view
-        vec3 samp = ssaoKernel.samples[i].xyz;
+        vec3 samp = ssaoKernel.samples[i * ssaoFrameCycle + subset].xyz;
         samp = tbnMatrix * samp;
         samp = position + samp * ssaoRadius;
 
         // view --> clip
         vec4 offset = vec4(samp, 1.0);
-        mat4 proj = vInput.projection;
-        proj[1][1] *= -1;
         offset = proj * offset;
         // clip --> normalized device coords
         offset.xyz /= offset.w;
         // normalized device coords --> [0..1]
         offset.xyz = offset.xyz * 0.5f + 0.5f;
 
-        vec3 occluderPos = texture(gPosition, offset.xy).xyz;
+        float occluderZ = viewZ(texture(gDepth, offset.xy).r, proj);
 
-        float rangeCheck = smoothstep(0.0f, 1.0f, ssaoRadius / abs(position.z - occluderPos.z));
+        float rangeCheck = smoothstep(0.0f, 1.0f, ssaoRadius / abs(position.z - occluderZ));
 
-        occlusion += ((occluderPos.z >= samp.z + eps) ? 1.0f : 0.0f) * rangeCheck;
+        occlusion += ((occluderZ >= samp.z + eps) ? 1.0f : 0.0f) * rangeCheck;
     }
 
-    occlusion = 1.0f - (occlusion / float(ssaoKernelSize));
+    occlusion = 1.0f - (occlusion / float(ssaoSamplesPerFrame));
 
     color = occlusion;
 }
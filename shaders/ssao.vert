@@ -8,6 +8,7 @@ layout (location = 0) out VOUT
 {
     vec2 uv;
     mat4 projection;
+    flat uint frame;
 } vOut;
 
 layout( push_constant ) uniform constants
@@ -16,6 +17,8 @@ layout( push_constant ) uniform constants
     mat4 dummy2;
     mat4 projection;
     vec3 dummy3;
+    float dummy4;
+    uint frame;
 } PushConstants;
 
 void main() 
@@ -27,5 +30,6 @@ void main()
     vOut.uv.y = (vOut.uv.y == 1.0f) ? 0.0f : 1.0f;
 
     vOut.projection = PushConstants.projection;
+    vOut.frame      = PushConstants.frame;
 }
 
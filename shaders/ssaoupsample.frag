@@ -0,0 +1,54 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D ssaoSampler;  // low resolution
+layout(set = 1, binding = 0) uniform sampler2D gDepth;       // full resolution
+layout(set = 2, binding = 0) uniform sampler2D lowResDepth;  // low resolution
+
+layout (location = 0) in VOUT
+{
+    vec2 uv;
+    mat4 projection;
+} vInput;
+
+layout (location = 0) out float color;
+
+const float depthSharpness = 8.0f; // the higher, the less ssao leaks over depth edges
+const float eps            = 0.0001f;
+
+// depth buffer value --> view space z
+float viewZ(float a_depth)
+{
+    return -vInput.projection[3][2] / (a_depth + vInput.projection[2][2]);
+}
+
+void main()
+{
+    ivec2 lowResDim = textureSize(ssaoSampler, 0);
+    float depth     = viewZ(texture(gDepth, vInput.uv).r);
+
+    // 4 nearest low resolution texels and their bilinear weights
+    vec2  coord = vInput.uv * vec2(lowResDim) - 0.5f;
+    ivec2 base  = ivec2(floor(coord));
+    vec2  f     = fract(coord);
+
+    vec4 bilinear = vec4((1.0f - f.x) * (1.0f - f.y), f.x * (1.0f - f.y), (1.0f - f.x) * f.y, f.x * f.y);
+    ivec2 offsets[4] = ivec2[](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(1, 1));
+
+    float occlusion = 0.0f;
+    float weightSum = 0.0f;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        ivec2 texel = clamp(base + offsets[i], ivec2(0), lowResDim - 1);
+
+        float lowResZ = viewZ(texelFetch(lowResDepth, texel, 0).r);
+        float weight  = bilinear[i] / (eps + depthSharpness * abs(depth - lowResZ));
+
+        occlusion += texelFetch(ssaoSampler, texel, 0).r * weight;
+        weightSum += weight;
+    }
+
+    color = occlusion / weightSum;
+}
@@ -0,0 +1,151 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D ssaoMap;     // this frame (white if ssao is disabled)
+layout(set = 1, binding = 0) uniform sampler2D gDepth;
+layout(set = 2, binding = 0) uniform sampler2D shadowAtlas; // distances to the light, a region for every face
+layout(set = 3, binding = 0) uniform sampler2D history;     // r = ao, g = shadow, b = view distance, a = accumulated frames
+
+// NOTE: SHADOW_FACES, SHADOW_LIGHTS and ShadowFaceData on cpu side
+#define SHADOW_FACES  6
+#define SHADOW_LIGHTS 5
+
+struct ShadowFace
+{
+    mat4 viewProjection;
+    vec4 region;   // xy = atlas uv of the top left corner, z = side in uv (0 = casts nothing)
+    vec4 lightPos;
+    vec4 forward;
+};
+
+layout(std430, set = 4, binding = 0) readonly buffer ShadowFaces
+{
+    ShadowFace faces[SHADOW_LIGHTS * SHADOW_FACES]; // the fire light first, its shadow is accumulated here
+} shadowFaces;
+
+layout (location = 0) in VOUT
+{
+    vec2 uv;
+    mat4 projection;
+    mat4 inverseView;
+    mat4 prevViewProjection;
+    flat uint frame;
+} vInput;
+
+layout (location = 0) out vec4 color;
+
+const float eps      = 0.15f;
+const float shadow   = 0.5f;
+
+// NOTE: TemporalConstants() on cpu side
+layout(constant_id = 0) const int   pcfTaps  = 4;     // per frame (out of 3x3x3 grid), the rest is gathered over the next frames
+layout(constant_id = 1) const float pcfDelta = 0.03f;
+
+const float maxHistory     = 12.0f;
+const float depthTolerance = 0.05f; // relative, history of a different surface is rejected
+
+// depth buffer value --> view space z (perspective projection)
+float viewZ(float a_depth, mat4 a_proj)
+{
+    return -a_proj[3][2] / (a_depth + a_proj[2][2]);
+}
+
+// interleaved gradient noise, shifted every frame
+float noise(vec2 a_pixel, uint a_frame)
+{
+    a_pixel += 5.588238f * float(a_frame % 64u);
+    return fract(52.9829189f * fract(dot(a_pixel, vec2(0.06711056f, 0.00583715f))));
+}
+
+// a_position is compared with the region of the face it falls into, as the face was last rendered
+// (faces are refreshed on different frames, each keeps the light position and matrices of its own render)
+bool inShadow(vec3 a_position)
+{
+    uint  face    = 0u;
+    float closest = -1.0f;
+
+    for (uint i = 0u; i < SHADOW_FACES; ++i)
+    {
+        vec3  toPosition = normalize(a_position - shadowFaces.faces[i].lightPos.xyz);
+        float alignment  = dot(toPosition, shadowFaces.faces[i].forward.xyz);
+
+        if (alignment > closest)
+        {
+            closest = alignment;
+            face    = i;
+        }
+    }
+
+    ShadowFace shadowFace = shadowFaces.faces[face];
+
+    if (shadowFace.region.z == 0.0f)
+    {
+        return false;
+    }
+
+    // viewports of the faces are flipped like the ones of the camera
+    vec4 clip = shadowFace.viewProjection * vec4(a_position, 1.0f);
+    vec2 uv   = vec2(clip.x, -clip.y) / clip.w * 0.5f + 0.5f;
+
+    // texels of the neighbouring regions are never read
+    vec2 halfTexel = 0.5f / vec2(textureSize(shadowAtlas, 0));
+    vec2 atlasUV   = shadowFace.region.xy + clamp(uv * shadowFace.region.z, halfTexel, shadowFace.region.zz - halfTexel);
+
+    return length(a_position - shadowFace.lightPos.xyz) > texture(shadowAtlas, atlasUV).r + eps;
+}
+
+// stratified subset of the 3x3x3 PCF grid, a different one for every pixel and frame
+float PCF(vec3 a_position, float a_noise)
+{
+    float sumShadow = 0.0f;
+
+    for (int i = 0; i < pcfTaps; ++i)
+    {
+        uint  index  = uint((float(i) + a_noise) * 27.0f / float(pcfTaps)) % 27u;
+        vec3  offset = vec3(index % 3u, (index / 3u) % 3u, index / 9u) - 1.0f;
+
+        sumShadow += (inShadow(a_position + pcfDelta * offset)) ? shadow : 1.0f;
+    }
+
+    return sumShadow / float(pcfTaps);
+}
+
+void main()
+{
+    float depth = texture(gDepth, vInput.uv).r;
+
+    if (depth == 1.0f)
+    {
+        // background is never lit, zero distance rejects it as history
+        color = vec4(1.0f, 1.0f, 0.0f, 0.0f);
+        return;
+    }
+
+    // a_proj is y flipped, so uv <--> ndc mapping is the same as in ssao.frag
+    mat4 proj = vInput.projection;
+    proj[1][1] *= -1;
+    proj[2][1] *= -1;
+
+    float z        = viewZ(depth, proj);
+    vec2  ndc      = vInput.uv * 2.0f - 1.0f;
+    vec3  position = vec3(-z * (ndc.x + proj[2][0]) / proj[0][0], -z * (ndc.y + proj[2][1]) / proj[1][1], z);
+    vec4  world    = vInput.inverseView * vec4(position, 1.0f);
+
+    vec2 current = vec2(texture(ssaoMap, vInput.uv).r, PCF(world.xyz, noise(gl_FragCoord.xy, vInput.frame)));
+
+    // reproject into the previous frame (y flipped the same way as proj)
+    vec4 prevClip = vInput.prevViewProjection * world;
+    prevClip.y    = -prevClip.y;
+    vec2 prevUV   = prevClip.xy / prevClip.w * 0.5f + 0.5f;
+
+    vec4 prev = texture(history, prevUV);
+
+    bool valid = (vInput.frame != 0u) &&
+        all(greaterThanEqual(prevUV, vec2(0.0f))) && all(lessThanEqual(prevUV, vec2(1.0f))) &&
+        abs(prev.b - prevClip.w) < depthTolerance * prevClip.w; // disocclusion
+
+    float frames = (valid) ? min(prev.a + 1.0f, maxHistory) : 1.0f;
+
+    color = vec4(mix(prev.rg, current, 1.0f / frames), -z, frames);
+}
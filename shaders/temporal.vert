@@ -0,0 +1,38 @@
+// created in 2021 by Andrey Treefonov https://github.com/Reefufui
+
+#version 450
+
+layout (location = 0) in  vec2 pos;
+
+layout (location = 0) out VOUT
+{
+    vec2 uv;
+    mat4 projection;
+    mat4 inverseView;
+    mat4 prevViewProjection;
+    flat uint frame;
+} vOut;
+
+layout( push_constant ) uniform constants
+{
+    mat4  prevViewProjection; // model is not used by fullscreen passes
+    mat4  view;
+    mat4  projection;
+    vec3  lightPos;
+    float dummy1;
+    uint  frame;
+} PushConstants;
+
+void main() 
+{
+    vec2 position = pos;
+    gl_Position = vec4(position, 0.0f, 1.0f);
+    
+    vOut.uv   = (vec2(1.0f) + pos) / 2.0f;
+    vOut.uv.y = (vOut.uv.y == 1.0f) ? 0.0f : 1.0f;
+
+    vOut.projection         = PushConstants.projection;
+    vOut.inverseView        = inverse(PushConstants.view);
+    vOut.prevViewProjection = PushConstants.prevViewProjection;
+    vOut.frame              = PushConstants.frame;
+}
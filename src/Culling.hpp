@@ -0,0 +1,260 @@
+#ifndef CULLING_HPP
+#define CULLING_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CULLING_SSE2
+#endif
+
+#include "Mesh.hpp" // for Bounds
+
+// world space boxes of a list of objects, tested against the frustum of an eye SIMD_WIDTH boxes at a time
+class FrustumCuller
+{
+    private:
+        static constexpr uint32_t SIMD_WIDTH = 4;
+
+        // structure of arrays padded to SIMD_WIDTH (results of padding boxes are never reported)
+        std::vector<float> m_centerX{};
+        std::vector<float> m_centerY{};
+        std::vector<float> m_centerZ{};
+        std::vector<float> m_extentX{};
+        std::vector<float> m_extentY{};
+        std::vector<float> m_extentZ{};
+        uint32_t           m_count{};
+
+        // planes point inside, normalized (Gribb & Hartmann)
+        // near plane is taken from the [-1..1] depth convention, which is conservative for [0..1] as well
+        static void extractPlanes(const glm::mat4& a_viewProjection, glm::vec4 a_planes[6])
+        {
+            glm::vec4 row0{ a_viewProjection[0][0], a_viewProjection[1][0], a_viewProjection[2][0], a_viewProjection[3][0] };
+            glm::vec4 row1{ a_viewProjection[0][1], a_viewProjection[1][1], a_viewProjection[2][1], a_viewProjection[3][1] };
+            glm::vec4 row2{ a_viewProjection[0][2], a_viewProjection[1][2], a_viewProjection[2][2], a_viewProjection[3][2] };
+            glm::vec4 row3{ a_viewProjection[0][3], a_viewProjection[1][3], a_viewProjection[2][3], a_viewProjection[3][3] };
+
+            a_planes[0] = row3 + row0;
+            a_planes[1] = row3 - row0;
+            a_planes[2] = row3 + row1;
+            a_planes[3] = row3 - row1;
+            a_planes[4] = row3 + row2;
+            a_planes[5] = row3 - row2;
+
+            for (uint32_t i{}; i < 6; ++i)
+            {
+                a_planes[i] /= glm::length(glm::vec3(a_planes[i]));
+            }
+        }
+
+    public:
+        void resize(uint32_t a_count)
+        {
+            m_count = a_count;
+
+            uint32_t paddedCount{ (a_count + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH };
+
+            for (auto* stream : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ })
+            {
+                stream->assign(paddedCount, 0.0f);
+            }
+        }
+
+        uint32_t getCount() const { return m_count; }
+
+        glm::vec3 getCenter(uint32_t a_index) const { return glm::vec3(m_centerX[a_index], m_centerY[a_index], m_centerZ[a_index]); }
+        glm::vec3 getExtent(uint32_t a_index) const { return glm::vec3(m_extentX[a_index], m_extentY[a_index], m_extentZ[a_index]); }
+
+        // object space box transformed by a_model --> world space box enclosing it
+        void setBox(uint32_t a_index, const Bounds& a_bounds, const glm::mat4& a_model)
+        {
+            glm::vec3 center{ a_model * glm::vec4(0.5f * (a_bounds.min + a_bounds.max), 1.0f) };
+            glm::vec3 halfSize{ 0.5f * (a_bounds.max - a_bounds.min) };
+
+            glm::vec3 extent{};
+            for (int column{}; column < 3; ++column)
+            {
+                extent += glm::abs(glm::vec3(a_model[column])) * halfSize[column];
+            }
+
+            m_centerX[a_index] = center.x;
+            m_centerY[a_index] = center.y;
+            m_centerZ[a_index] = center.z;
+            m_extentX[a_index] = extent.x;
+            m_extentY[a_index] = extent.y;
+            m_extentZ[a_index] = extent.z;
+        }
+
+        // a_visible[i] = 1 if box i is at least partially inside the frustum
+        void cull(const glm::mat4& a_viewProjection, std::vector<uint8_t>& a_visible) const
+        {
+            glm::vec4 planes[6]{};
+            extractPlanes(a_viewProjection, planes);
+
+            a_visible.resize(m_centerX.size());
+
+#ifdef CULLING_SSE2
+            for (size_t i{}; i < m_centerX.size(); i += SIMD_WIDTH)
+            {
+                __m128 cx{ _mm_loadu_ps(&m_centerX[i]) };
+                __m128 cy{ _mm_loadu_ps(&m_centerY[i]) };
+                __m128 cz{ _mm_loadu_ps(&m_centerZ[i]) };
+                __m128 ex{ _mm_loadu_ps(&m_extentX[i]) };
+                __m128 ey{ _mm_loadu_ps(&m_extentY[i]) };
+                __m128 ez{ _mm_loadu_ps(&m_extentZ[i]) };
+
+                __m128 outside{ _mm_setzero_ps() };
+
+                for (const auto& plane : planes)
+                {
+                    // signed distance of the box corner furthest along the plane normal
+                    __m128 distance{ _mm_set1_ps(plane.w) };
+                    distance = _mm_add_ps(distance, _mm_mul_ps(cx, _mm_set1_ps(plane.x)));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(cy, _mm_set1_ps(plane.y)));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(cz, _mm_set1_ps(plane.z)));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(ex, _mm_set1_ps(std::abs(plane.x))));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(ey, _mm_set1_ps(std::abs(plane.y))));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(ez, _mm_set1_ps(std::abs(plane.z))));
+
+                    outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+                }
+
+                int outsideMask{ _mm_movemask_ps(outside) };
+
+                for (uint32_t lane{}; lane < SIMD_WIDTH; ++lane)
+                {
+                    a_visible[i + lane] = ((outsideMask >> lane) & 1) ? 0 : 1;
+                }
+            }
+#else
+            for (size_t i{}; i < m_centerX.size(); ++i)
+            {
+                bool outside{};
+
+                for (const auto& plane : planes)
+                {
+                    float distance{ plane.w + m_centerX[i] * plane.x + m_centerY[i] * plane.y + m_centerZ[i] * plane.z
+                        + m_extentX[i] * std::abs(plane.x) + m_extentY[i] * std::abs(plane.y) + m_extentZ[i] * std::abs(plane.z) };
+
+                    outside = outside || distance < 0.0f;
+                }
+
+                a_visible[i] = (outside) ? 0 : 1;
+            }
+#endif
+
+            a_visible.resize(m_count);
+        }
+};
+
+// max depth pyramid built over tiles of a previous frame's depth buffer
+// a box is occluded when its nearest depth is behind the furthest depth of every tile its screen rectangle touches
+class HiZ
+{
+    private:
+        std::vector<std::vector<float>> m_levels{};
+        std::vector<glm::uvec2>         m_sizes{};
+        glm::mat4                       m_viewProjection{ 1.0f };
+
+        float texel(uint32_t a_level, uint32_t a_x, uint32_t a_y) const
+        {
+            const glm::uvec2& size{ m_sizes[a_level] };
+
+            return m_levels[a_level][std::min(a_y, size.y - 1) * size.x + std::min(a_x, size.x - 1)];
+        }
+
+    public:
+        bool empty() const { return m_levels.empty(); }
+
+        // a_tiles: a_width x a_height max depths, row 0 is the top of the screen
+        // a_viewProjection: camera of the frame the depth belongs to
+        void build(const float* a_tiles, uint32_t a_width, uint32_t a_height, const glm::mat4& a_viewProjection)
+        {
+            m_viewProjection = a_viewProjection;
+
+            m_sizes.assign(1, glm::uvec2(a_width, a_height));
+            m_levels.resize(1);
+            m_levels[0].assign(a_tiles, a_tiles + a_width * a_height);
+
+            while (m_sizes.back().x > 1 || m_sizes.back().y > 1)
+            {
+                uint32_t   level{ (uint32_t)m_sizes.size() };
+                glm::uvec2 size{ (m_sizes.back() + glm::uvec2(1)) / glm::uvec2(2) };
+
+                m_sizes.push_back(size);
+                m_levels.resize(level + 1);
+                m_levels[level].resize(size.x * size.y);
+
+                for (uint32_t y{}; y < size.y; ++y)
+                {
+                    for (uint32_t x{}; x < size.x; ++x)
+                    {
+                        m_levels[level][y * size.x + x] = std::max(
+                                std::max(texel(level - 1, 2 * x, 2 * y),     texel(level - 1, 2 * x + 1, 2 * y)),
+                                std::max(texel(level - 1, 2 * x, 2 * y + 1), texel(level - 1, 2 * x + 1, 2 * y + 1)));
+                    }
+                }
+            }
+        }
+
+        bool isOccluded(glm::vec3 a_center, glm::vec3 a_extent) const
+        {
+            if (empty())
+            {
+                return false;
+            }
+
+            glm::vec2 uvMin{ 1.0f };
+            glm::vec2 uvMax{ 0.0f };
+            float     nearestDepth{ 1.0f };
+
+            for (uint32_t corner{}; corner < 8; ++corner)
+            {
+                glm::vec3 sign{ (corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f };
+                glm::vec4 clip{ m_viewProjection * glm::vec4(a_center + sign * a_extent, 1.0f) };
+
+                // crosses the camera plane, rectangle is unbounded
+                if (clip.w <= 0.0f)
+                {
+                    return false;
+                }
+
+                glm::vec3 ndc{ glm::vec3(clip) / clip.w };
+                glm::vec2 uv{ 0.5f + 0.5f * ndc.x, 0.5f - 0.5f * ndc.y }; // viewport is flipped
+
+                uvMin        = glm::min(uvMin, uv);
+                uvMax        = glm::max(uvMax, uv);
+                nearestDepth = std::min(nearestDepth, ndc.z);
+            }
+
+            uvMin = glm::clamp(uvMin, glm::vec2(0.0f), glm::vec2(1.0f));
+            uvMax = glm::clamp(uvMax, glm::vec2(0.0f), glm::vec2(1.0f));
+
+            const glm::uvec2& size{ m_sizes[0] };
+            glm::uvec2 tileMin{ glm::min(glm::uvec2(uvMin * glm::vec2(size)), size - glm::uvec2(1)) };
+            glm::uvec2 tileMax{ glm::min(glm::uvec2(uvMax * glm::vec2(size)), size - glm::uvec2(1)) };
+
+            // coarsest level where the rectangle touches at most 2x2 texels
+            uint32_t level{};
+            while (level + 1 < m_levels.size()
+                    && ((tileMax.x >> level) - (tileMin.x >> level) > 1 || (tileMax.y >> level) - (tileMin.y >> level) > 1))
+            {
+                ++level;
+            }
+
+            glm::uvec2 texelMin{ tileMin.x >> level, tileMin.y >> level };
+            glm::uvec2 texelMax{ tileMax.x >> level, tileMax.y >> level };
+
+            float furthestDepth{ std::max(
+                    std::max(texel(level, texelMin.x, texelMin.y), texel(level, texelMax.x, texelMin.y)),
+                    std::max(texel(level, texelMin.x, texelMax.y), texel(level, texelMax.x, texelMax.y))) };
+
+            return nearestDepth > furthestDepth;
+        }
+};
+
+#endif // CULLING_HPP
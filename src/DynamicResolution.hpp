@@ -0,0 +1,51 @@
+#ifndef DYNAMIC_RESOLUTION_HPP
+#define DYNAMIC_RESOLUTION_HPP
+
+#include <algorithm>
+#include <cmath>
+
+// render scale of the camera passes (fraction of the width and height of their targets), steered by measured gpu frame
+// time so that frames fit into a budget; measurements are MAX_FRAMES_IN_FLIGHT frames old, so every one only moves the
+// scale a little way towards the one that would fit (integral control), which keeps it from oscillating
+class DynamicResolution
+{
+    private:
+        float m_budget{};      // milliseconds
+        float m_minScale{};
+        float m_scale{ 1.0f }; // unquantized
+
+        static constexpr float HEADROOM  = 0.9f;  // part of the budget the frames are steered to
+        static constexpr float GAIN      = 0.1f;  // exponent of the budget to time ratio applied per measurement
+        static constexpr float MAX_STEP  = 0.05f; // relative scale change per measurement
+        static constexpr float QUANTUM   = 1.0f / 64.0f;
+
+    public:
+        DynamicResolution(float a_budget, float a_minScale)
+            : m_budget{ a_budget }
+            , m_minScale{ a_minScale }
+        {
+        }
+
+        // quantized, so that small corrections do not change the rendered size every frame
+        float scale() const
+        {
+            return std::clamp(std::round(m_scale / QUANTUM) * QUANTUM, m_minScale, 1.0f);
+        }
+
+        // a_gpuTime: milliseconds the gpu spent on one frame
+        void update(float a_gpuTime)
+        {
+            if (a_gpuTime <= 0.0f)
+            {
+                return;
+            }
+
+            // pixels are the scale squared, gain is taken on them
+            float step{ std::pow(HEADROOM * m_budget / a_gpuTime, 0.5f * GAIN) };
+            step = std::clamp(step, 1.0f - MAX_STEP, 1.0f + MAX_STEP);
+
+            m_scale = std::clamp(m_scale * step, m_minScale, 1.0f);
+        }
+};
+
+#endif // DYNAMIC_RESOLUTION_HPP
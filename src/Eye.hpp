@@ -1,5 +1,6 @@
 // created in 2021 by Andrey Treefonov https://github.com/Reefufui
 
+#include <glm/vec2.hpp> // glm::vec2
 #include <glm/vec3.hpp> // glm::vec3
 #include <glm/vec4.hpp> // glm::vec4
 #include <glm/mat4x4.hpp> // glm::mat4
@@ -26,21 +27,64 @@
 #define FOV 70.0f
 #endif
 
-const int WIDTH     = 1280;
-const int HEIGHT    = 720;
-const int BLOOM_DIM = 200;
-const int CUBE_SIDE = 1000;
+#ifndef LIGHT_FAR
+#define LIGHT_FAR 1000.0f
+#endif
+
+// initial window size (targets of the camera passes follow the swapchain), particle point sizes are in pixels of this height
+const int WIDTH            = 1280;
+const int HEIGHT           = 720;
+const int BLOOM_MIP_LEVELS = 5; // level 0 is half of the screen resolution
 
 class Eye
 {
     private:
-        Timer* m_timer{};
+        Timer*    m_timer{};
+        glm::vec2 m_renderScale{ 1.0f };
+        glm::vec2 m_targetSize{ (float)WIDTH, (float)HEIGHT };
 
     public:
         virtual glm::vec3 position() = 0;
         virtual glm::mat4 view(uint32_t a_face) = 0;
         virtual glm::mat4 projection() = 0;
 
+        // passes of the eye render into the top left a_scale part (of the width and height) of their targets
+        // (dynamic resolution)
+        void setRenderScale(glm::vec2 a_scale)
+        {
+            m_renderScale = a_scale;
+        }
+
+        glm::vec2 getRenderScale() const
+        {
+            return m_renderScale;
+        }
+
+        // full size of the targets of the eye in pixels
+        void setTargetSize(glm::vec2 a_size)
+        {
+            m_targetSize = a_size;
+        }
+
+        glm::vec2 getTargetSize() const
+        {
+            return m_targetSize;
+        }
+
+        // projection() squeezed into the rendered part of the targets, for the gpu (culling keeps projection()):
+        // clip x of [-1..1] --> [-1..2s-1], y --> [1-2s..1] (viewports are flipped, so that is the top),
+        // (off-center, shaders reconstructing positions from uv and depth use [2][0] and [2][1] too)
+        glm::mat4 renderProjection()
+        {
+            glm::mat4 region{ 1.0f };
+            region[0][0] = m_renderScale.x;
+            region[1][1] = m_renderScale.y;
+            region[3][0] = m_renderScale.x - 1.0f;
+            region[3][1] = 1.0f - m_renderScale.y;
+
+            return region * projection();
+        }
+
         Eye(Timer* a_pTimer)
             : m_timer(a_pTimer)
         {
@@ -83,9 +127,13 @@ class Camera : public Eye
             return view;
         }
 
+        // the rendered part of the targets is stretched over the window, so it has the aspect of the window
         glm::mat4 projection()
         {
-            glm::mat4 projection = glm::perspective(glm::radians(FOV), (float)WIDTH / (float)HEIGHT, NEAR, FAR);
+            glm::vec2 size{ getTargetSize() * getRenderScale() };
+            float     aspect{ size.x / size.y };
+
+            glm::mat4 projection = glm::perspective(glm::radians(FOV), aspect, NEAR, FAR);
 
             return projection;
         }
@@ -147,7 +195,41 @@ class Light : public Eye
 
         glm::mat4 projection()
         {
-            glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, NEAR, (float)CUBE_SIDE);
+            glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, NEAR, LIGHT_FAR);
+
+            return projection;
+        }
+};
+
+// shadow casting point light of the clustered lighting, placed on the light every frame;
+// its faces reach as far as the light does
+class PointLightEye : public Light
+{
+    private:
+        glm::vec3 m_position{};
+        float     m_radius{ 1.0f };
+
+    public:
+
+        PointLightEye(Timer* a_pTimer)
+            : Light(a_pTimer)
+        {
+        }
+
+        void place(glm::vec3 a_position, float a_radius)
+        {
+            m_position = a_position;
+            m_radius   = a_radius;
+        }
+
+        glm::vec3 position()
+        {
+            return m_position;
+        }
+
+        glm::mat4 projection()
+        {
+            glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, NEAR, m_radius);
 
             return projection;
         }
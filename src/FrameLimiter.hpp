@@ -0,0 +1,44 @@
+#ifndef FRAME_LIMITER_HPP
+#define FRAME_LIMITER_HPP
+
+#include <chrono>
+#include <thread>
+
+// caps the frame rate by waiting before a frame starts; call it right before input is polled, so the wait is spent
+// before the input of the frame is read and not between reading it and presenting the frame
+class FrameLimiter
+{
+    private:
+        using clock_t = std::chrono::steady_clock;
+
+        clock_t::time_point m_next{};
+
+        // sleeping overshoots by up to a scheduler quantum, the last part of the wait is spent spinning
+        static constexpr std::chrono::microseconds SPIN{ 1000 };
+
+    public:
+        void wait(float a_fps)
+        {
+            auto period{ std::chrono::duration_cast<clock_t::duration>(std::chrono::duration<float>(1.0f / a_fps)) };
+            auto now{ clock_t::now() };
+
+            // frames that took longer than the period move the schedule instead of being caught up in a burst
+            if (m_next + period < now)
+            {
+                m_next = now;
+            }
+
+            if (m_next - now > SPIN)
+            {
+                std::this_thread::sleep_until(m_next - SPIN);
+            }
+            while (clock_t::now() < m_next)
+            {
+                std::this_thread::yield();
+            }
+
+            m_next += period;
+        }
+};
+
+#endif // FRAME_LIMITER_HPP
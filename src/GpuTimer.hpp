@@ -0,0 +1,166 @@
+#ifndef GPU_TIMER_HPP
+#define GPU_TIMER_HPP
+
+#include "vk_utils.h"
+
+#include <vector>
+#include <cstdint>
+
+// gpu time of whole command buffers: a pair of timestamps for every frame in flight, read back after the fence of
+// that frame has signaled (so results are always available and reading never stalls); spans inside the command buffer
+// (sections) get pairs of their own, the ones a frame recorded are summed
+class GpuTimer
+{
+    private:
+        VkDevice          m_device{};
+        VkQueryPool       m_pool{ VK_NULL_HANDLE };
+        float             m_period{};   // nanoseconds per tick
+        uint64_t          m_mask{};     // valid bits of the timestamps of the queue
+        uint32_t          m_sections{};
+        std::vector<bool> m_written{};  // frame has recorded both timestamps since it was last read
+        std::vector<uint32_t> m_sectionsWritten{}; // bit per section recorded by the frame since it was last read
+
+        uint32_t queries() const { return 2 + 2 * m_sections; } // of one frame
+
+        uint64_t elapsed(uint32_t a_query, bool& a_available) const
+        {
+            uint64_t ticks[2]{};
+            a_available = vkGetQueryPoolResults(m_device, m_pool, a_query, 2, sizeof(ticks), ticks, sizeof(uint64_t),
+                    VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+
+            return (ticks[1] - ticks[0]) & m_mask;
+        }
+
+    public:
+        // queues without timestamp support leave the timer disabled, read() never reports anything then
+        // a_sections: spans timed by beginSection() and endSection() (up to 32)
+        void create(VkDevice a_device, VkPhysicalDevice a_physDevice, uint32_t a_queueFamily, uint32_t a_frames, uint32_t a_sections = 0)
+        {
+            m_device   = a_device;
+            m_sections = a_sections;
+            m_written.assign(a_frames, false);
+            m_sectionsWritten.assign(a_frames, 0);
+
+            VkPhysicalDeviceProperties properties{};
+            vkGetPhysicalDeviceProperties(a_physDevice, &properties);
+
+            uint32_t familyCount{};
+            vkGetPhysicalDeviceQueueFamilyProperties(a_physDevice, &familyCount, nullptr);
+            std::vector<VkQueueFamilyProperties> families(familyCount);
+            vkGetPhysicalDeviceQueueFamilyProperties(a_physDevice, &familyCount, families.data());
+
+            uint32_t validBits{ (a_queueFamily < familyCount) ? families[a_queueFamily].timestampValidBits : 0 };
+            if (validBits == 0 || properties.limits.timestampPeriod == 0.0f)
+            {
+                return;
+            }
+
+            m_period = properties.limits.timestampPeriod;
+            m_mask   = (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1);
+
+            VkQueryPoolCreateInfo poolInfo{};
+            poolInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            poolInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+            poolInfo.queryCount = queries() * a_frames;
+
+            VK_CHECK_RESULT(vkCreateQueryPool(a_device, &poolInfo, nullptr, &m_pool));
+        }
+
+        bool enabled() const { return m_pool != VK_NULL_HANDLE; }
+
+        // first and last commands of the command buffer of a_frame
+        void begin(VkCommandBuffer a_cmdBuffer, uint32_t a_frame)
+        {
+            if (enabled())
+            {
+                vkCmdResetQueryPool(a_cmdBuffer, m_pool, queries() * a_frame, queries());
+                vkCmdWriteTimestamp(a_cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_pool, queries() * a_frame);
+            }
+        }
+
+        void end(VkCommandBuffer a_cmdBuffer, uint32_t a_frame)
+        {
+            if (enabled())
+            {
+                vkCmdWriteTimestamp(a_cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_pool, queries() * a_frame + 1);
+                m_written[a_frame] = true;
+            }
+        }
+
+        // in between begin() and end(), also inside render passes; both timestamps wait for the commands before them,
+        // so a section measures its own commands (as long as the gpu does not run ahead into them)
+        void beginSection(VkCommandBuffer a_cmdBuffer, uint32_t a_frame, uint32_t a_section)
+        {
+            if (enabled())
+            {
+                vkCmdWriteTimestamp(a_cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_pool, queries() * a_frame + 2 + 2 * a_section);
+            }
+        }
+
+        void endSection(VkCommandBuffer a_cmdBuffer, uint32_t a_frame, uint32_t a_section)
+        {
+            if (enabled())
+            {
+                vkCmdWriteTimestamp(a_cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_pool, queries() * a_frame + 3 + 2 * a_section);
+                m_sectionsWritten[a_frame] |= 1u << a_section;
+            }
+        }
+
+        // call once the fence of a_frame has signaled, false if a_frame has nothing new to report
+        bool read(uint32_t a_frame, float& a_milliseconds)
+        {
+            if (!enabled() || !m_written[a_frame])
+            {
+                return false;
+            }
+            m_written[a_frame] = false;
+
+            bool     available{};
+            uint64_t ticks{ elapsed(queries() * a_frame, available) };
+            if (!available)
+            {
+                return false;
+            }
+
+            a_milliseconds = (float)ticks * m_period / 1000000.0f;
+
+            return true;
+        }
+
+        // sum of the sections a_frame recorded, same rules as read()
+        bool readSections(uint32_t a_frame, float& a_milliseconds)
+        {
+            if (!enabled() || m_sectionsWritten[a_frame] == 0)
+            {
+                return false;
+            }
+
+            uint64_t ticks{};
+            for (uint32_t section{}; section < m_sections; ++section)
+            {
+                if (m_sectionsWritten[a_frame] & (1u << section))
+                {
+                    bool available{};
+                    ticks += elapsed(queries() * a_frame + 2 + 2 * section, available);
+                    if (!available)
+                    {
+                        m_sectionsWritten[a_frame] = 0;
+                        return false;
+                    }
+                }
+            }
+            m_sectionsWritten[a_frame] = 0;
+
+            a_milliseconds = (float)ticks * m_period / 1000000.0f;
+
+            return true;
+        }
+
+        void cleanup()
+        {
+            vkDestroyQueryPool(m_device, m_pool, nullptr);
+            m_pool = VK_NULL_HANDLE;
+        }
+};
+
+#endif // GPU_TIMER_HPP
@@ -0,0 +1,115 @@
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// fixed pool of worker threads with one shared queue
+// submit() jobs, then wait() (calling thread helps with the queue until every job is finished)
+class JobSystem
+{
+    private:
+        std::vector<std::thread>          m_workers{};
+        std::deque<std::function<void()>> m_jobs{};
+        std::mutex                        m_mutex{};
+        std::condition_variable           m_jobAdded{};
+        std::condition_variable           m_jobsDone{};
+        uint32_t                          m_unfinishedJobs{};
+        bool                              m_stop{};
+
+        // expects m_mutex to be locked, returns with it locked
+        void runJob(std::unique_lock<std::mutex>& a_lock)
+        {
+            std::function<void()> job{ std::move(m_jobs.front()) };
+            m_jobs.pop_front();
+
+            a_lock.unlock();
+            job();
+            a_lock.lock();
+
+            if (--m_unfinishedJobs == 0)
+            {
+                m_jobsDone.notify_all();
+            }
+        }
+
+        void workerLoop()
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+
+            while (true)
+            {
+                m_jobAdded.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+
+                if (m_stop)
+                {
+                    return;
+                }
+
+                runJob(lock);
+            }
+        }
+
+    public:
+        // calling thread is counted as a worker too
+        JobSystem(uint32_t a_threadCount = std::thread::hardware_concurrency())
+        {
+            uint32_t workerCount{ std::max(a_threadCount, 1u) - 1 };
+
+            for (uint32_t i{}; i < workerCount; ++i)
+            {
+                m_workers.emplace_back(&JobSystem::workerLoop, this);
+            }
+        }
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        ~JobSystem()
+        {
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                m_stop = true;
+            }
+
+            m_jobAdded.notify_all();
+
+            for (auto& worker : m_workers)
+            {
+                worker.join();
+            }
+        }
+
+        uint32_t getThreadCount() const { return (uint32_t)m_workers.size() + 1; };
+
+        void submit(std::function<void()> a_job)
+        {
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                m_jobs.push_back(std::move(a_job));
+                ++m_unfinishedJobs;
+            }
+
+            m_jobAdded.notify_one();
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+
+            while (!m_jobs.empty())
+            {
+                runJob(lock);
+            }
+
+            m_jobsDone.wait(lock, [this]() { return m_unfinishedJobs == 0; });
+        }
+};
+
+#endif // JOB_SYSTEM_HPP
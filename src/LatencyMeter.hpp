@@ -0,0 +1,146 @@
+#ifndef LATENCY_METER_HPP
+#define LATENCY_METER_HPP
+
+#include "vk_utils.h"
+
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// input to present latency: time from the input poll a frame was built from to the moment its image is presented;
+// with VK_KHR_present_wait the presentation is polled by present id, otherwise it is estimated on the cpu as the time
+// until the gpu finished the frame (its fence), which leaves out the queue of the presentation engine
+// (present ids and fences of every frame in flight are polled once per frame, so samples are late by at most the time
+// between two polls)
+class LatencyMeter
+{
+    private:
+        using clock_t = std::chrono::steady_clock;
+
+        struct Presented {
+            uint64_t            presentId;
+            clock_t::time_point input;
+        };
+
+        VkDevice                         m_device{};
+        PFN_vkWaitForPresentKHR          m_waitForPresent{};
+        clock_t::time_point              m_input{};       // poll the next frame is built from
+        std::vector<clock_t::time_point> m_frameInput{};  // input of the frame in flight of every slot
+        std::vector<VkFence>             m_frameFence{};  // slot has a submitted frame not measured yet (cpu estimate)
+        std::deque<Presented>            m_presented{};   // queued for presentation, not known to be on screen yet
+
+        float    m_sum{};
+        float    m_max{};
+        uint32_t m_count{};
+
+        void sample(clock_t::time_point a_input)
+        {
+            float ms{ std::chrono::duration<float, std::milli>(clock_t::now() - a_input).count() };
+
+            m_sum += ms;
+            m_max  = std::max(m_max, ms);
+            ++m_count;
+        }
+
+    public:
+        // a_presentWait: device was created with presentId and presentWait features enabled
+        void create(VkDevice a_device, bool a_presentWait, uint32_t a_frames)
+        {
+            m_device = a_device;
+            m_frameInput.assign(a_frames, clock_t::time_point{});
+            m_frameFence.assign(a_frames, VK_NULL_HANDLE);
+
+            if (a_presentWait)
+            {
+                m_waitForPresent = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(a_device, "vkWaitForPresentKHR");
+            }
+        }
+
+        bool presentWait() const { return m_waitForPresent != nullptr; }
+
+        // right after input is polled
+        void inputPolled() { m_input = clock_t::now(); }
+
+        // once the fence of a_frame has signaled and was polled, before it is reset
+        void frameRetired(uint32_t a_frame) { m_frameFence[a_frame] = VK_NULL_HANDLE; }
+
+        // a_presentId: chained into the present of the frame (ignored without present wait)
+        // a_fence: signaled when the gpu is done with the frame (ignored with present wait)
+        void frameQueued(uint32_t a_frame, uint64_t a_presentId, VkFence a_fence)
+        {
+            m_frameInput[a_frame] = m_input;
+
+            if (!presentWait())
+            {
+                m_frameFence[a_frame] = a_fence;
+            }
+
+            if (presentWait())
+            {
+                m_presented.push_back(Presented{ a_presentId, m_input });
+            }
+        }
+
+        // samples frames presented (or finished on the gpu) since the last poll, never blocks
+        void poll(VkSwapchainKHR a_swapChain)
+        {
+            for (size_t frame{ 0 }; frame < m_frameFence.size(); ++frame)
+            {
+                if (m_frameFence[frame] != VK_NULL_HANDLE && vkGetFenceStatus(m_device, m_frameFence[frame]) == VK_SUCCESS)
+                {
+                    sample(m_frameInput[frame]);
+                    m_frameFence[frame] = VK_NULL_HANDLE;
+                }
+            }
+
+            while (presentWait() && !m_presented.empty())
+            {
+                VkResult result{ m_waitForPresent(m_device, a_swapChain, m_presented.front().presentId, 0) };
+                if (result == VK_TIMEOUT)
+                {
+                    break;
+                }
+
+                // the swapchain is out of date or lost, its pending ids will never be reported
+                if (result != VK_SUCCESS)
+                {
+                    m_presented.clear();
+                    break;
+                }
+
+                sample(m_presented.front().input);
+                m_presented.pop_front();
+            }
+        }
+
+        // frames in flight are not measured: present ids belong to a replaced swapchain, or the device was idled and
+        // their samples would include the wait
+        void discard()
+        {
+            m_presented.clear();
+            m_frameFence.assign(m_frameFence.size(), VK_NULL_HANDLE);
+        }
+
+        // average and worst since the last report, false if nothing was measured
+        bool report(float& a_average, float& a_max, uint32_t& a_count)
+        {
+            if (m_count == 0)
+            {
+                return false;
+            }
+
+            a_average = m_sum / m_count;
+            a_max     = m_max;
+            a_count   = m_count;
+
+            m_sum   = 0.0f;
+            m_max   = 0.0f;
+            m_count = 0;
+
+            return true;
+        }
+};
+
+#endif // LATENCY_METER_HPP
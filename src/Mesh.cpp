@@ -9,6 +9,7 @@
 #include <vector>
 #include <unordered_map>
 #include <random>
+#include <algorithm>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
@@ -114,6 +115,34 @@ void Mesh::loadFromOBJ(const char* a_filename)
         bar.finish();
 #endif
     }
+
+    computeBounds();
+}
+
+void Mesh::computeBounds()
+{
+    bounds = Bounds{};
+
+    if (vertices.empty())
+    {
+        return;
+    }
+
+    bounds.min = vertices[0].position;
+    bounds.max = vertices[0].position;
+
+    for (const auto& vertex : vertices)
+    {
+        bounds.min = glm::min(bounds.min, vertex.position);
+        bounds.max = glm::max(bounds.max, vertex.position);
+    }
+
+    bounds.center = 0.5f * (bounds.min + bounds.max);
+
+    for (const auto& vertex : vertices)
+    {
+        bounds.radius = std::max(bounds.radius, glm::length(vertex.position - bounds.center));
+    }
 }
 
 void Mesh::cleanup()
@@ -48,6 +48,14 @@ struct Vertex {
 
 };
 
+// object space bounds of a mesh
+struct Bounds {
+    glm::vec3 min{};
+    glm::vec3 max{};
+    glm::vec3 center{}; // of the bounding sphere (center of the box)
+    float     radius{};
+};
+
 class Mesh {
     private:
         VkDevice m_device;
@@ -59,10 +67,13 @@ class Mesh {
 
         Buffer m_vbo{}, m_ibo{};
 
+        void computeBounds();
+
     public:
 
         std::vector<Vertex>   vertices{};
         std::vector<uint32_t> indices{};
+        Bounds                bounds{};
 
         Buffer& getVBO() { return m_vbo; }
         Buffer& getIBO() { return m_ibo; }
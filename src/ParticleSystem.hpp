@@ -7,8 +7,15 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <vector>
-#include <random>
 #include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARTICLES_SSE2
+#endif
 
 #include "Mesh.hpp" // for VertexInputDescription
 #include "Texture.hpp"
@@ -17,6 +24,7 @@
 class ParticleSystem
 {
     private:
+        // NOTE: matches std430 layout of particles.comp (hence the alignment of velocity)
         struct Particle
         {
             glm::vec4 position;
@@ -25,19 +33,66 @@ class ParticleSystem
             float     size;
             float     rotation;
 
-            glm::vec4 velocity;
+            alignas(16) glm::vec4 velocity;
             float     rotSpeed;
         };
 
-        std::vector<Particle>      m_particles{};
-        std::default_random_engine m_randomEngine{};
+        // cpu simulation state, structure of arrays padded to SIMD_WIDTH
+        // (velocity is always (0, y, 0) and color is always white, so they are not stored)
+        struct Streams
+        {
+            std::vector<float> positionX;
+            std::vector<float> positionY;
+            std::vector<float> positionZ;
+            std::vector<float> velocityY;
+            std::vector<float> alpha;
+            std::vector<float> size;
+            std::vector<float> rotation;
+            std::vector<float> rotSpeed;
+        };
+
+        static constexpr uint32_t SIMD_WIDTH = 4;
+        // particles are updated in chunks (independently, possibly on different threads), multiple of SIMD_WIDTH
+        static constexpr uint32_t CHUNK_SIZE = 16384;
 
-        VkBuffer       m_vbo;
-        VkDeviceMemory m_vboMem;
-        void*          m_mappedMemory;
-        size_t         m_vboSize;
+        // xorshift32 states, one set per chunk so that chunks do not share anything
+        struct Random
+        {
+            uint32_t respawn{ 1u };
+            uint32_t lanes[SIMD_WIDTH]{}; // one per simd lane of the update loop
+        };
+
+        Streams             m_streams{}; // empty if simulated on gpu
+        std::vector<Random> m_chunkRandom{};
+        uint32_t            m_seed{ 1u };
+
+        // cpu simulated: host visible ring with a region per frame in flight, the update writes only into m_writeRegion
+        // (whose frame fence has signaled), the gpu reads the region of the frame it draws
+        // gpu simulated: one device local region updated in place
+        static constexpr VkDeviceSize REGION_ALIGNMENT = 256;
+
+        VkBuffer        m_vbo;
+        VkDeviceMemory  m_vboMem;
+        void*           m_mappedMemory{};
+        size_t          m_vboSize; // of one region (live particles only)
+        uint32_t        m_writeRegion{};
+        VkDescriptorSet m_storageDS{}; // vbo as storage buffer (gpu simulation)
+
+        // gpu simulated only: live particles in the view frustum are compacted by particlescull.comp
+        // into m_visibleVBO and counted in m_indirectBuffer (VkDrawIndirectCommand)
+        VkBuffer        m_visibleVBO{};
+        VkDeviceMemory  m_visibleVBOMem{};
+        VkDescriptorSet m_visibleDS{};
+        VkBuffer        m_indirectBuffer{};
+        VkDeviceMemory  m_indirectBufferMem{};
+        VkDescriptorSet m_indirectDS{};
+
+        bool  m_simulatedOnGPU{};
+        float m_previousTime{};
+        float m_timeElapsed{};
 
         glm::vec3 m_emmiterPos{};
+        glm::vec3 m_lightColor = glm::vec3(1.0f, 0.85f, 0.7f);
         glm::vec3 m_minVelocity = glm::vec3(-0.3f, 0.2f, -0.3f);
         glm::vec3 m_maxVelocity = glm::vec3(0.3f, 4.0f, 0.3f);
 
@@ -47,30 +102,156 @@ class ParticleSystem
         InputTexture* m_pAttachedTexture{};
         Timer*        m_pTimer{};
 
-        float random(float a_range)
+        static uint32_t xorshift(uint32_t& a_state)
         {
-            std::uniform_real_distribution<float> randomDistribution(0.0f, a_range);
-            return randomDistribution(m_randomEngine);
+            a_state ^= a_state << 13;
+            a_state ^= a_state >> 17;
+            a_state ^= a_state << 5;
+            return a_state;
         }
 
-        glm::vec3 getRandomPosition()
+        // [0..a_range) from upper 24 bits
+        static float random(uint32_t& a_state, float a_range)
         {
-            float radius{ random(m_flameRadius) };
-            float phi{ random(glm::pi<float>()) - glm::pi<float>() / 2.0f };
-            float theta{ random(2.0f * glm::pi<float>()) };
+            return float(xorshift(a_state) >> 8) * (a_range / 16777216.0f);
+        }
+
+        glm::vec3 getRandomPosition(uint32_t& a_state)
+        {
+            float radius{ random(a_state, m_flameRadius) };
+            float phi{ random(a_state, glm::pi<float>()) - glm::pi<float>() / 2.0f };
+            float theta{ random(a_state, 2.0f * glm::pi<float>()) };
 
             return glm::vec3(radius * cos(theta) * cos(phi), radius * sin(phi), radius * sin(theta) * cos(phi));
         }
 
-        void createParticle(Particle& a_particle)
+        void createParticle(uint32_t a_index, uint32_t& a_state)
         {
-            a_particle.position = glm::vec4(m_emmiterPos + getRandomPosition(), 1.0f);
-            a_particle.color    = glm::vec4(1.0f);
-            a_particle.alpha    = random(0.40f);
-            a_particle.size     = 15.0f + random(30.0f);
-            a_particle.rotation = random(2.0f * glm::pi<float>());
-            a_particle.velocity = glm::vec4(0.0f, glm::max(random(m_maxVelocity.y), m_minVelocity.y), 0.0f, 0.0f);
-            a_particle.rotSpeed = random(glm::pi<float>()) - glm::pi<float>();
+            glm::vec3 position{ m_emmiterPos + getRandomPosition(a_state) };
+
+            m_streams.positionX[a_index] = position.x;
+            m_streams.positionY[a_index] = position.y;
+            m_streams.positionZ[a_index] = position.z;
+            m_streams.alpha[a_index]     = random(a_state, 0.40f);
+            m_streams.size[a_index]      = 15.0f + random(a_state, 30.0f);
+            m_streams.rotation[a_index]  = random(a_state, 2.0f * glm::pi<float>());
+            m_streams.velocityY[a_index] = glm::max(random(a_state, m_maxVelocity.y), m_minVelocity.y);
+            m_streams.rotSpeed[a_index]  = random(a_state, glm::pi<float>()) - glm::pi<float>();
+        }
+
+        // per chunk states are derived from the seed, xorshift state must not be zero
+        void seedChunks()
+        {
+            uint32_t state{ m_seed * 747796405u + 2891336453u };
+            state = (state == 0) ? 1u : state;
+
+            for (auto& chunk : m_chunkRandom)
+            {
+                chunk.respawn = xorshift(state);
+
+                for (auto& lane : chunk.lanes)
+                {
+                    lane = xorshift(state);
+                }
+            }
+        }
+
+#ifdef PARTICLES_SSE2
+        static __m128i xorshift(__m128i a_state)
+        {
+            a_state = _mm_xor_si128(a_state, _mm_slli_epi32(a_state, 13));
+            a_state = _mm_xor_si128(a_state, _mm_srli_epi32(a_state, 17));
+            a_state = _mm_xor_si128(a_state, _mm_slli_epi32(a_state, 5));
+            return a_state;
+        }
+
+        // upper 24 bits of each lane --> [0..2^24)
+        static __m128 toFloat(__m128i a_state)
+        {
+            return _mm_cvtepi32_ps(_mm_srli_epi32(a_state, 8));
+        }
+#endif
+
+        // [a_begin..a_end) is a multiple of SIMD_WIDTH
+        void integrate(uint32_t a_begin, uint32_t a_end, float a_timeElapsed, Random& a_random)
+        {
+            float* posY{ m_streams.positionY.data() };
+            float* velY{ m_streams.velocityY.data() };
+            float* alpha{ m_streams.alpha.data() };
+            float* size{ m_streams.size.data() };
+            float* rotation{ m_streams.rotation.data() };
+            float* rotSpeed{ m_streams.rotSpeed.data() };
+
+#ifdef PARTICLES_SSE2
+            const __m128 halfTime  = _mm_set1_ps(a_timeElapsed * 0.5f);
+            const __m128 time      = _mm_set1_ps(a_timeElapsed);
+            const __m128 alphaRate = _mm_set1_ps(a_timeElapsed * 5.5f / 16777216.0f);
+            const __m128 sizeRate  = _mm_set1_ps(a_timeElapsed * 10.0f / 16777216.0f);
+            const __m128 dead      = _mm_set1_ps(2.0f);
+
+            __m128i state = _mm_loadu_si128(reinterpret_cast<__m128i*>(a_random.lanes));
+
+            for (uint32_t i{ a_begin }; i < a_end; i += SIMD_WIDTH)
+            {
+                _mm_storeu_ps(posY + i, _mm_add_ps(_mm_loadu_ps(posY + i), _mm_mul_ps(_mm_loadu_ps(velY + i), halfTime)));
+
+                state = xorshift(state);
+                __m128 a = _mm_add_ps(_mm_loadu_ps(alpha + i), _mm_mul_ps(toFloat(state), alphaRate));
+                _mm_storeu_ps(alpha + i, a);
+
+                state = xorshift(state);
+                _mm_storeu_ps(size + i, _mm_sub_ps(_mm_loadu_ps(size + i), _mm_mul_ps(toFloat(state), sizeRate)));
+
+                _mm_storeu_ps(rotation + i, _mm_add_ps(_mm_loadu_ps(rotation + i), _mm_mul_ps(_mm_loadu_ps(rotSpeed + i), time)));
+
+                // respawns are rare (a few percent of particles per frame), so they stay scalar
+                int deadLanes{ _mm_movemask_ps(_mm_cmpgt_ps(a, dead)) };
+                for (uint32_t lane{}; deadLanes != 0; ++lane, deadLanes >>= 1)
+                {
+                    if (deadLanes & 1)
+                    {
+                        createParticle(i + lane, a_random.respawn);
+                    }
+                }
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(a_random.lanes), state);
+#else
+            for (uint32_t i{ a_begin }; i < a_end; ++i)
+            {
+                uint32_t& state{ a_random.lanes[i % SIMD_WIDTH] };
+
+                posY[i]     += velY[i] * a_timeElapsed * 0.5f;
+                alpha[i]    += a_timeElapsed * float(xorshift(state) >> 8) * (5.5f / 16777216.0f);
+                size[i]     -= a_timeElapsed * float(xorshift(state) >> 8) * (10.0f / 16777216.0f);
+                rotation[i] += rotSpeed[i] * a_timeElapsed;
+
+                if (alpha[i] > 2.0f)
+                {
+                    createParticle(i, a_random.respawn);
+                }
+            }
+#endif
+        }
+
+        // whole vertices are written in order, so write combined (host visible) memory gets full lines
+        void writeVertices(uint32_t a_begin, uint32_t a_end)
+        {
+            Particle* vertices{ reinterpret_cast<Particle*>(static_cast<char*>(m_mappedMemory) + getVertexOffset(m_writeRegion)) };
+
+            for (uint32_t i{ a_begin }; i < a_end; ++i)
+            {
+                Particle vertex;
+                vertex.position = glm::vec4(m_streams.positionX[i], m_streams.positionY[i], m_streams.positionZ[i], 1.0f);
+                vertex.color    = glm::vec4(1.0f);
+                vertex.alpha    = m_streams.alpha[i];
+                vertex.size     = m_streams.size[i];
+                vertex.rotation = m_streams.rotation[i];
+                vertex.velocity = glm::vec4(0.0f, m_streams.velocityY[i], 0.0f, 0.0f);
+                vertex.rotSpeed = m_streams.rotSpeed[i];
+
+                vertices[i] = vertex;
+            }
         }
 
     public:
@@ -79,58 +260,126 @@ class ParticleSystem
         {
             m_pTimer = a_timer;
             m_pTimer->timeStamp();
-            m_randomEngine.seed(m_pTimer->getTime());
+
+            m_seed = uint32_t(m_pTimer->getTime() * 1000000.0f);
+            seedChunks();
         }
 
         VkBuffer&       getVBO() { return m_vbo; };
         VkDeviceMemory& getVBOMemory() { return m_vboMem; };
         size_t          getSize() const { return m_vboSize; };
+        VkDeviceSize    getRegionSize() const { return (m_vboSize + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT; };
+        VkDeviceSize    getVertexOffset(uint32_t a_region) const { return m_simulatedOnGPU ? 0 : a_region * getRegionSize(); };
         uint32_t        getParticleCount() const { return m_parcticleCount; };
+        uint32_t        getChunkCount() const { return (uint32_t)m_chunkRandom.size(); };
         auto&           getMappedMemory() { return m_mappedMemory; };
         auto&           getTexture() { return m_pAttachedTexture; };
+        VkDescriptorSet& getStorageDescriptorSet() { return m_storageDS; };
+        VkBuffer&       getVisibleVBO() { return m_visibleVBO; };
+        VkDeviceMemory& getVisibleVBOMemory() { return m_visibleVBOMem; };
+        VkDescriptorSet& getVisibleDescriptorSet() { return m_visibleDS; };
+        VkBuffer&       getIndirectBuffer() { return m_indirectBuffer; };
+        VkDeviceMemory& getIndirectBufferMemory() { return m_indirectBufferMem; };
+        VkDescriptorSet& getIndirectDescriptorSet() { return m_indirectDS; };
+        bool            isSimulatedOnGPU() const { return m_simulatedOnGPU; };
+        glm::vec3       getEmmiterPos() const { return m_emmiterPos; };
+        float           getTimeElapsed() const { return m_timeElapsed; };
+
+        // emitter is a point light: a few incommensurate sines over the system clock, cheap and frame rate independent
+        glm::vec3 getLightColor() const
+        {
+            float flicker{ 0.85f + 0.1f * std::sin(13.0f * m_previousTime) + 0.05f * std::sin(31.0f * m_previousTime + 1.3f) };
+            return m_lightColor * flicker;
+        }
 
         void attachTexture(InputTexture* a_pInputTexture)
         {
             m_pAttachedTexture = a_pInputTexture;
         }
 
-        void initParticles(glm::vec3 a_emmiterPos, uint32_t a_count)
+        // on gpu particles are spawned and updated by particles.comp, nothing is kept on cpu side
+        void initParticles(glm::vec3 a_emmiterPos, uint32_t a_count, bool a_simulatedOnGPU = false)
         {
             m_parcticleCount = a_count;
             m_emmiterPos     = a_emmiterPos + glm::vec3(0.0f, m_flameRadius / 3.0f, 0.0f);
             m_vboSize        = a_count * sizeof(Particle);
+            m_simulatedOnGPU = a_simulatedOnGPU;
+
+            if (m_simulatedOnGPU)
+            {
+                return;
+            }
+
+            // padding particles are simulated, but never drawn
+            uint32_t paddedCount{ (a_count + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH };
 
-            m_particles.resize(a_count);
+            for (auto* stream : { &m_streams.positionX, &m_streams.positionY, &m_streams.positionZ, &m_streams.velocityY,
+                    &m_streams.alpha, &m_streams.size, &m_streams.rotation, &m_streams.rotSpeed })
+            {
+                stream->resize(paddedCount);
+            }
+
+            m_chunkRandom.resize((paddedCount + CHUNK_SIZE - 1) / CHUNK_SIZE);
+            seedChunks();
 
-            for (auto& particle : m_particles)
+            for (uint32_t i{}; i < paddedCount; ++i)
             {
-                createParticle(particle);
+                createParticle(i, m_chunkRandom[i / CHUNK_SIZE].respawn);
             }
         }
 
-        void updateParticles(glm::vec3 a_emmiterPos)
+        // region of the ring written by the following updates, must not be in use by the gpu
+        void setWriteRegion(uint32_t a_region)
+        {
+            m_writeRegion = a_region;
+        }
+
+        // every system has its own clock, so systems created (or updated) at different times do not interfere
+        void beginUpdate(glm::vec3 a_emmiterPos)
         {
-            m_emmiterPos = a_emmiterPos + glm::vec3(0.0f, m_flameRadius / 3.0f, 0.0f);
+            float timeElapsed = m_pTimer->getTime() - m_previousTime;
+            m_previousTime += timeElapsed;
 
-            static float previousTime{};
-            float timeElapsed = m_pTimer->getTime() - previousTime;
+            beginUpdate(a_emmiterPos, timeElapsed);
+        }
 
-            for (auto& particle : m_particles)
-            {
-                particle.position += particle.velocity * timeElapsed * 0.5f;
-                particle.alpha += timeElapsed * random(5.5f);
-                particle.size  -= timeElapsed * random(10.0f);
-                particle.rotation += particle.rotSpeed * timeElapsed;
+        // fixed time step (used by particles benchmark)
+        void beginUpdate(glm::vec3 a_emmiterPos, float a_timeElapsed)
+        {
+            m_emmiterPos  = a_emmiterPos + glm::vec3(0.0f, m_flameRadius / 3.0f, 0.0f);
+            m_timeElapsed = a_timeElapsed;
+        }
 
-                if (particle.alpha > 2.0f)
-                {
-                    createParticle(particle);
-                }
+        // after beginUpdate, different chunks may be updated concurrently:
+        // each one owns its particles, random states and region of the mapped vbo
+        void updateChunk(uint32_t a_chunk)
+        {
+            uint32_t begin{ a_chunk * CHUNK_SIZE };
+            uint32_t end{ std::min(begin + CHUNK_SIZE, (uint32_t)m_streams.alpha.size()) };
+
+            integrate(begin, end, m_timeElapsed, m_chunkRandom[a_chunk]);
+            writeVertices(begin, std::min(end, m_parcticleCount));
+        }
+
+        // single threaded update
+        void updateParticles(glm::vec3 a_emmiterPos)
+        {
+            beginUpdate(a_emmiterPos);
+
+            for (uint32_t chunk{}; chunk < getChunkCount(); ++chunk)
+            {
+                updateChunk(chunk);
             }
+        }
 
-            previousTime += timeElapsed;
+        void updateParticles(glm::vec3 a_emmiterPos, float a_timeElapsed)
+        {
+            beginUpdate(a_emmiterPos, a_timeElapsed);
 
-            memcpy(m_mappedMemory, m_particles.data(), m_vboSize);
+            for (uint32_t chunk{}; chunk < getChunkCount(); ++chunk)
+            {
+                updateChunk(chunk);
+            }
         }
 
         static VertexInputDescription getVertexDescription()
@@ -163,7 +412,12 @@ class ParticleSystem
         {
             vkFreeMemory(a_device, m_vboMem, nullptr);
             vkDestroyBuffer(a_device, m_vbo, nullptr);
-            m_particles = std::vector<Particle>(0);
+            vkFreeMemory(a_device, m_visibleVBOMem, nullptr);
+            vkDestroyBuffer(a_device, m_visibleVBO, nullptr);
+            vkFreeMemory(a_device, m_indirectBufferMem, nullptr);
+            vkDestroyBuffer(a_device, m_indirectBuffer, nullptr);
+            m_streams     = Streams{};
+            m_chunkRandom = std::vector<Random>(0);
         }
 };
 
@@ -0,0 +1,450 @@
+#ifndef PIPELINE_CACHE_HPP
+#define PIPELINE_CACHE_HPP
+
+#include "vk_utils.h"
+#include "JobSystem.hpp"
+#include "ShaderManager.hpp"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+// VkPipelineCache backed by a file: loaded at startup when it was written for the same device and driver,
+// saved back at shutdown
+class PipelineCache
+{
+    private:
+        VkDevice        m_device{};
+        VkPipelineCache m_cache{ VK_NULL_HANDLE };
+        std::string     m_path{};
+
+        // header the driver writes in front of the data: size, version, vendor id, device id, pipeline cache uuid
+        static bool isCompatible(const std::vector<char>& a_data, const VkPhysicalDeviceProperties& a_properties)
+        {
+            const size_t headerSize{ 4 * sizeof(uint32_t) + VK_UUID_SIZE };
+
+            if (a_data.size() < headerSize)
+            {
+                return false;
+            }
+
+            uint32_t fields[4]{};
+            std::memcpy(fields, a_data.data(), sizeof(fields));
+
+            return fields[0] >= headerSize
+                && fields[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+                && fields[2] == a_properties.vendorID
+                && fields[3] == a_properties.deviceID
+                && std::memcmp(a_data.data() + sizeof(fields), a_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+
+    public:
+        VkPipelineCache get() const { return m_cache; }
+
+        // missing, stale (other device or driver) or corrupted files leave the cache empty
+        void load(VkDevice a_device, VkPhysicalDevice a_physDevice, const std::string& a_path)
+        {
+            m_device = a_device;
+            m_path   = a_path;
+
+            VkPhysicalDeviceProperties properties{};
+            vkGetPhysicalDeviceProperties(a_physDevice, &properties);
+
+            std::vector<char> data{};
+            std::ifstream     file{ a_path, std::ios::binary };
+            if (file)
+            {
+                data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            }
+
+            if (!data.empty() && !isCompatible(data, properties))
+            {
+                std::cout << "\t" << a_path << " was written by another device or driver, starting with an empty pipeline cache\n";
+                data.clear();
+            }
+
+            VkPipelineCacheCreateInfo cacheInfo{};
+            cacheInfo.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+            cacheInfo.initialDataSize = data.size();
+            cacheInfo.pInitialData    = (data.empty()) ? nullptr : data.data();
+
+            VK_CHECK_RESULT(vkCreatePipelineCache(a_device, &cacheInfo, nullptr, &m_cache));
+
+            if (!data.empty())
+            {
+                std::cout << "\tpipeline cache: " << data.size() / 1024 << " KiB loaded from " << a_path << "\n";
+            }
+        }
+
+        void save() const
+        {
+            size_t size{};
+            VK_CHECK_RESULT(vkGetPipelineCacheData(m_device, m_cache, &size, nullptr));
+
+            std::vector<char> data(size);
+            VK_CHECK_RESULT(vkGetPipelineCacheData(m_device, m_cache, &size, data.data()));
+
+            std::ofstream file{ m_path, std::ios::binary | std::ios::trunc };
+            if (!file.write(data.data(), size))
+            {
+                std::cout << "[PipelineCache::save]: failed to write " << m_path << "\n";
+            }
+        }
+
+        void cleanup()
+        {
+            vkDestroyPipelineCache(m_device, m_cache, nullptr);
+            m_cache = VK_NULL_HANDLE;
+        }
+};
+
+// create infos are copied together with everything they point to when added, so the caller is free to change its state
+// for the next pipeline; create() then builds the added ones on the threads of a job system and destroys their shader modules
+// create infos are kept along with the shader source of every stage, rebuild() recreates the pipelines of changed sources
+// NOTE: pNext chains, tessellation state and sample masks are not copied
+class PipelineBatch
+{
+    public:
+        struct Created {
+            std::string      name;
+            VkPipeline       pipeline;
+            VkPipelineLayout pipelineLayout;
+        };
+
+    private:
+        struct Stage {
+            std::string                           source; // file name known to the ShaderManager
+            VkPipelineShaderStageCreateInfo       info;
+            VkSpecializationInfo                  specialization;
+            std::vector<VkSpecializationMapEntry> entries;
+            std::vector<uint8_t>                  data;
+        };
+
+        // heap allocated, create infos point into their own entry
+        struct Entry {
+            std::string                                  name;
+            bool                                         compute;
+            bool                                         created;
+            VkPipeline                                   pipeline;
+            VkResult                                     result;
+            std::vector<Stage>                           stages;
+            std::vector<VkPipelineShaderStageCreateInfo> stageInfos;
+
+            std::vector<VkVertexInputBindingDescription>     bindings;
+            std::vector<VkVertexInputAttributeDescription>   attributes;
+            std::vector<VkViewport>                          viewports;
+            std::vector<VkRect2D>                            scissors;
+            std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+            std::vector<VkDynamicState>                      dynamicStates;
+
+            VkPipelineVertexInputStateCreateInfo   vertexInput;
+            VkPipelineInputAssemblyStateCreateInfo inputAssembly;
+            VkPipelineViewportStateCreateInfo      viewportState;
+            VkPipelineRasterizationStateCreateInfo rasterizer;
+            VkPipelineMultisampleStateCreateInfo   multisampling;
+            VkPipelineDepthStencilStateCreateInfo  depthStencil;
+            VkPipelineColorBlendStateCreateInfo    colorBlending;
+            VkPipelineDynamicStateCreateInfo       dynamicState;
+
+            VkGraphicsPipelineCreateInfo graphicsInfo;
+            VkComputePipelineCreateInfo  computeInfo;
+        };
+
+        std::vector<std::unique_ptr<Entry>> m_entries{};
+
+        template <typename T>
+        static std::vector<T> copyArray(const T* a_data, uint32_t a_count)
+        {
+            return (a_data && a_count) ? std::vector<T>(a_data, a_data + a_count) : std::vector<T>{};
+        }
+
+        template <typename T>
+        static const T* copyOptional(const T* a_source, T& a_copy)
+        {
+            if (!a_source)
+            {
+                return nullptr;
+            }
+
+            a_copy       = *a_source;
+            a_copy.pNext = nullptr;
+
+            return &a_copy;
+        }
+
+        // create infos refer to the modules of their stages
+        static void setModules(Entry& a_entry, const std::vector<VkShaderModule>& a_modules)
+        {
+            for (size_t i{}; i < a_entry.stages.size(); ++i)
+            {
+                a_entry.stages[i].info.module = a_modules[i];
+            }
+
+            if (a_entry.compute)
+            {
+                a_entry.computeInfo.stage = a_entry.stages[0].info;
+            }
+            else
+            {
+                for (size_t i{}; i < a_entry.stages.size(); ++i)
+                {
+                    a_entry.stageInfos[i] = a_entry.stages[i].info;
+                }
+            }
+        }
+
+        // pipeline caches are internally synchronized, so every job may use the same one
+        static void build(VkDevice a_device, VkPipelineCache a_cache, JobSystem& a_jobSystem, const std::vector<Entry*>& a_entries)
+        {
+            for (Entry* e : a_entries)
+            {
+                a_jobSystem.submit([a_device, a_cache, e]()
+                {
+                    e->result = (e->compute) ? vkCreateComputePipelines(a_device, a_cache, 1, &e->computeInfo, nullptr, &e->pipeline)
+                                             : vkCreateGraphicsPipelines(a_device, a_cache, 1, &e->graphicsInfo, nullptr, &e->pipeline);
+                });
+            }
+
+            a_jobSystem.wait();
+
+            for (Entry* e : a_entries)
+            {
+                for (auto& stage : e->stages)
+                {
+                    vkDestroyShaderModule(a_device, stage.info.module, nullptr);
+                }
+
+                setModules(*e, std::vector<VkShaderModule>(e->stages.size(), VK_NULL_HANDLE));
+            }
+        }
+
+        // a_stage has to stay where it is (info points to the specialization of its own stage)
+        static void copyStage(const VkPipelineShaderStageCreateInfo& a_source, Stage& a_stage)
+        {
+            a_stage.info       = a_source;
+            a_stage.info.pNext = nullptr;
+
+            if (a_source.pSpecializationInfo)
+            {
+                const VkSpecializationInfo& source{ *a_source.pSpecializationInfo };
+                const uint8_t*              data{ (const uint8_t*)source.pData };
+
+                a_stage.entries = copyArray(source.pMapEntries, source.mapEntryCount);
+                a_stage.data.assign(data, data + source.dataSize);
+
+                a_stage.specialization             = source;
+                a_stage.specialization.pMapEntries = a_stage.entries.data();
+                a_stage.specialization.pData       = a_stage.data.data();
+                a_stage.info.pSpecializationInfo   = &a_stage.specialization;
+            }
+        }
+
+    public:
+        bool contains(const std::string& a_name) const
+        {
+            return std::any_of(m_entries.begin(), m_entries.end(), [&](const auto& a_entry) { return a_entry->name == a_name; });
+        }
+
+        // a_sources: shader file of every stage, in the order of a_info.pStages
+        void addGraphics(const std::string& a_name, const VkGraphicsPipelineCreateInfo& a_info, const std::vector<std::string>& a_sources)
+        {
+            auto  entry{ std::make_unique<Entry>() };
+            Entry& e{ *entry };
+
+            e.name    = a_name;
+            e.compute = false;
+
+            e.stages.resize(a_info.stageCount);
+            for (uint32_t i{}; i < a_info.stageCount; ++i)
+            {
+                copyStage(a_info.pStages[i], e.stages[i]);
+                e.stages[i].source = a_sources.at(i);
+                e.stageInfos.push_back(e.stages[i].info);
+            }
+
+            e.graphicsInfo                    = a_info;
+            e.graphicsInfo.pNext              = nullptr;
+            e.graphicsInfo.pStages            = e.stageInfos.data();
+            e.graphicsInfo.pTessellationState = nullptr;
+
+            e.graphicsInfo.pVertexInputState = copyOptional(a_info.pVertexInputState, e.vertexInput);
+            if (a_info.pVertexInputState)
+            {
+                e.bindings   = copyArray(e.vertexInput.pVertexBindingDescriptions, e.vertexInput.vertexBindingDescriptionCount);
+                e.attributes = copyArray(e.vertexInput.pVertexAttributeDescriptions, e.vertexInput.vertexAttributeDescriptionCount);
+                e.vertexInput.pVertexBindingDescriptions   = e.bindings.data();
+                e.vertexInput.pVertexAttributeDescriptions = e.attributes.data();
+            }
+
+            e.graphicsInfo.pInputAssemblyState = copyOptional(a_info.pInputAssemblyState, e.inputAssembly);
+
+            e.graphicsInfo.pViewportState = copyOptional(a_info.pViewportState, e.viewportState);
+            if (a_info.pViewportState)
+            {
+                e.viewports = copyArray(e.viewportState.pViewports, e.viewportState.viewportCount);
+                e.scissors  = copyArray(e.viewportState.pScissors, e.viewportState.scissorCount);
+                e.viewportState.pViewports = (e.viewports.empty()) ? nullptr : e.viewports.data();
+                e.viewportState.pScissors  = (e.scissors.empty()) ? nullptr : e.scissors.data();
+            }
+
+            e.graphicsInfo.pRasterizationState = copyOptional(a_info.pRasterizationState, e.rasterizer);
+            e.graphicsInfo.pMultisampleState   = copyOptional(a_info.pMultisampleState, e.multisampling);
+            if (a_info.pMultisampleState)
+            {
+                e.multisampling.pSampleMask = nullptr;
+            }
+
+            e.graphicsInfo.pDepthStencilState = copyOptional(a_info.pDepthStencilState, e.depthStencil);
+
+            e.graphicsInfo.pColorBlendState = copyOptional(a_info.pColorBlendState, e.colorBlending);
+            if (a_info.pColorBlendState)
+            {
+                e.blendAttachments = copyArray(e.colorBlending.pAttachments, e.colorBlending.attachmentCount);
+                e.colorBlending.pAttachments = e.blendAttachments.data();
+            }
+
+            e.graphicsInfo.pDynamicState = copyOptional(a_info.pDynamicState, e.dynamicState);
+            if (a_info.pDynamicState)
+            {
+                e.dynamicStates = copyArray(e.dynamicState.pDynamicStates, e.dynamicState.dynamicStateCount);
+                e.dynamicState.pDynamicStates = e.dynamicStates.data();
+            }
+
+            m_entries.push_back(std::move(entry));
+        }
+
+        void addCompute(const std::string& a_name, const VkComputePipelineCreateInfo& a_info, const std::string& a_source)
+        {
+            auto  entry{ std::make_unique<Entry>() };
+            Entry& e{ *entry };
+
+            e.name    = a_name;
+            e.compute = true;
+
+            e.stages.resize(1);
+            copyStage(a_info.stage, e.stages[0]);
+            e.stages[0].source = a_source;
+
+            e.computeInfo       = a_info;
+            e.computeInfo.pNext = nullptr;
+            e.computeInfo.stage = e.stages[0].info;
+
+            m_entries.push_back(std::move(entry));
+        }
+
+        // pipelines added since the last call
+        std::vector<Created> create(VkDevice a_device, VkPipelineCache a_cache, JobSystem& a_jobSystem)
+        {
+            std::vector<Entry*> added{};
+            for (auto& entry : m_entries)
+            {
+                if (!entry->created)
+                {
+                    added.push_back(entry.get());
+                }
+            }
+
+            build(a_device, a_cache, a_jobSystem, added);
+
+            std::vector<Created> created{};
+            std::string          failed{};
+
+            for (Entry* e : added)
+            {
+                e->created = true;
+
+                if (e->result != VK_SUCCESS)
+                {
+                    failed += " " + e->name;
+                    continue;
+                }
+
+                VkPipelineLayout layout{ (e->compute) ? e->computeInfo.layout : e->graphicsInfo.layout };
+                created.push_back(Created{ e->name, e->pipeline, layout });
+            }
+
+            if (!failed.empty())
+            {
+                throw std::runtime_error("[PipelineBatch::create]: failed to create pipelines:" + failed);
+            }
+
+            return created;
+        }
+
+        // new pipelines of the ones that use any of a_changedSources, old ones are left to the caller to replace and destroy
+        // pipelines whose shaders fail to compile (or that fail to build) are skipped, the caller keeps the old ones
+        std::vector<Created> rebuild(VkDevice a_device, VkPipelineCache a_cache, JobSystem& a_jobSystem, ShaderManager& a_shaders,
+                const std::vector<std::string>& a_changedSources)
+        {
+            std::vector<Entry*> affected{};
+
+            for (auto& entry : m_entries)
+            {
+                bool changed{};
+                for (const auto& stage : entry->stages)
+                {
+                    changed = changed || std::find(a_changedSources.begin(), a_changedSources.end(), stage.source) != a_changedSources.end();
+                }
+
+                if (!entry->created || !changed)
+                {
+                    continue;
+                }
+
+                // every stage is loaded (even after a failed one), so all of them are up to date with their files
+                std::vector<VkShaderModule> modules{};
+                bool                        compiled{ true };
+                for (const auto& stage : entry->stages)
+                {
+                    std::vector<uint32_t> code{ a_shaders.tryLoad(stage.source) };
+                    if (code.empty())
+                    {
+                        std::cout << "[PipelineBatch::rebuild]: " << stage.source << " does not compile, keeping " << entry->name << "\n";
+                        compiled = false;
+                        continue;
+                    }
+
+                    modules.push_back(vk_utils::CreateShaderModule(a_device, code));
+                }
+
+                if (!compiled)
+                {
+                    for (auto module : modules)
+                    {
+                        vkDestroyShaderModule(a_device, module, nullptr);
+                    }
+
+                    continue;
+                }
+
+                setModules(*entry, modules);
+                affected.push_back(entry.get());
+            }
+
+            build(a_device, a_cache, a_jobSystem, affected);
+
+            std::vector<Created> created{};
+
+            for (Entry* e : affected)
+            {
+                if (e->result != VK_SUCCESS)
+                {
+                    std::cout << "[PipelineBatch::rebuild]: failed to create " << e->name << ", keeping the old one\n";
+                    continue;
+                }
+
+                VkPipelineLayout layout{ (e->compute) ? e->computeInfo.layout : e->graphicsInfo.layout };
+                created.push_back(Created{ e->name, e->pipeline, layout });
+            }
+
+            return created;
+        }
+};
+
+#endif // PIPELINE_CACHE_HPP
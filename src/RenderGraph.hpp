@@ -0,0 +1,348 @@
+#ifndef RENDER_GRAPH_HPP
+#define RENDER_GRAPH_HPP
+
+#include "vk_utils.h"
+#include "Texture.hpp"
+
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// one image a pass touches and how: the graph moves the image into a_layout before the pass
+// and assumes the pass leaves it in finalLayout (render passes with layout transitions of their own)
+struct Access
+{
+    Texture*             texture{};
+    VkPipelineStageFlags stages{};
+    VkAccessFlags        access{};
+    VkImageLayout        layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+    VkImageLayout        finalLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
+    bool                 discard{}; // previous contents are not needed, write covers the whole image
+
+    bool isWrite() const
+    {
+        return access & (VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+                | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+    }
+
+    static Access make(Texture* a_texture, VkPipelineStageFlags a_stages, VkAccessFlags a_access, VkImageLayout a_layout, bool a_discard = false)
+    {
+        return Access{ a_texture, a_stages, a_access, a_layout, a_layout, a_discard };
+    }
+
+    static Access sampled(Texture* a_texture, VkPipelineStageFlags a_stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+    {
+        return make(a_texture, a_stages, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+
+    static Access colorAttachment(Texture* a_texture, bool a_discard = true)
+    {
+        VkAccessFlags access{ VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+        if (!a_discard)
+        {
+            access |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+        }
+        return make(a_texture, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, access, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, a_discard);
+    }
+
+    static Access depthAttachment(Texture* a_texture, bool a_discard = true)
+    {
+        return make(a_texture, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, a_discard);
+    }
+
+    static Access storageWrite(Texture* a_texture, bool a_discard = true)
+    {
+        return make(a_texture, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, a_discard);
+    }
+
+    static Access transferSrc(Texture* a_texture)
+    {
+        return make(a_texture, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    }
+
+    static Access transferDst(Texture* a_texture, bool a_discard = true)
+    {
+        return make(a_texture, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, a_discard);
+    }
+};
+
+// passes are declared every frame in submission order with the images they read and write;
+// compile() culls passes nothing needs, execute() records the live ones with the barriers in between
+// (buffer hazards are still on the passes themselves)
+class RenderGraph
+{
+    public:
+        enum ImageFlags : uint32_t
+        {
+            PERSISTENT = 1, // contents are needed by the next frame, writers are never culled
+            TRANSIENT  = 2, // may share memory with other transient images (see planAliasing)
+        };
+
+    private:
+        struct ImageState
+        {
+            uint32_t             flags{};
+            VkImageLayout        layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+            VkPipelineStageFlags writeStages{};
+            VkAccessFlags        writeAccess{};
+            VkPipelineStageFlags readStages{};
+            VkAccessFlags        readAccess{};
+            Texture**            owner{}; // slot of the alias group, the image whose data is in the memory
+        };
+
+        struct Pass
+        {
+            std::string                          name{};
+            std::vector<Access>                  accesses{};
+            std::function<void(VkCommandBuffer)> record{};
+            bool                                 sideEffects{};
+            bool                                 live{};
+        };
+
+        std::unordered_map<Texture*, ImageState> m_images{};
+        std::vector<Pass>                        m_passes{};
+        std::vector<Texture*>                    m_aliasOwners{};
+
+    public:
+        // a_layout: layout the image is in when the first frame starts
+        void addImage(Texture* a_texture, uint32_t a_flags = 0, VkImageLayout a_layout = VK_IMAGE_LAYOUT_UNDEFINED)
+        {
+            m_images[a_texture] = ImageState{ a_flags, a_layout };
+        }
+
+        void clearPasses()
+        {
+            m_passes.clear();
+        }
+
+        // a_sideEffects: pass is kept even if none of its images are read later (presents, writes buffers)
+        void addPass(const std::string& a_name, std::vector<Access> a_accesses, std::function<void(VkCommandBuffer)> a_record,
+                bool a_sideEffects = false)
+        {
+            for (const auto& access : a_accesses)
+            {
+                if (m_images.find(access.texture) == m_images.end())
+                {
+                    throw std::runtime_error("[RenderGraph::addPass]: image used by " + a_name + " is not registered");
+                }
+            }
+
+            m_passes.push_back(Pass{ a_name, std::move(a_accesses), std::move(a_record), a_sideEffects });
+        }
+
+        uint32_t getLivePassCount() const
+        {
+            return (uint32_t)std::count_if(m_passes.begin(), m_passes.end(), [](const Pass& a_pass) { return a_pass.live; });
+        }
+
+        // walks the passes backwards from what is needed at the end of the frame
+        void compile()
+        {
+            std::unordered_set<Texture*> needed{};
+            for (const auto& [texture, state] : m_images)
+            {
+                if (state.flags & PERSISTENT)
+                {
+                    needed.insert(texture);
+                }
+            }
+
+            for (auto pass{ m_passes.rbegin() }; pass != m_passes.rend(); ++pass)
+            {
+                pass->live = pass->sideEffects;
+                for (const auto& access : pass->accesses)
+                {
+                    pass->live = pass->live || (access.isWrite() && needed.count(access.texture));
+                }
+
+                if (!pass->live)
+                {
+                    continue;
+                }
+
+                for (const auto& access : pass->accesses)
+                {
+                    if (access.isWrite() && access.discard)
+                    {
+                        needed.erase(access.texture);
+                    }
+                }
+                for (const auto& access : pass->accesses)
+                {
+                    if (!access.isWrite() || !access.discard)
+                    {
+                        needed.insert(access.texture);
+                    }
+                }
+            }
+        }
+
+        void execute(VkCommandBuffer a_cmdBuff)
+        {
+            for (auto& pass : m_passes)
+            {
+                if (!pass.live)
+                {
+                    continue;
+                }
+
+                std::vector<VkImageMemoryBarrier> barriers{};
+                VkPipelineStageFlags srcStages{};
+                VkPipelineStageFlags dstStages{};
+
+                for (const auto& access : pass.accesses)
+                {
+                    ImageState& state{ m_images[access.texture] };
+
+                    // memory of the group holds another image: contents are garbage and its users are a hazard
+                    if (state.owner && *state.owner != access.texture)
+                    {
+                        if (!access.discard)
+                        {
+                            throw std::runtime_error("[RenderGraph::execute]: " + pass.name + " reads an aliased image it did not write");
+                        }
+
+                        const ImageState& previous{ m_images[*state.owner] };
+                        state.layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+                        state.writeStages = previous.writeStages | previous.readStages;
+                        state.writeAccess = previous.writeAccess;
+                        state.readStages  = 0;
+                        state.readAccess  = 0;
+                        *state.owner      = access.texture;
+                    }
+
+                    bool transition{ state.layout != access.layout };
+                    VkPipelineStageFlags waitStages{};
+                    VkAccessFlags        waitAccess{};
+
+                    if (access.isWrite() || transition)
+                    {
+                        // write after write and write after read
+                        waitStages = state.writeStages | state.readStages;
+                        waitAccess = state.writeAccess;
+                    }
+                    else if ((state.readStages & access.stages) != access.stages || (state.readAccess & access.access) != access.access)
+                    {
+                        // read after write, once per reader stage
+                        waitStages = state.writeStages;
+                        waitAccess = state.writeAccess;
+                    }
+
+                    if (transition || waitStages)
+                    {
+                        VkImageMemoryBarrier barrier{ access.texture->makeBarrier(access.texture->wholeImageRange(), waitAccess, access.access,
+                                (access.discard) ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout, access.layout) };
+                        barriers.push_back(barrier);
+
+                        srcStages |= waitStages;
+                        dstStages |= access.stages;
+                    }
+
+                    if (access.isWrite() || transition)
+                    {
+                        state.writeStages = access.stages;
+                        state.writeAccess = (access.isWrite()) ? access.access & ~VK_ACCESS_COLOR_ATTACHMENT_READ_BIT
+                            & ~VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT : 0;
+                        state.readStages  = (access.isWrite()) ? 0 : access.stages;
+                        state.readAccess  = (access.isWrite()) ? 0 : access.access;
+                    }
+                    else
+                    {
+                        state.readStages |= access.stages;
+                        state.readAccess |= access.access;
+                    }
+                    state.layout = access.finalLayout;
+                }
+
+                if (!barriers.empty())
+                {
+                    vkCmdPipelineBarrier(a_cmdBuff,
+                            (srcStages) ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                            dstStages,
+                            0,
+                            0, nullptr,
+                            0, nullptr,
+                            (uint32_t)barriers.size(), barriers.data());
+                }
+
+                pass.record(a_cmdBuff);
+            }
+        }
+
+        // transient images whose lifetimes over the declared passes do not overlap are put in one group,
+        // members of a group are bound to the same memory
+        std::vector<std::vector<Texture*>> planAliasing()
+        {
+            std::unordered_map<Texture*, std::pair<uint32_t, uint32_t>> lifetimes{};
+            std::vector<Texture*> order{};
+
+            for (uint32_t i{}; i < (uint32_t)m_passes.size(); ++i)
+            {
+                for (const auto& access : m_passes[i].accesses)
+                {
+                    if (!(m_images[access.texture].flags & TRANSIENT))
+                    {
+                        continue;
+                    }
+
+                    auto lifetime{ lifetimes.find(access.texture) };
+                    if (lifetime == lifetimes.end())
+                    {
+                        lifetimes[access.texture] = { i, i };
+                        order.push_back(access.texture);
+                    }
+                    else
+                    {
+                        lifetime->second.second = i;
+                    }
+                }
+            }
+
+            std::vector<std::vector<Texture*>> groups{};
+            std::vector<uint32_t>              groupEnds{};
+            std::vector<uint32_t>              groupTypeBits{};
+
+            for (auto* texture : order)
+            {
+                auto [first, last] = lifetimes[texture];
+                uint32_t typeBits{ texture->getMemoryRequirements().memoryTypeBits };
+
+                uint32_t group{};
+                while (group < groups.size() && (groupEnds[group] >= first || !(groupTypeBits[group] & typeBits)))
+                {
+                    ++group;
+                }
+
+                if (group == groups.size())
+                {
+                    groups.emplace_back();
+                    groupEnds.push_back(0);
+                    groupTypeBits.push_back(~0u);
+                }
+
+                groups[group].push_back(texture);
+                groupEnds[group]      = last;
+                groupTypeBits[group] &= typeBits;
+            }
+
+            m_aliasOwners.assign(groups.size(), nullptr);
+            for (size_t group{}; group < groups.size(); ++group)
+            {
+                for (auto* texture : groups[group])
+                {
+                    m_images[texture].owner = (groups[group].size() > 1) ? &m_aliasOwners[group] : nullptr;
+                }
+            }
+
+            return groups;
+        }
+};
+
+#endif // RENDER_GRAPH_HPP
@@ -0,0 +1,167 @@
+#ifndef SHADER_MANAGER_HPP
+#define SHADER_MANAGER_HPP
+
+#include "vk_utils.h"
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+
+// glsl sources of a shader directory compiled at runtime by glslangValidator (the compiler compile_shaders.sh calls),
+// spir-v is cached in <directory>/cache/ under a hash of the source text and defines, so unchanged shaders are compiled once
+// loaded sources are watched, poll() reports the ones modified since they were loaded
+class ShaderManager
+{
+    private:
+        std::string m_directory{};
+        std::string m_compiler{};
+
+        std::unordered_map<std::string, std::filesystem::file_time_type> m_watched{}; // source --> write time it was loaded with
+
+        // FNV-1a, stable between runs
+        static uint64_t hash(const std::string& a_text, uint64_t a_hash = 14695981039346656037ull)
+        {
+            for (char c : a_text)
+            {
+                a_hash ^= (uint8_t)c;
+                a_hash *= 1099511628211ull;
+            }
+
+            return a_hash;
+        }
+
+        static bool readText(const std::filesystem::path& a_path, std::string& a_text)
+        {
+            std::ifstream file{ a_path, std::ios::binary };
+            if (!file)
+            {
+                return false;
+            }
+
+            a_text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+            return true;
+        }
+
+        static std::vector<uint32_t> readSpirv(const std::filesystem::path& a_path)
+        {
+            std::error_code error{};
+            if (!std::filesystem::exists(a_path, error))
+            {
+                return {};
+            }
+
+            return vk_utils::ReadFile(a_path.string().c_str());
+        }
+
+    public:
+        ShaderManager(const std::string& a_directory = "shaders", const std::string& a_compiler = "glslangValidator")
+            : m_directory{ a_directory }
+            , m_compiler{ a_compiler }
+        {
+        }
+
+        // a_name: file inside the shader directory ("ssao.frag"), a_defines: "NAME" or "NAME=VALUE"
+        // returns empty code if the source does not compile, a precompiled <a_name>.spv is used instead only when
+        // it is not older than the source (so a broken edit never silently falls back to stale code)
+        std::vector<uint32_t> tryLoad(const std::string& a_name, const std::vector<std::string>& a_defines = {})
+        {
+            std::filesystem::path directory{ m_directory };
+            std::filesystem::path source{ directory / a_name };
+            std::error_code       error{};
+
+            m_watched[a_name] = std::filesystem::last_write_time(source, error);
+
+            std::string text{};
+            if (!readText(source, text))
+            {
+                std::cout << "[ShaderManager]: can not read " << source.string() << "\n";
+                return {};
+            }
+
+            uint64_t key{ hash(text) };
+            for (const auto& define : a_defines)
+            {
+                key = hash(define, hash("\n", key));
+            }
+
+            char keyText[17]{};
+            std::snprintf(keyText, sizeof(keyText), "%016llx", (unsigned long long)key);
+
+            std::filesystem::path cached{ directory / "cache" / (a_name + "." + keyText + ".spv") };
+
+            std::vector<uint32_t> code{ readSpirv(cached) };
+            if (!code.empty())
+            {
+                return code;
+            }
+
+            std::filesystem::create_directories(cached.parent_path(), error);
+
+            std::string command{ m_compiler + " -V" };
+            for (const auto& define : a_defines)
+            {
+                command += " -D" + define;
+            }
+            command += " \"" + source.string() + "\" -o \"" + cached.string() + "\"";
+
+            if (std::system(command.c_str()) == 0)
+            {
+                code = readSpirv(cached);
+                if (!code.empty())
+                {
+                    return code;
+                }
+            }
+
+            std::filesystem::remove(cached, error); // partial output of a failed compilation
+
+            std::filesystem::path precompiled{ directory / (a_name + ".spv") };
+            if (a_defines.empty() && std::filesystem::exists(precompiled, error)
+                    && std::filesystem::last_write_time(precompiled, error) >= m_watched[a_name])
+            {
+                return readSpirv(precompiled);
+            }
+
+            return {};
+        }
+
+        std::vector<uint32_t> load(const std::string& a_name, const std::vector<std::string>& a_defines = {})
+        {
+            std::vector<uint32_t> code{ tryLoad(a_name, a_defines) };
+            if (code.empty())
+            {
+                throw std::runtime_error("[ShaderManager::load]: failed to compile " + a_name);
+            }
+
+            return code;
+        }
+
+        // sources whose files changed since they were last loaded
+        std::vector<std::string> poll() const
+        {
+            std::vector<std::string> changed{};
+
+            for (const auto& watched : m_watched)
+            {
+                std::error_code error{};
+                auto time{ std::filesystem::last_write_time(std::filesystem::path(m_directory) / watched.first, error) };
+
+                if (!error && time != watched.second)
+                {
+                    changed.push_back(watched.first);
+                }
+            }
+
+            return changed;
+        }
+};
+
+#endif // SHADER_MANAGER_HPP
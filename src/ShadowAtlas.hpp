@@ -0,0 +1,155 @@
+#ifndef SHADOW_ATLAS_HPP
+#define SHADOW_ATLAS_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// square power of two regions of one shadow map texture (quadtree buddy allocator): a free region is split into quarters
+// to serve a smaller request, and four free quarters are merged back into their parent when the last of them is released
+class ShadowAtlas
+{
+    public:
+        struct Region {
+            glm::uvec2 offset{}; // texels of the top left corner
+            uint32_t   side{};   // 0 = nothing allocated
+        };
+
+    private:
+        uint32_t m_side{};
+        std::vector<std::vector<glm::uvec2>> m_free{}; // offsets of free regions of every level, level 0 is the whole atlas
+
+        // deepest level whose regions are not larger than a_side
+        uint32_t levelOf(uint32_t a_side) const
+        {
+            uint32_t level{};
+            while (level + 1 < m_free.size() && (m_side >> level) > a_side)
+            {
+                ++level;
+            }
+
+            return level;
+        }
+
+        // a region of a_level, a larger one is split when there is no free one
+        bool take(uint32_t a_level, glm::uvec2& a_offset)
+        {
+            if (!m_free[a_level].empty())
+            {
+                a_offset = m_free[a_level].back();
+                m_free[a_level].pop_back();
+                return true;
+            }
+
+            if (a_level == 0 || !take(a_level - 1, a_offset))
+            {
+                return false;
+            }
+
+            uint32_t side{ m_side >> a_level };
+            m_free[a_level].push_back(a_offset + glm::uvec2(side, 0));
+            m_free[a_level].push_back(a_offset + glm::uvec2(0, side));
+            m_free[a_level].push_back(a_offset + glm::uvec2(side, side));
+
+            return true;
+        }
+
+    public:
+        // a_side and a_minSide are powers of two, everything is free again
+        void reset(uint32_t a_side, uint32_t a_minSide)
+        {
+            uint32_t levels{};
+            while ((a_side >> levels) >= a_minSide && (a_side >> levels) > 0)
+            {
+                ++levels;
+            }
+
+            m_side = a_side;
+            m_free.assign(std::max(levels, 1u), {});
+            m_free[0].push_back(glm::uvec2(0));
+        }
+
+        uint32_t getSide() const
+        {
+            return m_side;
+        }
+
+        // side of the region allocate() looks for first (largest power of two not above a_side, at least the minimum)
+        uint32_t quantize(uint32_t a_side) const
+        {
+            return m_side >> levelOf(a_side);
+        }
+
+        // region of quantize(a_side) or, when the atlas has no room for it, the largest smaller one that fits
+        bool allocate(uint32_t a_side, Region& a_region)
+        {
+            for (uint32_t level{ levelOf(a_side) }; level < m_free.size(); ++level)
+            {
+                glm::uvec2 offset{};
+                if (take(level, offset))
+                {
+                    a_region = Region{ offset, m_side >> level };
+                    return true;
+                }
+            }
+
+            a_region = Region{};
+            return false;
+        }
+
+        void release(Region& a_region)
+        {
+            if (a_region.side == 0)
+            {
+                return;
+            }
+
+            uint32_t   level{ levelOf(a_region.side) };
+            glm::uvec2 offset{ a_region.offset };
+            a_region = Region{};
+
+            // merged with the other three quarters of the parent while they are free as well
+            while (level > 0)
+            {
+                uint32_t   side{ m_side >> level };
+                glm::uvec2 parent{ offset / (2 * side) * (2 * side) };
+                auto&      free{ m_free[level] };
+
+                std::vector<std::vector<glm::uvec2>::iterator> quarters{};
+                for (glm::uvec2 quarter : { parent, parent + glm::uvec2(side, 0), parent + glm::uvec2(0, side), parent + glm::uvec2(side) })
+                {
+                    if (quarter == offset)
+                    {
+                        continue;
+                    }
+
+                    auto found{ std::find(free.begin(), free.end(), quarter) };
+                    if (found == free.end())
+                    {
+                        break;
+                    }
+                    quarters.push_back(found);
+                }
+
+                if (quarters.size() != 3)
+                {
+                    break;
+                }
+
+                // erased from the back, so the other iterators stay valid
+                std::sort(quarters.begin(), quarters.end(), [](auto a, auto b) { return a > b; });
+                for (auto quarter : quarters)
+                {
+                    free.erase(quarter);
+                }
+
+                offset = parent;
+                --level;
+            }
+
+            m_free[level].push_back(offset);
+        }
+};
+
+#endif // SHADOW_ATLAS_HPP
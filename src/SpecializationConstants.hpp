@@ -0,0 +1,76 @@
+#ifndef SPECIALIZATION_CONSTANTS_HPP
+#define SPECIALIZATION_CONSTANTS_HPP
+
+#include "vk_utils.h"
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+
+// values of the specialization constants of one shader stage (every constant is 32 bit: int, uint or float)
+// key() tells variants apart: pipelines of the same shaders and equal keys are identical
+class SpecializationConstants
+{
+    private:
+        std::vector<VkSpecializationMapEntry> m_entries{};
+        std::vector<uint32_t>                 m_data{};
+        std::string                           m_key{};
+        VkSpecializationInfo                  m_info{};
+
+        SpecializationConstants& setBits(uint32_t a_id, uint32_t a_bits)
+        {
+            m_entries.push_back(VkSpecializationMapEntry{ a_id, (uint32_t)(m_data.size() * sizeof(uint32_t)), sizeof(uint32_t) });
+            m_data.push_back(a_bits);
+
+            char text[32]{};
+            std::snprintf(text, sizeof(text), "%s%u=%08x", (m_key.empty()) ? "" : ",", a_id, a_bits);
+            m_key += text;
+
+            return *this;
+        }
+
+    public:
+        SpecializationConstants& set(uint32_t a_id, int32_t a_value)
+        {
+            return setBits(a_id, (uint32_t)a_value);
+        }
+
+        SpecializationConstants& set(uint32_t a_id, float a_value)
+        {
+            uint32_t bits{};
+            std::memcpy(&bits, &a_value, sizeof(bits));
+
+            return setBits(a_id, bits);
+        }
+
+        bool empty() const { return m_entries.empty(); }
+
+        // ids and exact bits of the values, e.g. "0=00000008,1=3e4ccccd"
+        const std::string& key() const { return m_key; }
+
+        // valid until this object is changed or destroyed, nullptr if there are no constants
+        const VkSpecializationInfo* info()
+        {
+            if (empty())
+            {
+                return nullptr;
+            }
+
+            m_info.mapEntryCount = m_entries.size();
+            m_info.pMapEntries   = m_entries.data();
+            m_info.dataSize      = m_data.size() * sizeof(uint32_t);
+            m_info.pData         = m_data.data();
+
+            return &m_info;
+        }
+
+        // name of the pipeline variant of a_pipeName built with these constants
+        std::string variantName(const std::string& a_pipeName) const
+        {
+            return (empty()) ? a_pipeName : a_pipeName + " [" + m_key + "]";
+        }
+};
+
+#endif // SPECIALIZATION_CONSTANTS_HPP
@@ -34,8 +34,35 @@ void Texture::loadFromPNG(const char* a_filename)
 }
 
 void Texture::create(VkDevice a_device, VkPhysicalDevice a_physDevice, int a_usage, VkFormat a_format)
+{
+    createImage(a_device, a_usage, a_format);
+
+    VkMemoryRequirements memoryRequirements{ getMemoryRequirements() };
+    VkMemoryAllocateInfo allocateInfo{};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize  = memoryRequirements.size;
+    allocateInfo.memoryTypeIndex = vk_utils::FindMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, a_physDevice);
+    // transient attachments live in tile memory only where lazily allocated memory exists (tilers)
+    if (a_usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+    {
+        uint32_t lazyType{ vk_utils::FindMemoryType(memoryRequirements.memoryTypeBits,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, a_physDevice) };
+        if (lazyType != uint32_t(-1))
+        {
+            allocateInfo.memoryTypeIndex = lazyType;
+        }
+    }
+    VK_CHECK_RESULT(vkAllocateMemory(a_device, &allocateInfo, NULL, &m_imageMemoryGPU));
+
+    bindMemory(m_imageMemoryGPU, 0);
+    m_ownsMemory = true;
+}
+
+void Texture::createImage(VkDevice a_device, int a_usage, VkFormat a_format)
 {
     m_device = a_device;
+    m_usage  = (VkImageUsageFlags)a_usage;
+    m_format = a_format;
 
     VkImageCreateInfo imgCreateInfo{};
     imgCreateInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -53,24 +80,30 @@ void Texture::create(VkDevice a_device, VkPhysicalDevice a_physDevice, int a_usa
     imgCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     VK_CHECK_RESULT(vkCreateImage(a_device, &imgCreateInfo, nullptr, &m_imageGPU));
 
+    m_aspect = (a_usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+}
+
+VkMemoryRequirements Texture::getMemoryRequirements()
+{
     VkMemoryRequirements memoryRequirements{};
-    vkGetImageMemoryRequirements(a_device, m_imageGPU, &memoryRequirements);
-    VkMemoryAllocateInfo allocateInfo{};
-    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocateInfo.allocationSize  = memoryRequirements.size;
-    allocateInfo.memoryTypeIndex = vk_utils::FindMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, a_physDevice);
-    VK_CHECK_RESULT(vkAllocateMemory(a_device, &allocateInfo, NULL, &m_imageMemoryGPU));
-    VK_CHECK_RESULT(vkBindImageMemory(a_device, m_imageGPU, m_imageMemoryGPU, 0));
+    vkGetImageMemoryRequirements(m_device, m_imageGPU, &memoryRequirements);
+    return memoryRequirements;
+}
 
-    if (a_usage & VK_IMAGE_USAGE_SAMPLED_BIT)
+// memory is not freed by cleanup() unless create() allocated it
+void Texture::bindMemory(VkDeviceMemory a_memory, VkDeviceSize a_offset)
+{
+    VK_CHECK_RESULT(vkBindImageMemory(m_device, m_imageGPU, a_memory, a_offset));
+
+    if (m_usage & VK_IMAGE_USAGE_SAMPLED_BIT)
     {
         VkSamplerCreateInfo samplerInfo = {};
         {
             samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
             samplerInfo.pNext        = nullptr;
             samplerInfo.flags        = 0;
-            samplerInfo.magFilter    = VK_FILTER_LINEAR;
-            samplerInfo.minFilter    = VK_FILTER_LINEAR;
+            samplerInfo.magFilter    = m_filter;
+            samplerInfo.minFilter    = m_filter;
             samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR;
             samplerInfo.addressModeU = m_addressMode;
             samplerInfo.addressModeV = m_addressMode;
@@ -84,16 +117,14 @@ void Texture::create(VkDevice a_device, VkPhysicalDevice a_physDevice, int a_usa
             samplerInfo.borderColor      = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
         }
 
-        VK_CHECK_RESULT(vkCreateSampler(a_device, &samplerInfo, nullptr, &m_imageSampler));
+        VK_CHECK_RESULT(vkCreateSampler(m_device, &samplerInfo, nullptr, &m_imageSampler));
     }
 
-    m_aspect = (a_usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
-
     VkImageViewCreateInfo imageViewInfo = {};
     {
         imageViewInfo.sType      = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
         imageViewInfo.viewType   = VK_IMAGE_VIEW_TYPE_2D;
-        imageViewInfo.format     = a_format;
+        imageViewInfo.format     = m_format;
         imageViewInfo.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
         imageViewInfo.subresourceRange.aspectMask     = m_aspect;
         imageViewInfo.subresourceRange.baseMipLevel   = 0;
@@ -103,7 +134,7 @@ void Texture::create(VkDevice a_device, VkPhysicalDevice a_physDevice, int a_usa
         imageViewInfo.image = m_imageGPU;
     }
 
-    VK_CHECK_RESULT(vkCreateImageView(a_device, &imageViewInfo, nullptr, &m_imageView));
+    VK_CHECK_RESULT(vkCreateImageView(m_device, &imageViewInfo, nullptr, &m_imageView));
 }
 
 VkImageMemoryBarrier Texture::makeBarrier(VkImageSubresourceRange a_range, VkAccessFlags a_src, VkAccessFlags a_dst,
@@ -198,9 +229,25 @@ void CubeTexture::copyImageToCubeface(VkCommandBuffer& a_cmdBuff, VkImage a_imag
     vkCmdCopyImage(a_cmdBuff, a_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_imageGPU, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
 }
 
+// a_side x a_side corner of a_image is copied to a_offset (a region of an atlas)
+void Texture::copyImageToRegion(VkCommandBuffer& a_cmdBuff, VkImage a_image, VkOffset2D a_offset, uint32_t a_side)
+{
+    VkImageCopy copyRegion{};
+    copyRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    copyRegion.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    copyRegion.srcOffset      = VkOffset3D{};
+    copyRegion.dstOffset      = VkOffset3D{ a_offset.x, a_offset.y, 0 };
+    copyRegion.extent         = VkExtent3D{ a_side, a_side, 1 };
+
+    vkCmdCopyImage(a_cmdBuff, a_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_imageGPU, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+}
+
 void Texture::cleanup()
 {
-    vkFreeMemory      (m_device, m_imageMemoryGPU, NULL);
+    if (m_ownsMemory)
+    {
+        vkFreeMemory(m_device, m_imageMemoryGPU, NULL);
+    }
     vkDestroyImage    (m_device, m_imageGPU,        NULL);
     vkDestroyImageView(m_device, m_imageView,       NULL);
     vkDestroySampler  (m_device, m_imageSampler,    NULL);
@@ -209,6 +256,14 @@ void Texture::cleanup()
     {
         free(rgba);
     }
+
+    // the texture can be created again (see RecreateCameraTargets)
+    m_imageMemoryGPU = VK_NULL_HANDLE;
+    m_imageGPU       = VK_NULL_HANDLE;
+    m_imageSampler   = VK_NULL_HANDLE;
+    m_imageView      = VK_NULL_HANDLE;
+    m_ownsMemory     = false;
+    rgba             = nullptr;
 }
 
 void CubeTexture::create(VkDevice a_device, VkPhysicalDevice a_physDevice, int a_usage, VkFormat a_format)
@@ -239,6 +294,7 @@ void CubeTexture::create(VkDevice a_device, VkPhysicalDevice a_physDevice, int a
     allocateInfo.memoryTypeIndex = vk_utils::FindMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, a_physDevice);
     VK_CHECK_RESULT(vkAllocateMemory(a_device, &allocateInfo, NULL, &m_imageMemoryGPU));
     VK_CHECK_RESULT(vkBindImageMemory(a_device, m_imageGPU, m_imageMemoryGPU, 0));
+    m_ownsMemory = true;
 
     if (a_usage & VK_IMAGE_USAGE_SAMPLED_BIT)
     {
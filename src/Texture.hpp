@@ -19,6 +19,10 @@ class Texture
         uint32_t       m_width{};
         VkImageAspectFlagBits m_aspect{};
         VkSamplerAddressMode  m_addressMode{ VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER };
+        VkFilter              m_filter{ VK_FILTER_LINEAR };
+        VkImageUsageFlags     m_usage{};
+        VkFormat              m_format{};
+        bool                  m_ownsMemory{};
 
     public:
 
@@ -33,9 +37,11 @@ class Texture
         VkDeviceSize    getSize()         { return m_size; }
         uint32_t        getHeight()       { return m_height; }
         uint32_t        getWidth()        { return m_width; }
+        VkExtent3D      getExtent()       { return m_extent; }
 
         void setExtent(VkExtent3D ext) { m_extent = ext; };
         void setAddressMode(VkSamplerAddressMode mode) { m_addressMode = mode; };
+        void setFilter(VkFilter filter) { m_filter = filter; };
 
         VkImageMemoryBarrier    makeBarrier(VkImageSubresourceRange a_range, VkAccessFlags a_src, VkAccessFlags a_dst, VkImageLayout a_before, VkImageLayout a_after);
 
@@ -43,7 +49,12 @@ class Texture
 
         virtual void loadFromPNG(const char* a_filename);
         virtual void create(VkDevice a_device, VkPhysicalDevice a_physDevice, int a_usage, VkFormat a_format);
+        // create() in two steps, for images placed in memory owned by someone else (aliased attachments)
+        void                 createImage(VkDevice a_device, int a_usage, VkFormat a_format);
+        VkMemoryRequirements getMemoryRequirements();
+        void                 bindMemory(VkDeviceMemory a_memory, VkDeviceSize a_offset);
         void         copyBufferToTexture(VkCommandBuffer& a_cmdBuff, VkBuffer a_cpuBuffer);
+        void         copyImageToRegion(VkCommandBuffer& a_cmdBuff, VkImage a_image, VkOffset2D a_offset, uint32_t a_side);
         void         changeImageLayout(VkCommandBuffer& a_cmdBuff, VkImageMemoryBarrier& a_imBar, VkPipelineStageFlags a_srcStage, VkPipelineStageFlags a_dstStage);
         void         cleanup();
 };
@@ -8,6 +8,8 @@
 #include <glm/ext/matrix_transform.hpp> // glm::translate, glm::rotate, glm::scale
 #include <glm/ext/matrix_clip_space.hpp> // glm::perspective
 #include <glm/ext/scalar_constants.hpp> // glm::pi
+#include <glm/common.hpp> // glm::clamp, glm::fract
+#include <glm/matrix.hpp> // glm::inverse
 
 #include <vulkan/vulkan.h>
 
@@ -22,6 +24,7 @@
 #include <cassert>
 #include <unordered_map>
 #include <utility>
+#include <functional>
 #include <cmath>
 
 #include "vk_utils.h"
@@ -31,12 +34,132 @@
 #include "Texture.hpp"
 #include "ParticleSystem.hpp"
 #include "Timer.hpp"
+#include "JobSystem.hpp"
+#include "Culling.hpp"
+#include "RenderGraph.hpp"
+#include "ShaderManager.hpp"
+#include "SpecializationConstants.hpp"
+#include "PipelineCache.hpp"
+#include "GpuTimer.hpp"
+#include "DynamicResolution.hpp"
+#include "FrameLimiter.hpp"
+#include "LatencyMeter.hpp"
+#include "ShadowAtlas.hpp"
 #include "Eye.hpp"
 
 const int MAX_FRAMES_IN_FLIGHT = 3;
 
-// NOTE: hardcoded in shader
-const int SSAO_SAMPLING_KERNEL_SIZE = 30;
+// NOTE: hardcoded in shader (size of the kernel ubo)
+// every frame takes an interleaved subset of the kernel (QualitySettings::ssaoSamplesPerFrame), temporal pass accumulates them
+const int   SSAO_SAMPLING_KERNEL_SIZE = 32;
+const float SSAO_RADIUS               = 0.2f; // view space, specialization constant of ssao shaders
+
+// ssao quality: 1 = full resolution, 2 = half, 4 = quarter
+// (lower resolutions are upsampled with depth aware bilateral filter)
+const int SSAO_DOWNSCALE = 2;
+
+// NOTE: hardcoded in shader (local_size_x/y of ssao.comp and blur.comp)
+const int SSAO_COMPUTE_TILE = 16;
+
+// fire particles: simulated by particles.comp in a device local buffer (cpu frame time does not depend on the count)
+// or by ParticleSystem::updateParticles and copied into a host visible buffer every frame
+const bool     PARTICLES_ON_GPU    = true;
+const uint32_t FIRE_PARTICLE_COUNT = 700;
+// NOTE: hardcoded in shader (local_size_x of particles.comp)
+const uint32_t PARTICLES_COMPUTE_GROUP = 256;
+// gpu simulated particles further than this from camera are shrunk and spawned less,
+// specialization constant of particles.comp and particlescull.comp
+const float    PARTICLES_LOD_DISTANCE  = 15.0f;
+// particles are blended additively (emissive, order does not matter) or with weighted blended order independent
+// transparency into two extra attachments of the scene pass, composited over scene color (key O switches at runtime)
+const bool     PARTICLES_WEIGHTED_OIT  = false;
+// fire particles cast into the shadow atlas as alpha tested billboards (key P toggles): the first part of every system
+// is drawn into every rendered face, and the part shrinks while the measured gpu time of the billboards exceeds the budget
+const bool  PARTICLE_SHADOWS             = true;
+const float PARTICLE_SHADOW_FRACTION     = 0.25f; // of the particles, at most
+const float PARTICLE_SHADOW_MIN_FRACTION = 0.02f;
+const float PARTICLE_SHADOW_BUDGET_MS    = 0.2f;  // all faces of a frame together
+const float PARTICLE_SHADOW_SPRITE_SIZE  = 0.01f; // world units per unit of particle size (sprites are 3 * size units wide)
+
+// clustered point lights: binned into a froxel grid by clusters.comp, scene.frag shades only the lights of its cluster;
+// the SHADOW_POINT_LIGHTS most important ones in view cast shadows from faces of their own in the shadow atlas
+// NOTE: hardcoded in shader (clusters.comp and scene.frag)
+const uint32_t CLUSTER_X              = 16; // tiles of 1 / CLUSTER_X x 1 / CLUSTER_Y of the targets
+const uint32_t CLUSTER_Y              = 9;
+const uint32_t CLUSTER_Z              = 24; // exponential depth slices between CLUSTER_NEAR and FAR
+const uint32_t MAX_LIGHTS_PER_CLUSTER = 31;
+const float    CLUSTER_NEAR           = 0.5f;
+const uint32_t MAX_POINT_LIGHTS       = 256;
+const uint32_t POINT_LIGHT_COUNT      = 24; // demo lights around the scene
+
+// shadow atlas: the six faces of every shadow casting light (the fire light, then the shadowed point lights) are rendered
+// into square power of two regions of one texture, sized by their estimated screen coverage and by the distance of the light
+// within the texel budget of the quality preset; a light further than SHADOW_LOD_DISTANCE gets smaller faces that are
+// refreshed every distance / SHADOW_LOD_DISTANCE frames (up to SHADOW_MAX_REFRESH), faces that light nothing on screen
+// are refreshed only every SHADOW_IDLE_REFRESH frames
+// NOTE: hardcoded in shader (SHADOW_FACES and SHADOW_LIGHTS in temporal.frag and scene.frag)
+const uint32_t SHADOW_ATLAS_SIDE     = 2048;
+const uint32_t SHADOW_FACES          = 6; // of one light
+const uint32_t SHADOW_POINT_LIGHTS   = 4;
+const uint32_t SHADOW_LIGHTS         = 1 + SHADOW_POINT_LIGHTS;
+const uint32_t SHADOW_MAX_FACE_SIDE  = 1024; // size of the targets faces are rendered into before they are copied to the atlas
+const uint32_t SHADOW_MIN_FACE_SIDE  = 64;
+const float    SHADOW_LOD_DISTANCE   = 5.0f;
+const uint32_t SHADOW_MAX_REFRESH    = 4;
+const uint32_t SHADOW_IDLE_REFRESH   = 8;
+const uint32_t SHADOW_COVERAGE_X     = 32; // screen tiles marched on cpu to estimate coverage
+const uint32_t SHADOW_COVERAGE_Y     = 18;
+const uint32_t SHADOW_COVERAGE_STEPS = 8;  // exponential steps along every tile ray up to SHADOW_COVERAGE_RANGE
+const float    SHADOW_COVERAGE_RANGE = 25.0f;
+const float    PCF_DELTA             = 0.03f; // offset between taps of the 3x3x3 grid, specialization constant of temporal.frag
+
+// renderables are frustum culled per eye, camera passes also test them against a max depth pyramid built by the cpu
+// from tiles of the g buffer depth (read back MAX_FRAMES_IN_FLIGHT frames later)
+// NOTE: hardcoded in shader (local_size_x/y of hiz.comp)
+const uint32_t HIZ_TILE = 16;
+
+// dynamic resolution: camera passes render into the top left part of their full size targets (see Eye::renderProjection),
+// the part shrinks while measured gpu frame time does not fit into the budget, the present pass upscales it to the screen
+const float FRAME_BUDGET_MS  = 1000.0f / 60.0f;
+const float MIN_RENDER_SCALE = 0.5f;
+
+// frame pacing, traded between throughput and latency per deployment (keys 8, 9 and 0 change it at runtime):
+// present mode of the swapchain (FIFO is used when the surface does not support it), frames the cpu records ahead
+// of the gpu (1 to MAX_FRAMES_IN_FLIGHT, which sizes per frame resources) and a frame rate cap
+const VkPresentModeKHR PRESENT_MODE     = VK_PRESENT_MODE_MAILBOX_KHR;
+const uint32_t         FRAMES_IN_FLIGHT = MAX_FRAMES_IN_FLIGHT;
+const bool             FRAME_LIMITER    = false;
+const float            FRAME_LIMIT_FPS  = 60.0f;
+// input to present latency (VK_KHR_present_wait when available, cpu estimate otherwise) is printed this often, 0 = never
+const float LATENCY_REPORT_SECONDS = 5.0f;
+
+// runtime quality presets: ssao samples and pcf taps per frame select prebuilt pipeline variants (specialization constants),
+// shadow texel budget and bloom levels only change what is planned and declared every frame
+enum QualityPreset {
+    QUALITY_LOW,
+    QUALITY_MEDIUM,
+    QUALITY_HIGH,
+    QUALITY_PRESET_COUNT
+};
+
+struct QualitySettings {
+    const char* name;
+    int         ssaoSamplesPerFrame; // divides SSAO_SAMPLING_KERNEL_SIZE
+    int         pcfTaps;             // per frame, out of the 3x3x3 grid (the rest is gathered over the next frames)
+    uint32_t    shadowTexelBudget;   // all faces of the shadow atlas together (the rest of the atlas absorbs fragmentation)
+    uint32_t    bloomLevels;         // first levels of the chain, up to BLOOM_MIP_LEVELS
+};
+
+const QualitySettings QUALITY_SETTINGS[QUALITY_PRESET_COUNT]{
+    { "low",    4,  2, 1 * SHADOW_ATLAS_SIDE * SHADOW_ATLAS_SIDE / 4, 3 },
+    { "medium", 8,  4, 2 * SHADOW_ATLAS_SIDE * SHADOW_ATLAS_SIDE / 4, BLOOM_MIP_LEVELS },
+    { "high",   16, 8, 3 * SHADOW_ATLAS_SIDE * SHADOW_ATLAS_SIDE / 4, BLOOM_MIP_LEVELS }
+};
+
+// driver pipeline cache, rewritten on exit (ignored when it belongs to another device or driver)
+const char* PIPELINE_CACHE_FILE = "pipeline_cache.bin";
+// glsl sources are compiled at runtime and watched, pipelines of edited shaders are rebuilt every SHADER_POLL_FRAMES frames
+const uint32_t SHADER_POLL_FRAMES = 30;
 
 const std::vector<const char*> deviceExtensions{
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
@@ -48,13 +171,51 @@ const bool enableValidationLayers = false;
 const bool enableValidationLayers = true;
 #endif
 
+// scene pass loads the depth of the g buffer pass and shades only fragments with EQUAL depth (no overdraw in scene.frag)
+// NOTE: gbuffer.vert and scene.vert must compute gl_Position the same way (both are invariant)
+const bool DEPTH_PREPASS_REUSE = true;
+
+// emission of glowing objects (texture color is added this many times to HDR scene color)
+const float BLOOM_EMISSION = 1.0f;
+const float BLOOM_FILTER_RADIUS = 1.0f; // in texels of the smaller level, specialization constant of bloomupsample.frag
+
 struct PushConstants {
     glm::mat4 model;
     glm::mat4 view;
     glm::mat4 projection;
     glm::vec3 lightPos;
+    float     emission;
+    uint32_t  frame; // rotates ssao and shadow sampling patterns
+    alignas(16) glm::vec4 lightColor; // rgb = flickering light of the fire emitter (scene pass only)
+};
+
+// std430 layout of clusters.comp and scene.frag
+struct PointLight {
+    glm::vec4 positionRadius; // xyz = world position, w = radius of influence
+    glm::vec4 color;          // a = first of its faces in ShadowFacesBuffer, negative for unshadowed lights
+};
+
+struct PointLightsBuffer {
+    uint32_t   count;
+    uint32_t   padding[3];
+    PointLight lights[MAX_POINT_LIGHTS];
+};
+
+// std430 layout of temporal.frag, faces of the shadow atlas as they were last rendered
+struct ShadowFaceData {
+    glm::mat4 viewProjection;
+    glm::vec4 region;   // xy = atlas uv of the top left corner, z = side in uv (0 = not in the atlas, casts nothing)
+    glm::vec4 lightPos; // xyz = position of the light when the face was rendered
+    glm::vec4 forward;  // xyz = direction the face looks at (the face of a direction is the one it is closest to)
+};
+
+struct ShadowFacesBuffer {
+    ShadowFaceData faces[SHADOW_LIGHTS * SHADOW_FACES];
 };
 
+// every cluster: light count followed by MAX_LIGHTS_PER_CLUSTER light indices
+const VkDeviceSize CLUSTER_GRID_SIZE = CLUSTER_X * CLUSTER_Y * CLUSTER_Z * (MAX_LIGHTS_PER_CLUSTER + 1) * sizeof(uint32_t);
+
 class Application 
 {
     private:
@@ -64,10 +225,19 @@ class Application
         static bool s_shadowmapDebug;
         static bool s_ssaoEnabled;
         static bool s_bloomEnabled;
-
-        static VkDescriptorSet s_blackTexutreDS;
-
-        Timer m_timer;
+        static bool s_ssaoCompute;
+        static QualityPreset s_qualityPreset;
+        static bool s_dynamicResolution;
+        static bool s_framebufferResized;
+        static VkPresentModeKHR s_presentMode;
+        static uint32_t s_framesInFlight;
+        static bool s_frameLimiter;
+        static bool s_particleOIT;
+        static bool s_particleShadows;
+
+        Timer       m_timer;
+        JobSystem   m_jobSystem;   // cpu particle simulation, pipeline creation
+        RenderGraph m_renderGraph; // passes of a frame, their barriers and aliasing of transient attachments
 
         VkInstance m_instance;
         std::vector<const char*> m_enabledLayers;
@@ -86,9 +256,12 @@ class Application
         struct RenderPasses {
             VkRenderPass shadowCubemapPass;
             VkRenderPass gBufferCreationPass;
+            VkRenderPass gBufferDownsamplePass;
             VkRenderPass ssaoPass;
             VkRenderPass ssaoBlurPass;
-            VkRenderPass bloomPass;
+            VkRenderPass scenePass;
+            VkRenderPass bloomDownsamplePass;
+            VkRenderPass bloomUpsamplePass;
             VkRenderPass finalRenderPass;
         } m_renderPasses;
 
@@ -96,29 +269,86 @@ class Application
         std::vector<VkCommandBuffer> m_drawCommandBuffers;
         size_t                       m_currentFrame{}; // for draw command buffer indexing
 
+        // clustered lighting (the fire light and the most important point lights have faces in the shadow atlas)
+        std::vector<PointLight> m_pointLights;
+
+        struct Clusters {
+            VkBuffer        lights; // host visible, a region per frame in flight
+            VkDeviceMemory  lightsMemory;
+            void*           mappedLights;
+            VkDeviceSize    lightsRegionSize;
+            VkBuffer        grid;   // device local, built by clusters.comp every frame
+            VkDeviceMemory  gridMemory;
+            std::vector<VkDescriptorSet> lightsDS; // one for each region
+            VkDescriptorSet gridDS;
+        } m_clusters;
+
+        // faces of the shadow casting lights, every one rendered into its own region of the shadow atlas (see PlanShadowFaces)
+        struct ShadowFace {
+            ShadowAtlas::Region region;         // side 0 = not in the atlas
+            glm::mat4           viewProjection; // matrices and position of the light when the face was last rendered
+            glm::vec3           lightPos;
+            glm::vec3           forward;
+            float               coverage;       // fraction of screen tiles whose rays pass through the face
+            uint32_t            lastUpdate;     // m_frameCount of the last render
+            bool                update;         // scheduled for this frame
+        };
+
+        struct Shadows {
+            ShadowAtlas     atlas;
+            ShadowFace      faces[SHADOW_LIGHTS * SHADOW_FACES]; // six of every light
+            Eye*            lights[SHADOW_LIGHTS];      // fire light, then a PointLightEye for every shadowed point light
+            int32_t         pointLights[SHADOW_LIGHTS]; // index into m_pointLights, -1 = none (and for the fire light)
+            FrustumCuller   pointLightCuller;           // spheres of influence of m_pointLights against the camera
+            std::vector<uint8_t> pointLightVisibility;
+            VkBuffer        facesBuffer; // host visible, a region per frame in flight (ShadowFacesBuffer)
+            VkDeviceMemory  facesMemory;
+            void*           mappedFaces;
+            VkDeviceSize    facesRegionSize;
+            std::vector<VkDescriptorSet> facesDS; // one for each region
+        } m_shadows{};
+
+        // temporal accumulation of ssao and shadows
+        uint32_t  m_frameCount{}; // 0 resets the history
+        glm::mat4 m_prevViewProjection{ 1.0f };
+        bool      m_historyValid{}; // false after frames that skipped the scene pass, next accumulation starts over
+
         struct FramebuffersOffscreen {
             VkFramebuffer shadowCubemapFrameBuffer;
-            VkFramebuffer bloomFrameBuffer;
+            std::vector<VkFramebuffer> sceneFrameBuffers; // one for each history texture
             VkFramebuffer gBufferCreationFrameBuffer;
             VkFramebuffer ssaoFrameBuffer;
             VkFramebuffer ssaoBlurFrameBuffer;
+            VkFramebuffer gBufferDownsampleFrameBuffer; // only for SSAO_DOWNSCALE > 1
+            VkFramebuffer ssaoUpsampleFrameBuffer;      // only for SSAO_DOWNSCALE > 1
+            std::vector<VkFramebuffer> bloomFrameBuffers; // one for each bloom mip level
         } m_framebuffersOffscreen;
 
         struct Attachments {
-            // final pass
+            // scene pass (HDR)
+            Texture     sceneColor;
             Texture     presentDepth;
-            CubeTexture shadowCubemap;
-            // SSAO
-            Texture gPositionAndDepth;
+            Texture     shadowAtlas; // regions of PlanShadowFaces, kept over frames
+            // SSAO (g buffer is presentDepth + octahedral normals)
             Texture gNormals;
             Texture ssao;
             Texture blurredSSAO;
-            // bloom
-            Texture bloom;
-            Texture bloomDepth;
-            // offscreen (shadow map)
+            // SSAO at lower resolution (only for SSAO_DOWNSCALE > 1)
+            Texture lowResDepth;
+            Texture lowResNormals;
+            Texture upsampledSSAO;
+            // ao and shadows accumulated over frames (ping-pong: written one is read by the next frame)
+            std::vector<Texture> temporalHistory;
+            // weighted blended particles (never leave the scene pass)
+            Texture oitAccumulation;
+            Texture oitRevealage;
+            // bloom (mip chain, each level is half of the previous one)
+            std::vector<Texture> bloomChain;
+            // offscreen (a face of the shadow atlas, copied into its region)
             Texture offscreenDepth;
             Texture offscreenColor;
+            // memory shared by transient attachments (see CreateAliasedAttachmentMemory)
+            std::vector<VkDeviceMemory> aliasedMemory;
         } m_attachments;
 
         struct UniformBuffer {
@@ -128,12 +358,23 @@ class Application
         };
 
         struct InputAttachments {
-            InputTexture     gPositionAndDepth;
+            InputTexture     gDepth; // presentDepth
             InputTexture     gNormals;
             InputTexture     ssao;
             InputTexture     blurredSSAO;
-            InputTexture     bloom;
-            InputCubeTexture shadowCubemap;
+            InputTexture     lowResDepth;
+            InputTexture     lowResNormals;
+            InputTexture     upsampledSSAO;
+            std::vector<InputTexture> temporalHistory;
+            std::vector<InputTexture> temporalHistoryInput; // input attachment of the scene subpass
+            InputTexture     oitAccumulationInput; // input attachments of the particle composite subpass
+            InputTexture     oitRevealageInput;
+            // ssao and blurred ssao bound as storage images (compute path)
+            InputTexture     ssaoStorage;
+            InputTexture     blurredSSAOStorage;
+            InputTexture     sceneColor;
+            InputTexture     shadowAtlas;
+            std::vector<InputTexture> bloomChain;
         } m_inputAttachments;
 
         struct SyncObj
@@ -149,13 +390,19 @@ class Application
         };
 
         struct DSLayouts {
-            VkDescriptorSetLayout textureOnlyLayout; // suits cubemap texture as well
+            VkDescriptorSetLayout textureOnlyLayout;
             VkDescriptorSetLayout uboOnlyLayout;
+            VkDescriptorSetLayout storageImageOnlyLayout;
+            VkDescriptorSetLayout storageBufferOnlyLayout;
+            VkDescriptorSetLayout inputAttachmentOnlyLayout;
         } m_DSLayouts;
 
         struct DSPools {
-            VkDescriptorPool textureDSPool; // suits cubemap texture as well
+            VkDescriptorPool textureDSPool;
             VkDescriptorPool uboDSPool;
+            VkDescriptorPool storageImageDSPool;
+            VkDescriptorPool storageBufferDSPool;
+            VkDescriptorPool inputAttachmentDSPool;
         } m_DSPools;
 
         struct RenderObject {
@@ -173,10 +420,50 @@ class Application
         std::unordered_map<std::string, RenderObject>   m_renderables;
         std::unordered_map<std::string, ParticleSystem> m_particleSystems;
         std::unordered_map<std::string, Eye*>           m_pEyes;
+
+        ShaderManager m_shaders;       // runtime compiled spir-v, watched sources
+        PipelineCache m_pipelineCache; // shared by all pipelines, persisted to PIPELINE_CACHE_FILE
+        PipelineBatch m_pipelineBatch; // create infos of m_pipes, kept for rebuilding
+
+        // dynamic resolution
+        GpuTimer          m_gpuTimer;            // command buffer of every frame in flight, sections: particle shadows of every face
+        DynamicResolution m_dynamicResolution{ FRAME_BUDGET_MS, MIN_RENDER_SCALE };
+        glm::vec2         m_renderScale{ 1.0f }; // of the frame being recorded, camera passes draw this part of their targets
+
+        float m_particleShadowFraction{ PARTICLE_SHADOW_FRACTION }; // of the particles drawn into the shadow faces
+
+        // frame pacing
+        VkPresentModeKHR m_presentMode{ PRESENT_MODE };         // requested from the current swapchain
+        uint32_t         m_framesInFlight{ FRAMES_IN_FLIGHT }; // slots cycled by m_currentFrame
+        FrameLimiter     m_frameLimiter;
+        LatencyMeter     m_latency;
+        float            m_latencyReportTime{};
+        std::string      m_windowTitle{};       // toggled settings, see UpdateWindowTitle
+
         // r/w uniform buffers should be created for each MAX_FRAMES_IN_FLIGHT,
         // but we do not use them in this application for simplicity
         std::unordered_map<std::string, UniformBuffer>  m_roUniformBuffers; // ro = read only
 
+        // renderables that survived culling, one list per eye (camera and every shadow face)
+        struct Culling {
+            VkBuffer        hiZTiles; // host visible, a region per frame in flight
+            VkDeviceMemory  hiZTilesMemory;
+            void*           mappedHiZTiles;
+            VkDeviceSize    hiZRegionSize;
+            uint32_t        hiZWidth;  // tiles of HIZ_TILE x HIZ_TILE pixels of the g buffer depth
+            uint32_t        hiZHeight;
+            std::vector<VkDescriptorSet> hiZTilesDS; // one for each region
+            glm::mat4       hiZViewProjection[MAX_FRAMES_IN_FLIGHT]; // camera of the frame that wrote the region
+            bool            hiZWritten[MAX_FRAMES_IN_FLIGHT];
+
+            FrustumCuller   frustum;
+            HiZ             hiZ;
+            std::vector<uint8_t>             visibility; // scratch
+            std::vector<const RenderObject*> objects;    // in the order of frustum culler boxes
+            std::vector<const RenderObject*> camera;
+            std::vector<const RenderObject*> shadowFaces[SHADOW_LIGHTS * SHADOW_FACES];
+        } m_culling{};
+
         static VKAPI_ATTR VkBool32 VKAPI_CALL debugReportCallbackFn(
                 VkDebugReportFlagsEXT                       flags,
                 VkDebugReportObjectTypeEXT                  objectType,
@@ -193,6 +480,61 @@ class Application
 
         VkDebugReportCallbackEXT debugReportCallback;
 
+        static const char* PresentModeName(VkPresentModeKHR a_mode)
+        {
+            switch (a_mode)
+            {
+                case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "immediate";
+                case VK_PRESENT_MODE_MAILBOX_KHR:      return "mailbox";
+                case VK_PRESENT_MODE_FIFO_KHR:         return "fifo";
+                case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo relaxed";
+                default:                               return "other";
+            }
+        }
+
+        // from the lowest latency to the steadiest pacing
+        static VkPresentModeKHR NextPresentMode(VkPresentModeKHR a_mode)
+        {
+            switch (a_mode)
+            {
+                case VK_PRESENT_MODE_IMMEDIATE_KHR:    return VK_PRESENT_MODE_MAILBOX_KHR;
+                case VK_PRESENT_MODE_MAILBOX_KHR:      return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+                case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return VK_PRESENT_MODE_FIFO_KHR;
+                default:                               return VK_PRESENT_MODE_IMMEDIATE_KHR;
+            }
+        }
+
+        // both extensions and their features, present ids are chained into presents and waited on to time them
+        static bool IsPresentWaitSupported(VkPhysicalDevice a_physDevice)
+        {
+            if (!vk_utils::IsDeviceExtensionSupported(a_physDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME) ||
+                    !vk_utils::IsDeviceExtensionSupported(a_physDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+            {
+                return false;
+            }
+
+            VkPhysicalDevicePresentWaitFeaturesKHR presentWait{};
+            presentWait.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+            VkPhysicalDevicePresentIdFeaturesKHR presentId{};
+            presentId.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+            presentId.pNext = &presentWait;
+
+            VkPhysicalDeviceFeatures2 features{};
+            features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features.pNext = &presentId;
+
+            vkGetPhysicalDeviceFeatures2(a_physDevice, &features);
+
+            return presentId.presentId && presentWait.presentWait;
+        }
+
+        // not every platform reports a resize through VK_ERROR_OUT_OF_DATE_KHR
+        static void framebufferSizeCallback(GLFWwindow* a_window, int a_width, int a_height)
+        {
+            s_framebufferResized = true;
+        }
+
         static void keyCallback(GLFWwindow* a_window, int a_key, int a_scancode, int a_action, int a_mods)
         {
             if (a_action == GLFW_PRESS)
@@ -211,6 +553,30 @@ class Application
                     case GLFW_KEY_4:
                         s_bloomEnabled = !s_bloomEnabled;
                         break;
+                    case GLFW_KEY_5:
+                        s_ssaoCompute = !s_ssaoCompute;
+                        break;
+                    case GLFW_KEY_6:
+                        s_qualityPreset = (QualityPreset)((s_qualityPreset + 1) % QUALITY_PRESET_COUNT);
+                        break;
+                    case GLFW_KEY_7:
+                        s_dynamicResolution = !s_dynamicResolution;
+                        break;
+                    case GLFW_KEY_8:
+                        s_presentMode = NextPresentMode(s_presentMode);
+                        break;
+                    case GLFW_KEY_9:
+                        s_framesInFlight = s_framesInFlight % MAX_FRAMES_IN_FLIGHT + 1;
+                        break;
+                    case GLFW_KEY_0:
+                        s_frameLimiter = !s_frameLimiter;
+                        break;
+                    case GLFW_KEY_O:
+                        s_particleOIT = !s_particleOIT;
+                        break;
+                    case GLFW_KEY_P:
+                        s_particleShadows = !s_particleShadows;
+                        break;
                 }
             }
         }
@@ -222,17 +588,80 @@ class Application
             ParticleSystem fire{};
 
             fire.setTimer(a_timer);
-            fire.initParticles(glm::vec3(0.0f, 2.0f, 0.0f), 700);
+            fire.initParticles(glm::vec3(0.0f, 2.0f, 0.0f), FIRE_PARTICLE_COUNT, PARTICLES_ON_GPU);
 
-            CreateHostVisibleBuffer(a_device, a_physDevice, fire.getSize(), &(fire.getVBO()), &(fire.getVBOMemory()),
-                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-            vkMapMemory(a_device, fire.getVBOMemory(), 0, fire.getSize(), 0, &fire.getMappedMemory());
+            if (fire.isSimulatedOnGPU())
+            {
+                // the same buffer is updated by compute shader and drawn as vertex buffer
+                CreateDeviceLocalBuffer(a_device, a_physDevice, fire.getSize(), &(fire.getVBO()), &(fire.getVBOMemory()),
+                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+                FillWithDeadParticles(a_device, a_pool, a_queue, fire.getVBO());
+
+                // visible particles are compacted here and drawn indirectly
+                CreateDeviceLocalBuffer(a_device, a_physDevice, fire.getSize(), &(fire.getVisibleVBO()), &(fire.getVisibleVBOMemory()),
+                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+                CreateDeviceLocalBuffer(a_device, a_physDevice, sizeof(VkDrawIndirectCommand), &(fire.getIndirectBuffer()),
+                        &(fire.getIndirectBufferMemory()), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+            }
+            else
+            {
+                // a region per frame in flight, so that cpu never writes vertices gpu may still be reading
+                VkDeviceSize ringSize{ fire.getRegionSize() * MAX_FRAMES_IN_FLIGHT };
+                CreateHostVisibleBuffer(a_device, a_physDevice, ringSize, &(fire.getVBO()), &(fire.getVBOMemory()),
+                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+                vkMapMemory(a_device, fire.getVBOMemory(), 0, ringSize, 0, &fire.getMappedMemory());
+            }
 
             fire.attachTexture(&(a_IT["fire"]));
 
             a_particleSystems["fire"] = fire;
         }
 
+        // every float of every particle is 3.0f, so alpha > 2.0f and particles.comp respawns all of them on the first dispatch
+        static void FillWithDeadParticles(VkDevice a_device, VkCommandPool a_pool, VkQueue a_queue, VkBuffer a_buffer)
+        {
+            VkCommandBufferAllocateInfo allocInfo = {};
+            allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool        = a_pool;
+            allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer cmdBuff;
+            if (vkAllocateCommandBuffers(a_device, &allocInfo, &cmdBuff) != VK_SUCCESS)
+                throw std::runtime_error("[FillWithDeadParticles]: failed to allocate command buffer!");
+
+            VkCommandBufferBeginInfo beginInfo = {};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+            VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuff, &beginInfo));
+            {
+                float    dead{ 3.0f };
+                uint32_t deadBits{};
+                memcpy(&deadBits, &dead, sizeof(float));
+
+                vkCmdFillBuffer(cmdBuff, a_buffer, 0, VK_WHOLE_SIZE, deadBits);
+
+                VkBufferMemoryBarrier bufBar{};
+                bufBar.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                bufBar.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+                bufBar.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+                bufBar.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                bufBar.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                bufBar.buffer              = a_buffer;
+                bufBar.offset              = 0;
+                bufBar.size                = VK_WHOLE_SIZE;
+
+                vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                        0, nullptr, 1, &bufBar, 0, nullptr);
+            }
+            VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuff));
+
+            RunCommandBuffer(cmdBuff, a_queue, a_device);
+
+            vkFreeCommandBuffers(a_device, a_pool, 1, &cmdBuff);
+        }
+
         static void LoadQuadMesh(VkDevice a_device, VkPhysicalDevice a_physDevice, VkCommandPool a_pool, VkQueue a_queue,
                 std::unordered_map<std::string, Mesh>& a_meshes)
         {
@@ -498,459 +927,630 @@ class Application
             }
         }
 
-        void CreateResources()
+        // colored lights on a slowly turning ring around the scene
+        static void CreatePointLights(std::vector<PointLight>& a_lights)
         {
-            std::cout << "\tcreating sync objects...\n";
-            CreateSyncObjects(m_device, &m_sync);
-
-            std::cout << "\tloading assets...\n";
-            LoadTextures(m_device, physicalDevice, m_commandPool, m_graphicsQueue, m_textures, m_timer); // timer for RANDOM noise texture
-            LoadMeshes(  m_device, physicalDevice, m_commandPool, m_graphicsQueue, m_meshes);
+            a_lights.resize(POINT_LIGHT_COUNT);
 
-            std::cout << "\tcreating attachments...\n";
-            CreateAttachments(     m_device, physicalDevice, m_commandPool, m_graphicsQueue, m_attachments);
-            CreateShadowmapTexture(m_device, physicalDevice, m_commandPool, m_graphicsQueue, m_attachments.shadowCubemap);
+            for (uint32_t i{}; i < POINT_LIGHT_COUNT; ++i)
+            {
+                // hue to rgb
+                float hue{ (float)i / (float)POINT_LIGHT_COUNT };
+                glm::vec3 color{ glm::clamp(glm::abs(glm::fract(hue + glm::vec3(1.0f, 2.0f / 3.0f, 1.0f / 3.0f)) * 6.0f - 3.0f) - 1.0f,
+                        0.0f, 1.0f) };
 
-            std::cout << "\tcreating descriptor sets...\n";
-            CreateTextureOnlyLayout(m_device, &m_DSLayouts.textureOnlyLayout);
-            CreateTextureDescriptorPool(m_device, m_DSPools.textureDSPool, m_textures.size() + 1 + 3 + 2 + 1);
-            // + 1 for cubemap; + 3 for ssao inputs; + 2 for ssao and blurred ssao; +2 for bloom
-            CreateDSForEachModelTexture(m_device, &m_DSLayouts.textureOnlyLayout, m_DSPools.textureDSPool, m_inputTextures, m_textures);
-            CreateDSForOtherInputAttachments(m_device, &m_DSLayouts.textureOnlyLayout, m_DSPools.textureDSPool, m_inputAttachments, m_attachments);
+                a_lights[i].positionRadius = glm::vec4(0.0f, 0.0f, 0.0f, 3.0f);
+                a_lights[i].color          = glm::vec4(2.0f * color, 1.0f);
+            }
+        }
 
-            CreateUBOOnlyLayout(m_device, &m_DSLayouts.uboOnlyLayout);
-            CreateUBODescriptorPool(m_device, m_DSPools.uboDSPool, 1); // 1 for ssao sampling kernel
-            CreateReadOnlyUBOs(m_device, physicalDevice, m_graphicsQueue, m_commandPool, &m_DSLayouts.uboOnlyLayout, m_DSPools.uboDSPool,
-                    m_roUniformBuffers, m_timer);
+        static void UpdatePointLights(std::vector<PointLight>& a_lights, float a_time)
+        {
+            for (size_t i{}; i < a_lights.size(); ++i)
+            {
+                float angle{ 2.0f * glm::pi<float>() * (float)i / (float)a_lights.size() + 0.2f * a_time };
 
-            std::cout << "\tcreating render passes...\n";
-            CreateFinalRenderpass(m_device, &(m_renderPasses.finalRenderPass), m_screen.swapChainImageFormat);
-            CreateBloomRenderpass(m_device, &(m_renderPasses.bloomPass));
-            CreateGBufferRenderPass(m_device, &(m_renderPasses.gBufferCreationPass));
-            CreateSSAORenderPass(m_device, &(m_renderPasses.ssaoPass));
-            CreateBlurRenderPass(m_device, &(m_renderPasses.ssaoBlurPass), VK_FORMAT_R32_SFLOAT);
-            CreateShadowCubemapRenderPass(m_device, &(m_renderPasses.shadowCubemapPass));
+                a_lights[i].positionRadius.x = 7.0f * (float)cos(angle);
+                a_lights[i].positionRadius.y = -2.0f + 0.3f * (float)sin(a_time + (float)i);
+                a_lights[i].positionRadius.z = 7.0f * (float)sin(angle);
+            }
+        }
 
-            std::cout << "\tcreating frame buffers...\n";
-            CreateScreenFrameBuffers(m_device, m_renderPasses.finalRenderPass, &m_screen, m_attachments);
-            CreateBloomFrameBuffer(m_device, m_renderPasses.bloomPass, m_framebuffersOffscreen.bloomFrameBuffer, m_attachments);
-            CreateGBufferFrameBuffer(m_device, m_renderPasses.gBufferCreationPass,
-                    m_framebuffersOffscreen.gBufferCreationFrameBuffer, m_attachments);
-            CreateSSAOFrameBuffer(m_device, m_renderPasses.ssaoPass,
-                    m_framebuffersOffscreen.ssaoFrameBuffer, m_attachments);
-            // There is VK_BLEND_OP_MULTIPLY_EXT, but I dont want to enable this VK_EXT_blend_operation_advanced thing
-            // sampling with texelFetch goes brrrrr...
-            CreateSSAOBlurFrameBuffer(m_device, m_renderPasses.ssaoPass,
-                    m_framebuffersOffscreen.ssaoBlurFrameBuffer, m_attachments);
-            CreateShadowCubemapFrameBuffer(m_device, m_renderPasses.shadowCubemapPass,
-                    m_framebuffersOffscreen.shadowCubemapFrameBuffer, m_attachments);
+        // a_frame: frame in flight whose fence has signaled, its region of the ring is free to write
+        static void UploadPointLights(Clusters& a_clusters, const std::vector<PointLight>& a_lights, size_t a_frame)
+        {
+            auto* region{ reinterpret_cast<PointLightsBuffer*>(static_cast<char*>(a_clusters.mappedLights)
+                    + a_frame * a_clusters.lightsRegionSize) };
 
-            std::cout << "\tcreating graphics pipelines...\n";
-            CreateGraphicsPipelines(m_device, m_screen.swapChainExtent, m_renderPasses, m_pipes, m_DSLayouts);
+            region->count = std::min((uint32_t)a_lights.size(), MAX_POINT_LIGHTS);
+            memcpy(region->lights, a_lights.data(), region->count * sizeof(PointLight));
+        }
 
-            std::cout << "\tcreating camera & light...\n";
-            CreateEyes(m_pEyes, &m_timer);
+        // estimates how much of the screen every face lights by marching rays of screen tiles through the face frustums
+        static void EstimateShadowCoverage(Eye* a_camera, const glm::mat4 a_faceViewProjection[SHADOW_FACES], float a_coverage[SHADOW_FACES])
+        {
+            glm::mat4 inverseViewProjection{ glm::inverse(a_camera->projection() * a_camera->view(0)) };
+            glm::vec3 origin{ a_camera->position() };
 
-            std::cout << "\tcreating particle systems...\n";
-            CreateParticleSystem(m_device, physicalDevice, m_commandPool, m_graphicsQueue, m_particleSystems, m_inputTextures,
-                    &m_timer);
+            uint32_t hits[SHADOW_FACES]{};
+            for (uint32_t y{}; y < SHADOW_COVERAGE_Y; ++y)
+            {
+                for (uint32_t x{}; x < SHADOW_COVERAGE_X; ++x)
+                {
+                    glm::vec4 farPoint{ inverseViewProjection * glm::vec4(
+                            2.0f * ((float)x + 0.5f) / (float)SHADOW_COVERAGE_X - 1.0f,
+                            2.0f * ((float)y + 0.5f) / (float)SHADOW_COVERAGE_Y - 1.0f, 1.0f, 1.0f) };
+                    glm::vec3 direction{ glm::normalize(glm::vec3(farPoint) / farPoint.w - origin) };
 
-            std::cout << "\tcomposing scene...\n";
-            ComposeScene(m_renderables, m_pipes, m_meshes, m_inputTextures);
+                    uint32_t tileFaces{};
+                    for (uint32_t step{}; step < SHADOW_COVERAGE_STEPS; ++step)
+                    {
+                        float distance{ CLUSTER_NEAR * std::pow(SHADOW_COVERAGE_RANGE / CLUSTER_NEAR,
+                                ((float)step + 0.5f) / (float)SHADOW_COVERAGE_STEPS) };
+                        glm::vec4 point{ origin + distance * direction, 1.0f };
 
-            std::cout << "\tcreating drawing command buffers...\n";
-            CreateDrawCommandBuffers(m_device, m_commandPool, m_screen.swapChainFramebuffers, &m_drawCommandBuffers);
-        }
+                        for (uint32_t face{}; face < SHADOW_FACES; ++face)
+                        {
+                            glm::vec4 clip{ a_faceViewProjection[face] * point };
+                            if (clip.w > 0.0f && std::abs(clip.x) <= clip.w && std::abs(clip.y) <= clip.w && clip.z <= clip.w)
+                            {
+                                tileFaces |= 1u << face;
+                            }
+                        }
+                    }
 
+                    for (uint32_t face{}; face < SHADOW_FACES; ++face)
+                    {
+                        hits[face] += (tileFaces >> face) & 1u;
+                    }
+                }
+            }
 
-        void MainLoop()
-        {
-            while (!glfwWindowShouldClose(m_window)) 
+            for (uint32_t face{}; face < SHADOW_FACES; ++face)
             {
-                glfwPollEvents();
-                m_timer.timeStamp();
-                UpdateScene(m_renderables, m_timer.getTime());
-                UpdateParticleSystems(m_particleSystems, m_pEyes["light"]->position());
-                DrawFrame();
+                a_coverage[face] = (float)hits[face] / (float)(SHADOW_COVERAGE_X * SHADOW_COVERAGE_Y);
             }
-
-            vkDeviceWaitIdle(m_device);
         }
 
-        static void CreateFinalRenderpass(VkDevice a_device, VkRenderPass* a_pRenderPass, VkFormat a_swapChainImageFormat)
+        // the SHADOW_POINT_LIGHTS most important point lights in view (brightness by how large their sphere of influence is
+        // from the camera, spheres outside the camera frustum are skipped) keep or get a shadow casting light slot,
+        // a light that drops out gives the regions of its faces back; color.a tells scene.frag where the faces of a light are
+        static void AssignShadowedPointLights(Shadows& a_shadows, std::vector<PointLight>& a_lights, Eye* a_camera)
         {
-            VkAttachmentDescription colorAttachment{};
-            colorAttachment.format         = a_swapChainImageFormat;
-            colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
-            colorAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            colorAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            FrustumCuller& culler{ a_shadows.pointLightCuller };
+            culler.resize((uint32_t)a_lights.size());
 
-            VkAttachmentReference colorAttachmentRef{};
-            colorAttachmentRef.attachment = 0;
-            colorAttachmentRef.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            for (uint32_t i{}; i < a_lights.size(); ++i)
+            {
+                glm::vec3 center{ a_lights[i].positionRadius };
+                float     radius{ a_lights[i].positionRadius.w };
+                culler.setBox(i, Bounds{ center - radius, center + radius, center, radius }, glm::mat4(1.0f));
+            }
 
-            VkAttachmentDescription depthAttachment{};
-            depthAttachment.format         = VK_FORMAT_D32_SFLOAT;
-            depthAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
-            depthAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            depthAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            depthAttachment.finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            culler.cull(a_camera->projection() * a_camera->view(0), a_shadows.pointLightVisibility);
 
-            VkAttachmentReference depthAttachmentRef{};
-            depthAttachmentRef.attachment = 1;
-            depthAttachmentRef.layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            std::vector<std::pair<float, int32_t>> ranked{};
+            for (uint32_t i{}; i < a_lights.size(); ++i)
+            {
+                if (!a_shadows.pointLightVisibility[i])
+                {
+                    continue;
+                }
 
-            VkSubpassDescription subpass {};
-            subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
-            subpass.colorAttachmentCount    = 1;
-            subpass.pColorAttachments       = &colorAttachmentRef;
-            subpass.pDepthStencilAttachment = &depthAttachmentRef;
+                glm::vec3 center{ a_lights[i].positionRadius };
+                float     radius{ a_lights[i].positionRadius.w };
+                float     distance{ std::max(glm::length(center - a_camera->position()), radius) };
+                float     brightness{ glm::dot(glm::vec3(a_lights[i].color), glm::vec3(0.2126f, 0.7152f, 0.0722f)) };
 
-            VkSubpassDependency dependency{};
-            dependency.srcSubpass    = VK_SUBPASS_EXTERNAL;
-            dependency.dstSubpass    = 0;
-            dependency.srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            dependency.srcAccessMask = 0;
-            dependency.dstStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+                ranked.push_back({ brightness * (radius / distance) * (radius / distance), (int32_t)i });
+            }
 
-            std::vector<VkAttachmentDescription> attachments {
-                colorAttachment, depthAttachment
+            size_t chosen{ std::min(ranked.size(), (size_t)SHADOW_POINT_LIGHTS) };
+            std::partial_sort(ranked.begin(), ranked.begin() + chosen, ranked.end(), std::greater<>{});
+            ranked.resize(chosen);
+
+            auto isChosen = [&ranked](int32_t a_light)
+            {
+                return std::any_of(ranked.begin(), ranked.end(), [a_light](const auto& a_ranked) { return a_ranked.second == a_light; });
             };
 
-            VkRenderPassCreateInfo renderPassInfo{};
-            renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-            renderPassInfo.attachmentCount = attachments.size();
-            renderPassInfo.pAttachments    = attachments.data();
-            renderPassInfo.subpassCount    = 1;
-            renderPassInfo.pSubpasses      = &subpass;
-            renderPassInfo.dependencyCount = 1;
-            renderPassInfo.pDependencies   = &dependency;
+            // lights that stay keep their slot (and faces), so the choice does not cost renders while it holds
+            for (uint32_t light{ 1 }; light < SHADOW_LIGHTS; ++light)
+            {
+                if (a_shadows.pointLights[light] >= 0 && !isChosen(a_shadows.pointLights[light]))
+                {
+                    a_shadows.pointLights[light] = -1;
+                    for (uint32_t face{}; face < SHADOW_FACES; ++face)
+                    {
+                        a_shadows.atlas.release(a_shadows.faces[light * SHADOW_FACES + face].region);
+                    }
+                }
+            }
 
-            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pRenderPass) != VK_SUCCESS)
-                throw std::runtime_error("[CreateFinalRenderpass]: failed to create render pass!");
+            for (const auto& candidate : ranked)
+            {
+                int32_t* slots{ a_shadows.pointLights + 1 };
+                int32_t* slotsEnd{ a_shadows.pointLights + SHADOW_LIGHTS };
+                if (std::find(slots, slotsEnd, candidate.second) == slotsEnd)
+                {
+                    *std::find(slots, slotsEnd, -1) = candidate.second;
+                }
+            }
+
+            for (auto& light : a_lights)
+            {
+                light.color.a = -1.0f;
+            }
+
+            for (uint32_t light{ 1 }; light < SHADOW_LIGHTS; ++light)
+            {
+                if (a_shadows.pointLights[light] < 0)
+                {
+                    continue;
+                }
+
+                PointLight& pointLight{ a_lights[a_shadows.pointLights[light]] };
+                pointLight.color.a = (float)(light * SHADOW_FACES);
+
+                static_cast<PointLightEye*>(a_shadows.lights[light])->place(glm::vec3(pointLight.positionRadius),
+                        pointLight.positionRadius.w);
+            }
         }
 
-        static void CreateBloomRenderpass(VkDevice a_device, VkRenderPass* a_pRenderPass)
+        // gives faces of the lights an atlas region proportional to their projected size (smaller for a distant light, all
+        // of them within a_texelBudget) and picks the ones to render: a face is due every few frames (by the distance of its
+        // light and whether it lights anything on screen), only due faces change their region, and a face whose region
+        // changed is rendered again
+        static void PlanShadowFaces(Shadows& a_shadows, Eye* a_camera, uint32_t a_frame, uint32_t a_texelBudget)
         {
-            VkAttachmentDescription colorAttachment{};
-            colorAttachment.format         = VK_FORMAT_R32G32B32A32_SFLOAT;
-            colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
-            colorAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            colorAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            const uint32_t FACES{ SHADOW_LIGHTS * SHADOW_FACES };
 
-            VkAttachmentReference colorAttachmentRef{};
-            colorAttachmentRef.attachment = 0;
-            colorAttachmentRef.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            glm::mat4 viewProjection[FACES]{};
+            float     coverage[FACES]{};
+            float     sides[FACES]{};
+            uint32_t  interval[SHADOW_LIGHTS]{};
+            bool      active[SHADOW_LIGHTS]{};
+            float     texels{};
 
-            VkAttachmentDescription depthAttachment{};
-            depthAttachment.format         = VK_FORMAT_D32_SFLOAT;
-            depthAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
-            depthAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            depthAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            depthAttachment.finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            for (uint32_t light{}; light < SHADOW_LIGHTS; ++light)
+            {
+                Eye* eye{ a_shadows.lights[light] };
 
-            VkAttachmentReference depthAttachmentRef{};
-            depthAttachmentRef.attachment = 1;
-            depthAttachmentRef.layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-            VkSubpassDescription subpass {};
-            subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
-            subpass.colorAttachmentCount    = 1;
-            subpass.pColorAttachments       = &colorAttachmentRef;
-            subpass.pDepthStencilAttachment = &depthAttachmentRef;
+                active[light] = light == 0 || a_shadows.pointLights[light] >= 0;
+                if (!active[light])
+                {
+                    continue;
+                }
 
-            std::vector<VkSubpassDependency> dependency {
+                for (uint32_t face{}; face < SHADOW_FACES; ++face)
                 {
-                    VK_SUBPASS_EXTERNAL,
-                        0,
+                    viewProjection[light * SHADOW_FACES + face] = eye->projection() * eye->view(face);
+                }
 
-                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // -->
+                EstimateShadowCoverage(a_camera, viewProjection + light * SHADOW_FACES, coverage + light * SHADOW_FACES);
 
-                        VK_ACCESS_SHADER_READ_BIT,
-                        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // ==>
+                float distance{ glm::length(eye->position() - a_camera->position()) };
+                float distanceScale{ std::min(1.0f, SHADOW_LOD_DISTANCE / distance) };
+                interval[light] = std::clamp((uint32_t)(distance / SHADOW_LOD_DISTANCE), 1u, SHADOW_MAX_REFRESH);
 
-                        VK_DEPENDENCY_BY_REGION_BIT
-                },
-                    {
-                        0,
-                        VK_SUBPASS_EXTERNAL,
+                for (uint32_t face{ light * SHADOW_FACES }; face < (light + 1) * SHADOW_FACES; ++face)
+                {
+                    sides[face] = std::max((float)SHADOW_MAX_FACE_SIDE * std::sqrt(coverage[face]) * distanceScale,
+                            (float)SHADOW_MIN_FACE_SIDE);
+                    texels += sides[face] * sides[face];
+                }
+            }
 
-                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // <--
-                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            float budgetScale{ std::min(1.0f, std::sqrt((float)a_texelBudget / texels)) };
 
-                        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // <==
-                        VK_ACCESS_SHADER_READ_BIT,
+            // due faces give their regions back first, then the largest ones are allocated first (less fragmentation)
+            std::vector<uint32_t> allocations{};
+            for (uint32_t face{}; face < FACES; ++face)
+            {
+                ShadowFace& shadowFace{ a_shadows.faces[face] };
+                uint32_t    light{ face / SHADOW_FACES };
 
-                        VK_DEPENDENCY_BY_REGION_BIT
-                    }
-            };
+                if (!active[light])
+                {
+                    shadowFace.update = false;
+                    continue;
+                }
 
-            std::vector<VkAttachmentDescription> attachments {
-                colorAttachment, depthAttachment
-            };
+                uint32_t side{ std::clamp((uint32_t)(sides[face] * budgetScale), SHADOW_MIN_FACE_SIDE, SHADOW_MAX_FACE_SIDE) };
+                side = a_shadows.atlas.quantize(side);
 
-            VkRenderPassCreateInfo renderPassInfo{};
-            renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-            renderPassInfo.attachmentCount = attachments.size();
-            renderPassInfo.pAttachments    = attachments.data();
-            renderPassInfo.subpassCount    = 1;
-            renderPassInfo.pSubpasses      = &subpass;
-            renderPassInfo.dependencyCount = dependency.size();
-            renderPassInfo.pDependencies   = dependency.data();
+                uint32_t refresh{ (coverage[face] > 0.0f) ? interval[light] : SHADOW_IDLE_REFRESH };
 
-            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pRenderPass) != VK_SUCCESS)
-                throw std::runtime_error("[CreateBloomRenderpass]: failed to create render pass!");
-        }
+                shadowFace.coverage = coverage[face];
+                shadowFace.update   = shadowFace.region.side == 0 || a_frame - shadowFace.lastUpdate >= refresh;
 
-        static void CreateGBufferRenderPass(VkDevice a_device, VkRenderPass* a_pRenderPass)
-        {
-            std::vector<VkAttachmentDescription> attachmentDescr(3);
+                if (shadowFace.update && shadowFace.region.side != side)
+                {
+                    a_shadows.atlas.release(shadowFace.region);
+                    sides[face] = (float)side;
+                    allocations.push_back(face);
+                }
+            }
 
-            attachmentDescr[0].format = VK_FORMAT_R32G32B32A32_SFLOAT; // vec3(position)float(depth)
-            attachmentDescr[1].format = VK_FORMAT_R32G32B32A32_SFLOAT; // vec3(normals)
-            attachmentDescr[2].format = VK_FORMAT_D32_SFLOAT;          // depth
+            std::sort(allocations.begin(), allocations.end(), [&sides](uint32_t a, uint32_t b) { return sides[a] > sides[b]; });
 
-            for (size_t i{}; i < 3; ++i)
+            // a smaller region when the atlas has no room for the wanted one, none when it is full (the face casts nothing)
+            for (uint32_t face : allocations)
             {
-                attachmentDescr[i].samples        = VK_SAMPLE_COUNT_1_BIT;
-                attachmentDescr[i].loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-                attachmentDescr[i].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-                attachmentDescr[i].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-                attachmentDescr[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-                attachmentDescr[i].finalLayout    = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                a_shadows.atlas.allocate((uint32_t)sides[face], a_shadows.faces[face].region);
             }
 
-            attachmentDescr[2].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+            for (uint32_t face{}; face < FACES; ++face)
+            {
+                ShadowFace& shadowFace{ a_shadows.faces[face] };
 
-            std::vector<VkAttachmentReference> colorAttachmentRef {
-                {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
-                    {1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
-            };
+                shadowFace.update = shadowFace.update && shadowFace.region.side != 0;
+                if (shadowFace.update)
+                {
+                    Eye*      eye{ a_shadows.lights[face / SHADOW_FACES] };
+                    glm::mat4 view{ eye->view(face % SHADOW_FACES) };
 
-            VkAttachmentReference depthAttachmentRef { 2, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+                    shadowFace.viewProjection = viewProjection[face];
+                    shadowFace.lightPos       = eye->position();
+                    shadowFace.forward        = -glm::vec3(view[0][2], view[1][2], view[2][2]); // -z of the view space
+                    shadowFace.lastUpdate     = a_frame;
+                }
+            }
+        }
 
-            VkSubpassDescription subpass {};
-            subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
-            subpass.colorAttachmentCount    = colorAttachmentRef.size();
-            subpass.pColorAttachments       = colorAttachmentRef.data();
-            subpass.pDepthStencilAttachment = &depthAttachmentRef;
+        // a_frame: frame in flight whose fence has signaled, its region of the ring is free to write
+        static void UploadShadowFaces(Shadows& a_shadows, size_t a_frame)
+        {
+            auto* region{ reinterpret_cast<ShadowFacesBuffer*>(static_cast<char*>(a_shadows.mappedFaces)
+                    + a_frame * a_shadows.facesRegionSize) };
 
-            std::vector<VkSubpassDependency> dependency {
-                {
-                    VK_SUBPASS_EXTERNAL,
-                        0,
+            float atlasSide{ (float)a_shadows.atlas.getSide() };
 
-                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // -->
+            for (uint32_t face{}; face < SHADOW_LIGHTS * SHADOW_FACES; ++face)
+            {
+                const ShadowFace& shadowFace{ a_shadows.faces[face] };
 
-                        VK_ACCESS_SHADER_READ_BIT,
-                        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // ==>
+                ShadowFaceData& data{ region->faces[face] };
+                data.viewProjection = shadowFace.viewProjection;
+                data.region         = glm::vec4(glm::vec2(shadowFace.region.offset) / atlasSide, (float)shadowFace.region.side / atlasSide, 0.0f);
+                data.lightPos       = glm::vec4(shadowFace.lightPos, 1.0f);
+                data.forward        = glm::vec4(shadowFace.forward, 0.0f);
+            }
+        }
 
-                        VK_DEPENDENCY_BY_REGION_BIT
-                },
-                    {
-                        0,
-                        VK_SUBPASS_EXTERNAL,
+        // a_frame: frame in flight whose fence has signaled, its region of hi-z tiles is ready to read
+        static void CullRenderables(Culling& a_culling, const std::unordered_map<std::string, RenderObject>& a_objects,
+                Eye* a_camera, const Shadows& a_shadows, size_t a_frame)
+        {
+            a_culling.frustum.resize((uint32_t)a_objects.size());
+            a_culling.objects.clear();
 
-                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // <--
-                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            for (const auto& object : a_objects)
+            {
+                a_culling.frustum.setBox((uint32_t)a_culling.objects.size(), object.second.mesh->bounds, object.second.matrix);
+                a_culling.objects.push_back(&object.second);
+            }
 
-                        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // <==
-                        VK_ACCESS_SHADER_READ_BIT,
+            bool occlusion{ a_culling.hiZWritten[a_frame] };
+            if (occlusion)
+            {
+                auto* tiles{ reinterpret_cast<const float*>(static_cast<const char*>(a_culling.mappedHiZTiles)
+                        + a_frame * a_culling.hiZRegionSize) };
+                a_culling.hiZ.build(tiles, a_culling.hiZWidth, a_culling.hiZHeight, a_culling.hiZViewProjection[a_frame]);
+            }
 
-                        VK_DEPENDENCY_BY_REGION_BIT
+            auto collect = [&](const glm::mat4& a_viewProjection, bool a_occlusion, std::vector<const RenderObject*>& a_visible)
+            {
+                a_culling.frustum.cull(a_viewProjection, a_culling.visibility);
+                a_visible.clear();
+
+                for (uint32_t i{}; i < a_culling.frustum.getCount(); ++i)
+                {
+                    if (!a_culling.visibility[i])
+                    {
+                        continue;
+                    }
+
+                    if (a_occlusion && a_culling.hiZ.isOccluded(a_culling.frustum.getCenter(i), a_culling.frustum.getExtent(i)))
+                    {
+                        continue;
                     }
+
+                    a_visible.push_back(a_culling.objects[i]);
+                }
             };
 
-            VkRenderPassCreateInfo renderPassInfo{};
-            renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-            renderPassInfo.attachmentCount = attachmentDescr.size();
-            renderPassInfo.pAttachments    = attachmentDescr.data();
-            renderPassInfo.subpassCount    = 1;
-            renderPassInfo.pSubpasses      = &subpass;
-            renderPassInfo.dependencyCount = dependency.size();
-            renderPassInfo.pDependencies   = dependency.data();
+            collect(a_camera->projection() * a_camera->view(0), occlusion, a_culling.camera);
 
-            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pRenderPass) != VK_SUCCESS)
-                throw std::runtime_error("[CreateGBufferRenderPass]: failed to create render pass!");
+            for (uint32_t face{}; face < SHADOW_LIGHTS * SHADOW_FACES; ++face)
+            {
+                if (a_shadows.faces[face].update)
+                {
+                    collect(a_shadows.faces[face].viewProjection, false, a_culling.shadowFaces[face]);
+                }
+            }
         }
 
-        static void CreateBlurRenderPass(VkDevice a_device, VkRenderPass* a_pRenderPass, VkFormat a_format)
+        static void CreateClusteredLightingBuffers(VkDevice a_device, VkPhysicalDevice a_physDevice, Clusters& a_clusters)
         {
-            VkAttachmentDescription colorAttachment{};
-            colorAttachment.format         = a_format;
-            colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
-            colorAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            colorAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-            VkAttachmentReference colorAttachmentRef{};
-            colorAttachmentRef.attachment = 0;
-            colorAttachmentRef.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-            VkSubpassDescription subpass {};
-            subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
-            subpass.colorAttachmentCount = 1;
-            subpass.pColorAttachments    = &colorAttachmentRef;
+            // regions are bound with descriptor offsets: 256 satisfies any minStorageBufferOffsetAlignment
+            a_clusters.lightsRegionSize = (sizeof(PointLightsBuffer) + 255) / 256 * 256;
 
-            std::vector<VkAttachmentDescription> attachments{
-                colorAttachment
-            };
+            VkDeviceSize ringSize{ a_clusters.lightsRegionSize * MAX_FRAMES_IN_FLIGHT };
+            CreateHostVisibleBuffer(a_device, a_physDevice, ringSize, &a_clusters.lights, &a_clusters.lightsMemory,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+            vkMapMemory(a_device, a_clusters.lightsMemory, 0, ringSize, 0, &a_clusters.mappedLights);
 
-            std::vector<VkSubpassDependency> dependency {
-                {
-                    VK_SUBPASS_EXTERNAL,
-                        0,
+            CreateDeviceLocalBuffer(a_device, a_physDevice, CLUSTER_GRID_SIZE, &a_clusters.grid, &a_clusters.gridMemory,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        }
 
-                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // -->
+        static void CreateShadowFacesBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, Shadows& a_shadows)
+        {
+            // regions are bound with descriptor offsets: 256 satisfies any minStorageBufferOffsetAlignment
+            a_shadows.facesRegionSize = (sizeof(ShadowFacesBuffer) + 255) / 256 * 256;
 
-                        VK_ACCESS_MEMORY_READ_BIT,
-                        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // ==>
+            VkDeviceSize ringSize{ a_shadows.facesRegionSize * MAX_FRAMES_IN_FLIGHT };
+            CreateHostVisibleBuffer(a_device, a_physDevice, ringSize, &a_shadows.facesBuffer, &a_shadows.facesMemory,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+            vkMapMemory(a_device, a_shadows.facesMemory, 0, ringSize, 0, &a_shadows.mappedFaces);
+        }
 
-                        VK_DEPENDENCY_BY_REGION_BIT
-                },
-                    {
-                        0,
-                        VK_SUBPASS_EXTERNAL,
+        // a_depth: g buffer depth the tiles are built from
+        static void CreateHiZBuffers(VkDevice a_device, VkPhysicalDevice a_physDevice, Culling& a_culling, VkExtent3D a_depth)
+        {
+            a_culling.hiZWidth  = (a_depth.width + HIZ_TILE - 1) / HIZ_TILE;
+            a_culling.hiZHeight = (a_depth.height + HIZ_TILE - 1) / HIZ_TILE;
 
-                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // <--
-                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            // regions are bound with descriptor offsets: 256 satisfies any minStorageBufferOffsetAlignment
+            a_culling.hiZRegionSize = (a_culling.hiZWidth * a_culling.hiZHeight * sizeof(float) + 255) / 256 * 256;
 
-                        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // <==
-                        VK_ACCESS_MEMORY_READ_BIT,
+            VkDeviceSize ringSize{ a_culling.hiZRegionSize * MAX_FRAMES_IN_FLIGHT };
+            CreateHostVisibleBuffer(a_device, a_physDevice, ringSize, &a_culling.hiZTiles, &a_culling.hiZTilesMemory,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+            vkMapMemory(a_device, a_culling.hiZTilesMemory, 0, ringSize, 0, &a_culling.mappedHiZTiles);
+        }
 
-                        VK_DEPENDENCY_BY_REGION_BIT
-                    }
-            };
+        // framebuffers of the attachments, created again with them (see RecreateCameraTargets)
+        void CreateOffscreenFrameBuffers()
+        {
+            CreateSceneFrameBuffers(m_device, m_renderPasses.scenePass, m_framebuffersOffscreen.sceneFrameBuffers, m_attachments);
+            CreateFrameBuffersForEachTexture(m_device, m_renderPasses.bloomDownsamplePass, m_framebuffersOffscreen.bloomFrameBuffers,
+                    m_attachments.bloomChain);
+            CreateGBufferFrameBuffer(m_device, m_renderPasses.gBufferCreationPass,
+                    m_framebuffersOffscreen.gBufferCreationFrameBuffer, m_attachments);
+            CreateSSAOFrameBuffer(m_device, m_renderPasses.ssaoPass,
+                    m_framebuffersOffscreen.ssaoFrameBuffer, m_attachments);
+            // There is VK_BLEND_OP_MULTIPLY_EXT, but I dont want to enable this VK_EXT_blend_operation_advanced thing
+            // sampling with texelFetch goes brrrrr...
+            CreateSSAOBlurFrameBuffer(m_device, m_renderPasses.ssaoPass,
+                    m_framebuffersOffscreen.ssaoBlurFrameBuffer, m_attachments);
+            if (SSAO_DOWNSCALE > 1)
+            {
+                CreateGBufferDownsampleFrameBuffer(m_device, m_renderPasses.gBufferDownsamplePass,
+                        m_framebuffersOffscreen.gBufferDownsampleFrameBuffer, m_attachments);
+                CreateSSAOUpsampleFrameBuffer(m_device, m_renderPasses.ssaoPass,
+                        m_framebuffersOffscreen.ssaoUpsampleFrameBuffer, m_attachments);
+            }
+            CreateShadowCubemapFrameBuffer(m_device, m_renderPasses.shadowCubemapPass,
+                    m_framebuffersOffscreen.shadowCubemapFrameBuffer, m_attachments);
+        }
 
-            VkRenderPassCreateInfo renderPassInfo{};
-            renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-            renderPassInfo.attachmentCount = attachments.size();
-            renderPassInfo.pAttachments    = attachments.data();
-            renderPassInfo.subpassCount    = 1;
-            renderPassInfo.pSubpasses      = &subpass;
-            renderPassInfo.dependencyCount = dependency.size();
-            renderPassInfo.pDependencies   = dependency.data();
+        void DestroyOffscreenFrameBuffers()
+        {
+            vkDestroyFramebuffer(m_device, m_framebuffersOffscreen.shadowCubemapFrameBuffer, nullptr);
+            vkDestroyFramebuffer(m_device, m_framebuffersOffscreen.ssaoFrameBuffer, nullptr);
+            vkDestroyFramebuffer(m_device, m_framebuffersOffscreen.ssaoBlurFrameBuffer, nullptr);
+            vkDestroyFramebuffer(m_device, m_framebuffersOffscreen.gBufferCreationFrameBuffer, nullptr);
+            if (SSAO_DOWNSCALE > 1)
+            {
+                vkDestroyFramebuffer(m_device, m_framebuffersOffscreen.gBufferDownsampleFrameBuffer, nullptr);
+                vkDestroyFramebuffer(m_device, m_framebuffersOffscreen.ssaoUpsampleFrameBuffer, nullptr);
+            }
+            for (auto framebuffer : m_framebuffersOffscreen.bloomFrameBuffers)
+            {
+                vkDestroyFramebuffer(m_device, framebuffer, nullptr);
+            }
 
-            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pRenderPass) != VK_SUCCESS)
-                throw std::runtime_error("[CreateBlurRenderPass]: failed to create render pass!");
+            for (auto framebuffer : m_framebuffersOffscreen.sceneFrameBuffers)
+            {
+                vkDestroyFramebuffer(m_device, framebuffer, nullptr);
+            }
         }
 
-        static void CreateSSAORenderPass(VkDevice a_device, VkRenderPass* a_pRenderPass)
+        void CreateResources()
         {
-            VkAttachmentDescription colorAttachment{};
-            colorAttachment.format         = VK_FORMAT_R32_SFLOAT;
-            colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
-            colorAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            colorAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            std::cout << "\tcreating sync objects...\n";
+            CreateSyncObjects(m_device, &m_sync);
 
-            VkAttachmentReference colorAttachmentRef{};
-            colorAttachmentRef.attachment = 0;
-            colorAttachmentRef.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            std::cout << "\tloading assets...\n";
+            LoadTextures(m_device, physicalDevice, m_commandPool, m_graphicsQueue, m_textures, m_timer); // timer for RANDOM noise texture
+            LoadMeshes(  m_device, physicalDevice, m_commandPool, m_graphicsQueue, m_meshes);
 
-            VkSubpassDescription subpass {};
-            subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
-            subpass.colorAttachmentCount = 1;
-            subpass.pColorAttachments    = &colorAttachmentRef;
+            std::cout << "\tcreating attachments...\n";
+            CreateAttachments(     m_device, physicalDevice, m_attachments, m_screen.swapChainExtent);
+            CreateShadowAtlasTexture(m_device, physicalDevice, m_commandPool, m_graphicsQueue, m_attachments.shadowAtlas);
+            m_renderGraph.addImage(&m_attachments.shadowAtlas, RenderGraph::PERSISTENT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            CreateAliasedAttachmentMemory();
 
-            std::vector<VkAttachmentDescription> attachments{
-                colorAttachment
-            };
+            std::cout << "\tcreating descriptor sets...\n";
+            CreateTextureOnlyLayout(m_device, &m_DSLayouts.textureOnlyLayout);
+            CreateTextureDescriptorPool(m_device, m_DSPools.textureDSPool, m_textures.size() + 1 + 3 + 2 + 3 + 2 + 1 + BLOOM_MIP_LEVELS);
+            // + 1 for shadow atlas; + 3 for ssao inputs; + 2 for ssao and blurred ssao; + 3 for low resolution ssao;
+            // + 2 for temporal history; + 1 for scene color; + BLOOM_MIP_LEVELS for bloom
+            CreateDSForEachModelTexture(m_device, &m_DSLayouts.textureOnlyLayout, m_DSPools.textureDSPool, m_inputTextures, m_textures);
+            CreateDSForOtherInputAttachments(m_device, &m_DSLayouts.textureOnlyLayout, m_DSPools.textureDSPool, m_inputAttachments, m_attachments);
 
-            std::vector<VkSubpassDependency> dependency {
-                {
-                    VK_SUBPASS_EXTERNAL,
-                        0,
+            CreateUBOOnlyLayout(m_device, &m_DSLayouts.uboOnlyLayout);
+            CreateUBODescriptorPool(m_device, m_DSPools.uboDSPool, 1); // 1 for ssao sampling kernel
+            CreateReadOnlyUBOs(m_device, physicalDevice, m_graphicsQueue, m_commandPool, &m_DSLayouts.uboOnlyLayout, m_DSPools.uboDSPool,
+                    m_roUniformBuffers, m_timer);
 
-                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // -->
+            CreateStorageImageOnlyLayout(m_device, &m_DSLayouts.storageImageOnlyLayout);
+            CreateStorageImageDescriptorPool(m_device, m_DSPools.storageImageDSPool, 2); // 2 for ssao and blurred ssao
+            CreateDSForStorageImages(m_device, &m_DSLayouts.storageImageOnlyLayout, m_DSPools.storageImageDSPool, m_inputAttachments,
+                    m_attachments);
 
-                        VK_ACCESS_MEMORY_READ_BIT,
-                        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // ==>
+            CreateInputAttachmentOnlyLayout(m_device, &m_DSLayouts.inputAttachmentOnlyLayout);
+            CreateInputAttachmentDescriptorPool(m_device, m_DSPools.inputAttachmentDSPool, 2 + 2); // 2 for temporal history, 2 for oit
+            CreateDSForInputAttachments(m_device, &m_DSLayouts.inputAttachmentOnlyLayout, m_DSPools.inputAttachmentDSPool, m_inputAttachments,
+                    m_attachments);
 
-                        VK_DEPENDENCY_BY_REGION_BIT
-                },
-                    {
-                        0,
-                        VK_SUBPASS_EXTERNAL,
+            CreateStorageBufferOnlyLayout(m_device, &m_DSLayouts.storageBufferOnlyLayout);
+            CreateStorageBufferDescriptorPool(m_device, m_DSPools.storageBufferDSPool,
+                    3 + MAX_FRAMES_IN_FLIGHT + 1 + MAX_FRAMES_IN_FLIGHT + MAX_FRAMES_IN_FLIGHT);
+            // 3 for fire particles (all, visible, indirect); MAX_FRAMES_IN_FLIGHT for point lights; 1 for light clusters;
+            // MAX_FRAMES_IN_FLIGHT for hi-z tiles; MAX_FRAMES_IN_FLIGHT for shadow faces
 
-                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // <--
-                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            std::cout << "\tcreating point lights...\n";
+            CreatePointLights(m_pointLights);
+            CreateClusteredLightingBuffers(m_device, physicalDevice, m_clusters);
+            CreateDSForClusters(m_device, &m_DSLayouts.storageBufferOnlyLayout, m_DSPools.storageBufferDSPool, m_clusters);
 
-                        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // <==
-                        VK_ACCESS_MEMORY_READ_BIT,
+            std::cout << "\tcreating shadow atlas faces...\n";
+            m_shadows.atlas.reset(SHADOW_ATLAS_SIDE, SHADOW_MIN_FACE_SIDE);
+            CreateShadowFacesBuffer(m_device, physicalDevice, m_shadows);
+            CreateDSForShadowFaces(m_device, &m_DSLayouts.storageBufferOnlyLayout, m_DSPools.storageBufferDSPool, m_shadows);
 
-                        VK_DEPENDENCY_BY_REGION_BIT
-                    }
-            };
+            std::cout << "\tcreating hi-z buffers...\n";
+            CreateHiZBuffers(m_device, physicalDevice, m_culling, m_attachments.presentDepth.getExtent());
+            CreateDSForHiZ(m_device, &m_DSLayouts.storageBufferOnlyLayout, m_DSPools.storageBufferDSPool, m_culling);
 
-            VkRenderPassCreateInfo renderPassInfo{};
-            renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-            renderPassInfo.attachmentCount = attachments.size();
-            renderPassInfo.pAttachments    = attachments.data();
-            renderPassInfo.subpassCount    = 1;
-            renderPassInfo.pSubpasses      = &subpass;
-            renderPassInfo.dependencyCount = dependency.size();
-            renderPassInfo.pDependencies   = dependency.data();
+            std::cout << "\tcreating render passes...\n";
+            CreateFinalRenderpass(m_device, &(m_renderPasses.finalRenderPass), m_screen.swapChainImageFormat);
+            CreateSceneRenderpass(m_device, &(m_renderPasses.scenePass));
+            CreateBloomRenderpasses(m_device, &(m_renderPasses.bloomDownsamplePass), &(m_renderPasses.bloomUpsamplePass));
+            CreateGBufferRenderPass(m_device, &(m_renderPasses.gBufferCreationPass));
+            CreateGBufferDownsampleRenderPass(m_device, &(m_renderPasses.gBufferDownsamplePass));
+            CreateSSAORenderPass(m_device, &(m_renderPasses.ssaoPass));
+            CreateBlurRenderPass(m_device, &(m_renderPasses.ssaoBlurPass), VK_FORMAT_R32_SFLOAT);
+            CreateShadowCubemapRenderPass(m_device, &(m_renderPasses.shadowCubemapPass));
 
-            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pRenderPass) != VK_SUCCESS)
-                throw std::runtime_error("[CreateSSAORenderPass]: failed to create render pass!");
-        }
+            std::cout << "\tcreating frame buffers...\n";
+            CreateScreenFrameBuffers(m_device, m_renderPasses.finalRenderPass, &m_screen);
+            CreateOffscreenFrameBuffers();
 
-        static void CreateShadowCubemapRenderPass(VkDevice a_device, VkRenderPass* a_pRenderPass)
-        {
-            VkAttachmentDescription colorAttachment{};
-            colorAttachment.format         = VK_FORMAT_R32_SFLOAT;
-            colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
-            colorAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            colorAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+            m_pipelineCache.load(m_device, physicalDevice, PIPELINE_CACHE_FILE);
+
+            std::cout << "\tcompiling shaders...\n";
+            CreateGraphicsPipelines(m_device, m_screen.swapChainExtent, m_renderPasses, m_DSLayouts, m_shaders, m_pipelineBatch);
+            CreateComputePipelines(m_device, m_DSLayouts, m_shaders, m_pipelineBatch);
+
+            std::cout << "\tcreating pipelines...\n";
+            for (auto& created : m_pipelineBatch.create(m_device, m_pipelineCache.get(), m_jobSystem))
+            {
+                m_pipes[created.name] = Pipe{ created.pipeline, created.pipelineLayout };
+            }
+
+            std::cout << "\tcreating camera & light...\n";
+            CreateEyes(m_pEyes, &m_timer);
+            m_pEyes["camera"]->setTargetSize(glm::vec2(m_screen.swapChainExtent.width, m_screen.swapChainExtent.height));
+
+            m_shadows.lights[0]      = m_pEyes["light"];
+            m_shadows.pointLights[0] = -1;
+            for (uint32_t i{ 1 }; i < SHADOW_LIGHTS; ++i)
+            {
+                m_shadows.lights[i]      = m_pEyes["point light " + std::to_string(i - 1)];
+                m_shadows.pointLights[i] = -1;
+            }
+
+            m_gpuTimer.create(m_device, physicalDevice, vk_utils::GetQueueFamilyIndex(physicalDevice, VK_QUEUE_GRAPHICS_BIT),
+                    MAX_FRAMES_IN_FLIGHT, SHADOW_FACES);
+            if (!m_gpuTimer.enabled())
+            {
+                std::cout << "\tno gpu timestamps on the graphics queue, dynamic resolution keeps the full resolution"
+                    << " and particle shadows their largest fraction\n";
+            }
+
+            std::cout << "\tcreating particle systems...\n";
+            CreateParticleSystem(m_device, physicalDevice, m_commandPool, m_graphicsQueue, m_particleSystems, m_inputTextures,
+                    &m_timer);
+            CreateDSForParticleSystems(m_device, &m_DSLayouts.storageBufferOnlyLayout, m_DSPools.storageBufferDSPool, m_particleSystems);
+
+            std::cout << "\tcomposing scene...\n";
+            ComposeScene(m_renderables, m_pipes, m_meshes, m_inputTextures);
+
+            std::cout << "\tcreating drawing command buffers...\n";
+            CreateDrawCommandBuffers(m_device, m_commandPool, m_screen.swapChainFramebuffers, &m_drawCommandBuffers);
+        }
+
+
+        void MainLoop()
+        {
+            while (!glfwWindowShouldClose(m_window)) 
+            {
+                // the cap is waited out before input is polled, so it does not add to the latency of the frame
+                if (s_frameLimiter)
+                {
+                    m_frameLimiter.wait(FRAME_LIMIT_FPS);
+                }
+                glfwPollEvents();
+                m_latency.inputPolled();
+                UpdateWindowTitle();
+                m_timer.timeStamp();
+                UpdateScene(m_renderables, m_timer.getTime());
+                UpdatePointLights(m_pointLights, m_timer.getTime());
+                if (m_frameCount % SHADER_POLL_FRAMES == 0)
+                {
+                    ReloadChangedShaders();
+                }
+                DrawFrame();
+            }
+
+            vkDeviceWaitIdle(m_device);
+        }
+
+        // settings the keys toggle, the title is only set again when one of them changed
+        void UpdateWindowTitle()
+        {
+            auto onOff = [](bool a_on) { return (a_on) ? "on" : "off"; };
+
+            std::string title{ std::string("Vulkan | quality: ") + QUALITY_SETTINGS[s_qualityPreset].name
+                + ", dynamic resolution: " + onOff(s_dynamicResolution)
+                + ", present mode: " + PresentModeName(s_presentMode)
+                + ", frames in flight: " + std::to_string(s_framesInFlight)
+                + ", frame limiter: " + onOff(s_frameLimiter)
+                + ", particles: " + ((s_particleOIT) ? "weighted blended oit" : "additive")
+                + ", particle shadows: " + onOff(s_particleShadows) };
+
+            if (title != m_windowTitle)
+            {
+                m_windowTitle = title;
+                glfwSetWindowTitle(m_window, m_windowTitle.c_str());
+            }
+        }
+
+        static void CreateFinalRenderpass(VkDevice a_device, VkRenderPass* a_pRenderPass, VkFormat a_swapChainImageFormat)
+        {
+            VkAttachmentDescription colorAttachment{};
+            colorAttachment.format         = a_swapChainImageFormat;
+            colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+            colorAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            colorAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
             colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
             VkAttachmentReference colorAttachmentRef{};
             colorAttachmentRef.attachment = 0;
             colorAttachmentRef.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-            VkAttachmentDescription depthAttachment{};
-            depthAttachment.format         = VK_FORMAT_D32_SFLOAT;
-            depthAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
-            depthAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            depthAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            depthAttachment.finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-            VkAttachmentReference depthAttachmentRef{};
-            depthAttachmentRef.attachment = 1;
-            depthAttachmentRef.layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
+            // final pass only composes HDR scene color and bloom, so no depth here
             VkSubpassDescription subpass {};
             subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
             subpass.colorAttachmentCount    = 1;
             subpass.pColorAttachments       = &colorAttachmentRef;
-            subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
-            std::vector<VkAttachmentDescription> attachments{
-                colorAttachment, depthAttachment
+            VkSubpassDependency dependency{};
+            dependency.srcSubpass    = VK_SUBPASS_EXTERNAL;
+            dependency.dstSubpass    = 0;
+            dependency.srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            dependency.srcAccessMask = 0;
+            dependency.dstStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+            std::vector<VkAttachmentDescription> attachments {
+                colorAttachment
             };
 
             VkRenderPassCreateInfo renderPassInfo{};
@@ -959,642 +1559,2382 @@ class Application
             renderPassInfo.pAttachments    = attachments.data();
             renderPassInfo.subpassCount    = 1;
             renderPassInfo.pSubpasses      = &subpass;
+            renderPassInfo.dependencyCount = 1;
+            renderPassInfo.pDependencies   = &dependency;
 
             if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pRenderPass) != VK_SUCCESS)
-                throw std::runtime_error("[CreateShadowCubemapRenderPass]: failed to create render pass!");
+                throw std::runtime_error("[CreateFinalRenderpass]: failed to create render pass!");
         }
 
-        static void CreateTextureOnlyLayout(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout)
+        // subpass #0: temporal accumulation of ssao and shadows into the current history texture
+        // subpass #1: HDR scene, reads the accumulated value of its own pixel as an input attachment
+        static void CreateSceneRenderpass(VkDevice a_device, VkRenderPass* a_pRenderPass)
         {
-            VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-            samplerLayoutBinding.binding            = 0;
-            samplerLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            samplerLayoutBinding.descriptorCount    = 1;
-            samplerLayoutBinding.stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT;
-            samplerLayoutBinding.pImmutableSamplers = nullptr;
-
-            std::array<VkDescriptorSetLayoutBinding, 1> binds = {samplerLayoutBinding};
+            VkAttachmentDescription historyAttachment{};
+            historyAttachment.format         = VK_FORMAT_R16G16B16A16_SFLOAT;
+            historyAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+            historyAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            historyAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE; // sampled with reprojection by the next frame
+            historyAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            historyAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            historyAttachment.initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            historyAttachment.finalLayout    = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // layout of the input attachment
+
+            VkAttachmentReference historyAttachmentRef{};
+            historyAttachmentRef.attachment = 0;
+            historyAttachmentRef.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentReference historyInputRef{};
+            historyInputRef.attachment = 0;
+            historyInputRef.layout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-            VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
-            descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-            descriptorSetLayoutCreateInfo.bindingCount = binds.size();
-            descriptorSetLayoutCreateInfo.pBindings    = binds.data();
+            VkAttachmentDescription colorAttachment{};
+            colorAttachment.format         = VK_FORMAT_R16G16B16A16_SFLOAT; // HDR
+            colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+            colorAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            colorAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+            colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            colorAttachment.initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-            if (vkCreateDescriptorSetLayout(a_device, &descriptorSetLayoutCreateInfo, nullptr, a_pDSLayout) != VK_SUCCESS)
-                throw std::runtime_error("[CreateTextureOnlyLayout]: failed to create DS layout!");
-        }
+            VkAttachmentReference colorAttachmentRef{};
+            colorAttachmentRef.attachment = 1;
+            colorAttachmentRef.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-        static void CreateUBOOnlyLayout(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout)
-        {
-            VkDescriptorSetLayoutBinding uboLayoutBinding{};
-            uboLayoutBinding.binding            = 0;
-            uboLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            uboLayoutBinding.descriptorCount    = 1;
-            uboLayoutBinding.stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT;
-            uboLayoutBinding.pImmutableSamplers = nullptr;
+            VkAttachmentDescription depthAttachment{};
+            depthAttachment.format         = VK_FORMAT_D32_SFLOAT;
+            depthAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+            depthAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            depthAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+            depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depthAttachment.initialLayout  = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // sampled by subpass #0
+            depthAttachment.finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
-            std::array<VkDescriptorSetLayoutBinding, 1> binds = {uboLayoutBinding};
+            VkAttachmentReference depthAttachmentRef{};
+            depthAttachmentRef.attachment = 2;
+            depthAttachmentRef.layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
-            VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
-            descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-            descriptorSetLayoutCreateInfo.bindingCount = binds.size();
-            descriptorSetLayoutCreateInfo.pBindings    = binds.data();
+            // depth of the g buffer pass (left shader read only by ssao and temporal accumulation) is loaded and only tested against,
+            // nothing reads it after this pass and the next g buffer pass clears it
+            if (DEPTH_PREPASS_REUSE)
+            {
+                depthAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_LOAD;
+                depthAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                depthAttachment.finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+                depthAttachmentRef.layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+            }
 
-            if (vkCreateDescriptorSetLayout(a_device, &descriptorSetLayoutCreateInfo, nullptr, a_pDSLayout) != VK_SUCCESS)
-                throw std::runtime_error("[CreateTextureOnlyLayout]: failed to create DS layout!");
-        }
+            // weighted blended particles: sum of weighted colors and product of (1 - coverage), cleared to nothing covered,
+            // read by the composite subpass of the same pixel and dropped
+            VkAttachmentDescription oitAccumulationAttachment{};
+            oitAccumulationAttachment.format         = VK_FORMAT_R16G16B16A16_SFLOAT;
+            oitAccumulationAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+            oitAccumulationAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            oitAccumulationAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            oitAccumulationAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            oitAccumulationAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            oitAccumulationAttachment.initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            oitAccumulationAttachment.finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentDescription oitRevealageAttachment{ oitAccumulationAttachment };
+            oitRevealageAttachment.format = VK_FORMAT_R16_SFLOAT;
+
+            std::vector<VkAttachmentReference> oitAttachmentRefs{
+                { 3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+                { 4, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL }
+            };
 
-        static void CreateOneUBODescriptorSet(VkDevice a_device, const VkDescriptorSetLayout *a_pDSLayout, VkDescriptorPool& a_DSPool,
-                VkDescriptorSet& a_dset, VkBuffer& a_buffer, VkDeviceSize a_bufferSize)
-        {
-            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
-            descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-            descriptorSetAllocateInfo.descriptorPool     = a_DSPool;
-            descriptorSetAllocateInfo.descriptorSetCount = 1;
-            descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+            std::vector<VkAttachmentReference> oitInputRefs{
+                { 3, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+                { 4, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }
+            };
 
-            if (vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, &a_dset) != VK_SUCCESS)
-                throw std::runtime_error("[CreateOneUBODescriptorSet]: failed to allocate descriptor set pool!");
+            // history (stored for the next frame), scene color and depth keep their contents through the subpasses that skip them
+            std::vector<uint32_t> oitPreserve{ 0, 1 };
+            std::vector<uint32_t> compositePreserve{ 0, 2 };
+
+            std::vector<VkSubpassDescription> subpasses(4);
+            subpasses[0].pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpasses[0].colorAttachmentCount    = 1;
+            subpasses[0].pColorAttachments       = &historyAttachmentRef;
+
+            subpasses[1].pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpasses[1].inputAttachmentCount    = 1;
+            subpasses[1].pInputAttachments       = &historyInputRef;
+            subpasses[1].colorAttachmentCount    = 1;
+            subpasses[1].pColorAttachments       = &colorAttachmentRef;
+            subpasses[1].pDepthStencilAttachment = &depthAttachmentRef;
+
+            // weighted blended particles (empty with additive particles, those are drawn by subpass #1)
+            subpasses[2].pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpasses[2].colorAttachmentCount    = oitAttachmentRefs.size();
+            subpasses[2].pColorAttachments       = oitAttachmentRefs.data();
+            subpasses[2].pDepthStencilAttachment = &depthAttachmentRef;
+            subpasses[2].preserveAttachmentCount = oitPreserve.size();
+            subpasses[2].pPreserveAttachments    = oitPreserve.data();
+
+            // composite of weighted blended particles over scene color
+            subpasses[3].pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpasses[3].inputAttachmentCount    = oitInputRefs.size();
+            subpasses[3].pInputAttachments       = oitInputRefs.data();
+            subpasses[3].colorAttachmentCount    = 1;
+            subpasses[3].pColorAttachments       = &colorAttachmentRef;
+            subpasses[3].preserveAttachmentCount = compositePreserve.size();
+            subpasses[3].pPreserveAttachments    = compositePreserve.data();
+
+            // everything outside of the pass is synchronized by the render graph (attachments come in their initial layouts),
+            // only the transitions in between subpasses are left here
+            std::vector<VkSubpassDependency> dependency {
+                // depth leaves shader read only layout at subpass #1, the graph waits for it up to the depth tests
+                {
+                    VK_SUBPASS_EXTERNAL,
+                        1,
 
-            VkWriteDescriptorSet descrWrite{};
-            descrWrite.sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descrWrite.dstSet            = a_dset;
-            descrWrite.dstBinding        = 0;
-            descrWrite.dstArrayElement   = 0;
-            descrWrite.descriptorType    = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descrWrite.descriptorCount   = 1;
+                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, // -->
 
-            VkDescriptorBufferInfo bufferInfo{ a_buffer, 0, a_bufferSize };
-            descrWrite.pBufferInfo        = &bufferInfo;
+                        0,
+                        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, // ==>
 
-            vkUpdateDescriptorSets(a_device, 1, &descrWrite, 0, nullptr);
-        }
+                        0
+                },
+                    // accumulated value of the same pixel
+                    {
+                        0,
+                        1,
 
-        // read only <== one for all frames in flight (READ - READ)
-        static void CreateReadOnlyUBOs(VkDevice a_device, VkPhysicalDevice a_physDevice, VkQueue a_queue, VkCommandPool a_pool,
-                VkDescriptorSetLayout* a_pDSLayout, VkDescriptorPool& a_dsPool,
-                std::unordered_map<std::string, UniformBuffer>& a_UBOs, Timer a_timer)
-        {
-            a_timer.timeStamp();
-            std::default_random_engine randomEngine{ (long unsigned int)a_timer.getTime() };
+                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // <--
+                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
 
-            auto random = [&](float a_range)
-            {
-                std::uniform_real_distribution<float> randomDistribution(0.0f, a_range);
-                return randomDistribution(randomEngine);
-            };
+                        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // <==
+                        VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
 
-            UniformBuffer ssaoSamplerKernel{ VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE };
-            // data for ssao sampler kernel ubo
-            std::vector<glm::vec4> kernel(SSAO_SAMPLING_KERNEL_SIZE);
-            {
-                for (auto& sampleVector : kernel)
-                {
-                    glm::vec3 vec = glm::vec3(random(2.0f) - 1.0f, random(2.0f) - 1.0f, random(1.0f));
-                    vec = glm::normalize(vec) * random(1.0f);
-                    sampleVector = glm::vec4(vec, 1.0f);
-                };
-            }
+                        VK_DEPENDENCY_BY_REGION_BIT
+                    },
+                    // accumulation samples depth around reprojected pixels, so not by region
+                    {
+                        0,
+                        1,
 
-            {
-                VkBuffer stagingBuffer{};
-                VkDeviceMemory stagingBufferMemory{};
-                size_t size{ kernel.size() * sizeof(glm::vec4) };
+                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, // <--
+                        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
 
-                CreateHostVisibleBuffer(a_device, a_physDevice, size, &stagingBuffer, &stagingBufferMemory);
+                        VK_ACCESS_SHADER_READ_BIT, // <==
+                        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
 
-                void *mappedMemory = nullptr;
-                vkMapMemory(a_device, stagingBufferMemory, 0, size, 0, &mappedMemory);
-                memcpy(mappedMemory, kernel.data(), size);
-                vkUnmapMemory(a_device, stagingBufferMemory);
+                        0
+                    },
+                    // particles are tested against the depth of the scene
+                    {
+                        1,
+                        2,
 
-                CreateDeviceLocalBuffer(a_device, a_physDevice, size, &ssaoSamplerKernel.buffer, &ssaoSamplerKernel.memory,
-                        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+                        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, // <--
+                        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
 
-                SubmitStagingBuffer(a_device, a_pool, a_queue, stagingBuffer, ssaoSamplerKernel.buffer, size);
+                        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, // <==
+                        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
 
-                vkFreeMemory(a_device, stagingBufferMemory, nullptr);
-                vkDestroyBuffer(a_device, stagingBuffer, nullptr);
+                        VK_DEPENDENCY_BY_REGION_BIT
+                    },
+                    // accumulated particles of the same pixel
+                    {
+                        2,
+                        3,
 
-                CreateOneUBODescriptorSet(a_device, a_pDSLayout, a_dsPool, ssaoSamplerKernel.descriptorSet, ssaoSamplerKernel.buffer, size);
-            }
+                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // <--
+                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
 
-            a_UBOs["ssao kernel"] = ssaoSamplerKernel;
-        }
+                        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // <==
+                        VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
 
-        static void CreateOneImageDescriptorSet(VkDevice a_device, const VkDescriptorSetLayout *a_pDSLayout, VkDescriptorPool& a_DSPool,
-                VkDescriptorSet& a_dset, VkImageView a_imageView, VkSampler a_imageSampler)
-        {
-            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
-            descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-            descriptorSetAllocateInfo.descriptorPool     = a_DSPool;
-            descriptorSetAllocateInfo.descriptorSetCount = 1;
-            descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+                        VK_DEPENDENCY_BY_REGION_BIT
+                    },
+                    // composite blends over scene color of the same pixel
+                    {
+                        1,
+                        3,
 
-            if (vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, &a_dset) != VK_SUCCESS)
-                throw std::runtime_error("[CreateOneImageDescriptorSet]: failed to allocate descriptor set pool!");
+                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // <--
+                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
 
-            VkWriteDescriptorSet descrWrite{};
-            descrWrite.sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descrWrite.dstSet            = a_dset;
-            descrWrite.dstBinding        = 0;
-            descrWrite.dstArrayElement   = 0;
-            descrWrite.descriptorType    = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            descrWrite.descriptorCount   = 1;
+                        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, // <==
+                        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
 
-            VkDescriptorImageInfo        imageInfo{ a_imageSampler, a_imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
-            descrWrite.pImageInfo        = &imageInfo;
+                        VK_DEPENDENCY_BY_REGION_BIT
+                    }
+            };
 
-            vkUpdateDescriptorSets(a_device, 1, &descrWrite, 0, nullptr);
-        }
+            std::vector<VkAttachmentDescription> attachments {
+                historyAttachment, colorAttachment, depthAttachment, oitAccumulationAttachment, oitRevealageAttachment
+            };
 
-        // this suits cubemap texture as well
-        static void CreateUBODescriptorPool(VkDevice a_device, VkDescriptorPool& a_dsPool, uint32_t a_count)
-        {
+            VkRenderPassCreateInfo renderPassInfo{};
+            renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            renderPassInfo.attachmentCount = attachments.size();
+            renderPassInfo.pAttachments    = attachments.data();
+            renderPassInfo.subpassCount    = subpasses.size();
+            renderPassInfo.pSubpasses      = subpasses.data();
+            renderPassInfo.dependencyCount = dependency.size();
+            renderPassInfo.pDependencies   = dependency.data();
+
+            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pRenderPass) != VK_SUCCESS)
+                throw std::runtime_error("[CreateSceneRenderpass]: failed to create render pass!");
+        }
+
+        // downsample pass overwrites the whole mip level, upsample pass blends into already filled one
+        static void CreateBloomRenderpasses(VkDevice a_device, VkRenderPass* a_pDownsamplePass, VkRenderPass* a_pUpsamplePass)
+        {
+            VkAttachmentDescription colorAttachment{};
+            colorAttachment.format         = VK_FORMAT_R16G16B16A16_SFLOAT;
+            colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+            colorAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            colorAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+            colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            colorAttachment.initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // transitions and barriers are up to the render graph
+            colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentReference colorAttachmentRef{};
+            colorAttachmentRef.attachment = 0;
+            colorAttachmentRef.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkSubpassDescription subpass {};
+            subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.colorAttachmentCount = 1;
+            subpass.pColorAttachments    = &colorAttachmentRef;
+
+            std::vector<VkAttachmentDescription> attachments {
+                colorAttachment
+            };
+
+            VkRenderPassCreateInfo renderPassInfo{};
+            renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            renderPassInfo.attachmentCount = attachments.size();
+            renderPassInfo.pAttachments    = attachments.data();
+            renderPassInfo.subpassCount    = 1;
+            renderPassInfo.pSubpasses      = &subpass;
+
+            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pDownsamplePass) != VK_SUCCESS)
+                throw std::runtime_error("[CreateBloomRenderpasses]: failed to create downsample render pass!");
+
+            // upsampled level is added on top of the downsampled one
+            attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+
+            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pUpsamplePass) != VK_SUCCESS)
+                throw std::runtime_error("[CreateBloomRenderpasses]: failed to create upsample render pass!");
+        }
+
+        // bytes per pixel written: 4 (normals) + 4 (depth) = 8
+        // (used to be 16 (position) + 16 (normals) + 4 (depth) = 36 with RGBA32F position and normals)
+        static void CreateGBufferRenderPass(VkDevice a_device, VkRenderPass* a_pRenderPass)
+        {
+            std::vector<VkAttachmentDescription> attachmentDescr(2);
+
+            attachmentDescr[0].format = VK_FORMAT_R16G16_SFLOAT; // octahedral normals (view space)
+            attachmentDescr[1].format = VK_FORMAT_D32_SFLOAT;    // depth (view space position is reconstructed from it)
+
+            for (size_t i{}; i < 2; ++i)
+            {
+                attachmentDescr[i].samples        = VK_SAMPLE_COUNT_1_BIT;
+                attachmentDescr[i].loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+                attachmentDescr[i].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+                attachmentDescr[i].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                attachmentDescr[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            }
+
+            // transitions and barriers are up to the render graph
+            attachmentDescr[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            attachmentDescr[0].finalLayout   = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            attachmentDescr[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            attachmentDescr[1].finalLayout   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+            std::vector<VkAttachmentReference> colorAttachmentRef {
+                {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+            };
+
+            VkAttachmentReference depthAttachmentRef { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+            VkSubpassDescription subpass {};
+            subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.colorAttachmentCount    = colorAttachmentRef.size();
+            subpass.pColorAttachments       = colorAttachmentRef.data();
+            subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+            VkRenderPassCreateInfo renderPassInfo{};
+            renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            renderPassInfo.attachmentCount = attachmentDescr.size();
+            renderPassInfo.pAttachments    = attachmentDescr.data();
+            renderPassInfo.subpassCount    = 1;
+            renderPassInfo.pSubpasses      = &subpass;
+
+            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pRenderPass) != VK_SUCCESS)
+                throw std::runtime_error("[CreateGBufferRenderPass]: failed to create render pass!");
+        }
+
+        // full resolution g buffer --> SSAO_DOWNSCALE times smaller one (no depth test, fullscreen quad)
+        static void CreateGBufferDownsampleRenderPass(VkDevice a_device, VkRenderPass* a_pRenderPass)
+        {
+            std::vector<VkAttachmentDescription> attachmentDescr(2);
+
+            attachmentDescr[0].format = VK_FORMAT_R32_SFLOAT;   // depth
+            attachmentDescr[1].format = VK_FORMAT_R16G16_SFLOAT; // octahedral normals
+
+            for (size_t i{}; i < 2; ++i)
+            {
+                attachmentDescr[i].samples        = VK_SAMPLE_COUNT_1_BIT;
+                attachmentDescr[i].loadOp         = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                attachmentDescr[i].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+                attachmentDescr[i].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                attachmentDescr[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                attachmentDescr[i].initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // transitions and barriers are up to the render graph
+                attachmentDescr[i].finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            }
+
+            std::vector<VkAttachmentReference> colorAttachmentRef {
+                {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+                    {1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+            };
+
+            VkSubpassDescription subpass {};
+            subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.colorAttachmentCount = colorAttachmentRef.size();
+            subpass.pColorAttachments    = colorAttachmentRef.data();
+
+            VkRenderPassCreateInfo renderPassInfo{};
+            renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            renderPassInfo.attachmentCount = attachmentDescr.size();
+            renderPassInfo.pAttachments    = attachmentDescr.data();
+            renderPassInfo.subpassCount    = 1;
+            renderPassInfo.pSubpasses      = &subpass;
+
+            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pRenderPass) != VK_SUCCESS)
+                throw std::runtime_error("[CreateGBufferDownsampleRenderPass]: failed to create render pass!");
+        }
+
+        static void CreateBlurRenderPass(VkDevice a_device, VkRenderPass* a_pRenderPass, VkFormat a_format)
+        {
+            VkAttachmentDescription colorAttachment{};
+            colorAttachment.format         = a_format;
+            colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+            colorAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            colorAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+            colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            colorAttachment.initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // transitions and barriers are up to the render graph
+            colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentReference colorAttachmentRef{};
+            colorAttachmentRef.attachment = 0;
+            colorAttachmentRef.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkSubpassDescription subpass {};
+            subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.colorAttachmentCount = 1;
+            subpass.pColorAttachments    = &colorAttachmentRef;
+
+            std::vector<VkAttachmentDescription> attachments{
+                colorAttachment
+            };
+
+            VkRenderPassCreateInfo renderPassInfo{};
+            renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            renderPassInfo.attachmentCount = attachments.size();
+            renderPassInfo.pAttachments    = attachments.data();
+            renderPassInfo.subpassCount    = 1;
+            renderPassInfo.pSubpasses      = &subpass;
+
+            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pRenderPass) != VK_SUCCESS)
+                throw std::runtime_error("[CreateBlurRenderPass]: failed to create render pass!");
+        }
+
+        static void CreateSSAORenderPass(VkDevice a_device, VkRenderPass* a_pRenderPass)
+        {
+            VkAttachmentDescription colorAttachment{};
+            colorAttachment.format         = VK_FORMAT_R32_SFLOAT;
+            colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+            colorAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            colorAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+            colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            colorAttachment.initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // transitions and barriers are up to the render graph
+            colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentReference colorAttachmentRef{};
+            colorAttachmentRef.attachment = 0;
+            colorAttachmentRef.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkSubpassDescription subpass {};
+            subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.colorAttachmentCount = 1;
+            subpass.pColorAttachments    = &colorAttachmentRef;
+
+            std::vector<VkAttachmentDescription> attachments{
+                colorAttachment
+            };
+
+            VkRenderPassCreateInfo renderPassInfo{};
+            renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            renderPassInfo.attachmentCount = attachments.size();
+            renderPassInfo.pAttachments    = attachments.data();
+            renderPassInfo.subpassCount    = 1;
+            renderPassInfo.pSubpasses      = &subpass;
+
+            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pRenderPass) != VK_SUCCESS)
+                throw std::runtime_error("[CreateSSAORenderPass]: failed to create render pass!");
+        }
+
+        static void CreateShadowCubemapRenderPass(VkDevice a_device, VkRenderPass* a_pRenderPass)
+        {
+            VkAttachmentDescription colorAttachment{};
+            colorAttachment.format         = VK_FORMAT_R32_SFLOAT;
+            colorAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+            colorAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            colorAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+            colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            colorAttachment.initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // transitions and barriers are up to the render graph
+            colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentReference colorAttachmentRef{};
+            colorAttachmentRef.attachment = 0;
+            colorAttachmentRef.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentDescription depthAttachment{};
+            depthAttachment.format         = VK_FORMAT_D32_SFLOAT;
+            depthAttachment.samples        = VK_SAMPLE_COUNT_1_BIT;
+            depthAttachment.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            depthAttachment.storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE; // transient, only distances in color are copied
+            depthAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depthAttachment.initialLayout  = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            depthAttachment.finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentReference depthAttachmentRef{};
+            depthAttachmentRef.attachment = 1;
+            depthAttachmentRef.layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+            VkSubpassDescription subpass {};
+            subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.colorAttachmentCount    = 1;
+            subpass.pColorAttachments       = &colorAttachmentRef;
+            subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+            std::vector<VkAttachmentDescription> attachments{
+                colorAttachment, depthAttachment
+            };
+
+            VkRenderPassCreateInfo renderPassInfo{};
+            renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            renderPassInfo.attachmentCount = attachments.size();
+            renderPassInfo.pAttachments    = attachments.data();
+            renderPassInfo.subpassCount    = 1;
+            renderPassInfo.pSubpasses      = &subpass;
+
+            if (vkCreateRenderPass(a_device, &renderPassInfo, nullptr, a_pRenderPass) != VK_SUCCESS)
+                throw std::runtime_error("[CreateShadowCubemapRenderPass]: failed to create render pass!");
+        }
+
+        static void CreateTextureOnlyLayout(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout)
+        {
+            VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+            samplerLayoutBinding.binding            = 0;
+            samplerLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            samplerLayoutBinding.descriptorCount    = 1;
+            samplerLayoutBinding.stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+            samplerLayoutBinding.pImmutableSamplers = nullptr;
+
+            std::array<VkDescriptorSetLayoutBinding, 1> binds = {samplerLayoutBinding};
+
+            VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+            descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            descriptorSetLayoutCreateInfo.bindingCount = binds.size();
+            descriptorSetLayoutCreateInfo.pBindings    = binds.data();
+
+            if (vkCreateDescriptorSetLayout(a_device, &descriptorSetLayoutCreateInfo, nullptr, a_pDSLayout) != VK_SUCCESS)
+                throw std::runtime_error("[CreateTextureOnlyLayout]: failed to create DS layout!");
+        }
+
+        static void CreateUBOOnlyLayout(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout)
+        {
+            VkDescriptorSetLayoutBinding uboLayoutBinding{};
+            uboLayoutBinding.binding            = 0;
+            uboLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            uboLayoutBinding.descriptorCount    = 1;
+            uboLayoutBinding.stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+            uboLayoutBinding.pImmutableSamplers = nullptr;
+
+            std::array<VkDescriptorSetLayoutBinding, 1> binds = {uboLayoutBinding};
+
+            VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+            descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            descriptorSetLayoutCreateInfo.bindingCount = binds.size();
+            descriptorSetLayoutCreateInfo.pBindings    = binds.data();
+
+            if (vkCreateDescriptorSetLayout(a_device, &descriptorSetLayoutCreateInfo, nullptr, a_pDSLayout) != VK_SUCCESS)
+                throw std::runtime_error("[CreateTextureOnlyLayout]: failed to create DS layout!");
+        }
+
+        static void CreateStorageImageOnlyLayout(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout)
+        {
+            VkDescriptorSetLayoutBinding storageLayoutBinding{};
+            storageLayoutBinding.binding            = 0;
+            storageLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            storageLayoutBinding.descriptorCount    = 1;
+            storageLayoutBinding.stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+            storageLayoutBinding.pImmutableSamplers = nullptr;
+
+            std::array<VkDescriptorSetLayoutBinding, 1> binds = {storageLayoutBinding};
+
+            VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+            descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            descriptorSetLayoutCreateInfo.bindingCount = binds.size();
+            descriptorSetLayoutCreateInfo.pBindings    = binds.data();
+
+            if (vkCreateDescriptorSetLayout(a_device, &descriptorSetLayoutCreateInfo, nullptr, a_pDSLayout) != VK_SUCCESS)
+                throw std::runtime_error("[CreateStorageImageOnlyLayout]: failed to create DS layout!");
+        }
+
+        static void CreateInputAttachmentOnlyLayout(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout)
+        {
+            VkDescriptorSetLayoutBinding inputLayoutBinding{};
+            inputLayoutBinding.binding            = 0;
+            inputLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            inputLayoutBinding.descriptorCount    = 1;
+            inputLayoutBinding.stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT;
+            inputLayoutBinding.pImmutableSamplers = nullptr;
+
+            std::array<VkDescriptorSetLayoutBinding, 1> binds = {inputLayoutBinding};
+
+            VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+            descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            descriptorSetLayoutCreateInfo.bindingCount = binds.size();
+            descriptorSetLayoutCreateInfo.pBindings    = binds.data();
+
+            if (vkCreateDescriptorSetLayout(a_device, &descriptorSetLayoutCreateInfo, nullptr, a_pDSLayout) != VK_SUCCESS)
+                throw std::runtime_error("[CreateInputAttachmentOnlyLayout]: failed to create DS layout!");
+        }
+
+        static void CreateStorageBufferOnlyLayout(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout)
+        {
+            VkDescriptorSetLayoutBinding storageLayoutBinding{};
+            storageLayoutBinding.binding            = 0;
+            storageLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            storageLayoutBinding.descriptorCount    = 1;
+            storageLayoutBinding.stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+            storageLayoutBinding.pImmutableSamplers = nullptr;
+
+            std::array<VkDescriptorSetLayoutBinding, 1> binds = {storageLayoutBinding};
+
+            VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+            descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            descriptorSetLayoutCreateInfo.bindingCount = binds.size();
+            descriptorSetLayoutCreateInfo.pBindings    = binds.data();
+
+            if (vkCreateDescriptorSetLayout(a_device, &descriptorSetLayoutCreateInfo, nullptr, a_pDSLayout) != VK_SUCCESS)
+                throw std::runtime_error("[CreateStorageBufferOnlyLayout]: failed to create DS layout!");
+        }
+
+        static void CreateOneUBODescriptorSet(VkDevice a_device, const VkDescriptorSetLayout *a_pDSLayout, VkDescriptorPool& a_DSPool,
+                VkDescriptorSet& a_dset, VkBuffer& a_buffer, VkDeviceSize a_bufferSize)
+        {
+            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+            descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            descriptorSetAllocateInfo.descriptorPool     = a_DSPool;
+            descriptorSetAllocateInfo.descriptorSetCount = 1;
+            descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+
+            if (vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, &a_dset) != VK_SUCCESS)
+                throw std::runtime_error("[CreateOneUBODescriptorSet]: failed to allocate descriptor set pool!");
+
+            VkWriteDescriptorSet descrWrite{};
+            descrWrite.sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descrWrite.dstSet            = a_dset;
+            descrWrite.dstBinding        = 0;
+            descrWrite.dstArrayElement   = 0;
+            descrWrite.descriptorType    = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            descrWrite.descriptorCount   = 1;
+
+            VkDescriptorBufferInfo bufferInfo{ a_buffer, 0, a_bufferSize };
+            descrWrite.pBufferInfo        = &bufferInfo;
+
+            vkUpdateDescriptorSets(a_device, 1, &descrWrite, 0, nullptr);
+        }
+
+        // read only <== one for all frames in flight (READ - READ)
+        static void CreateReadOnlyUBOs(VkDevice a_device, VkPhysicalDevice a_physDevice, VkQueue a_queue, VkCommandPool a_pool,
+                VkDescriptorSetLayout* a_pDSLayout, VkDescriptorPool& a_dsPool,
+                std::unordered_map<std::string, UniformBuffer>& a_UBOs, Timer a_timer)
+        {
+            a_timer.timeStamp();
+            std::default_random_engine randomEngine{ (long unsigned int)a_timer.getTime() };
+
+            auto random = [&](float a_range)
+            {
+                std::uniform_real_distribution<float> randomDistribution(0.0f, a_range);
+                return randomDistribution(randomEngine);
+            };
+
+            UniformBuffer ssaoSamplerKernel{ VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE };
+            // data for ssao sampler kernel ubo
+            std::vector<glm::vec4> kernel(SSAO_SAMPLING_KERNEL_SIZE);
+            {
+                for (auto& sampleVector : kernel)
+                {
+                    glm::vec3 vec = glm::vec3(random(2.0f) - 1.0f, random(2.0f) - 1.0f, random(1.0f));
+                    vec = glm::normalize(vec) * random(1.0f);
+                    sampleVector = glm::vec4(vec, 1.0f);
+                };
+            }
+
+            {
+                VkBuffer stagingBuffer{};
+                VkDeviceMemory stagingBufferMemory{};
+                size_t size{ kernel.size() * sizeof(glm::vec4) };
+
+                CreateHostVisibleBuffer(a_device, a_physDevice, size, &stagingBuffer, &stagingBufferMemory);
+
+                void *mappedMemory = nullptr;
+                vkMapMemory(a_device, stagingBufferMemory, 0, size, 0, &mappedMemory);
+                memcpy(mappedMemory, kernel.data(), size);
+                vkUnmapMemory(a_device, stagingBufferMemory);
+
+                CreateDeviceLocalBuffer(a_device, a_physDevice, size, &ssaoSamplerKernel.buffer, &ssaoSamplerKernel.memory,
+                        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+                SubmitStagingBuffer(a_device, a_pool, a_queue, stagingBuffer, ssaoSamplerKernel.buffer, size);
+
+                vkFreeMemory(a_device, stagingBufferMemory, nullptr);
+                vkDestroyBuffer(a_device, stagingBuffer, nullptr);
+
+                CreateOneUBODescriptorSet(a_device, a_pDSLayout, a_dsPool, ssaoSamplerKernel.descriptorSet, ssaoSamplerKernel.buffer, size);
+            }
+
+            a_UBOs["ssao kernel"] = ssaoSamplerKernel;
+        }
+
+        static void CreateOneImageDescriptorSet(VkDevice a_device, const VkDescriptorSetLayout *a_pDSLayout, VkDescriptorPool& a_DSPool,
+                VkDescriptorSet& a_dset, VkImageView a_imageView, VkSampler a_imageSampler)
+        {
+            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+            descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            descriptorSetAllocateInfo.descriptorPool     = a_DSPool;
+            descriptorSetAllocateInfo.descriptorSetCount = 1;
+            descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+
+            if (vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, &a_dset) != VK_SUCCESS)
+                throw std::runtime_error("[CreateOneImageDescriptorSet]: failed to allocate descriptor set pool!");
+
+            WriteOneImageDescriptorSet(a_device, a_dset, a_imageView, a_imageSampler);
+        }
+
+        // also points a set at a recreated image (see RecreateCameraTargets)
+        static void WriteOneImageDescriptorSet(VkDevice a_device, VkDescriptorSet a_dset, VkImageView a_imageView, VkSampler a_imageSampler)
+        {
+            VkWriteDescriptorSet descrWrite{};
+            descrWrite.sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descrWrite.dstSet            = a_dset;
+            descrWrite.dstBinding        = 0;
+            descrWrite.dstArrayElement   = 0;
+            descrWrite.descriptorType    = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            descrWrite.descriptorCount   = 1;
+
+            VkDescriptorImageInfo        imageInfo{ a_imageSampler, a_imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+            descrWrite.pImageInfo        = &imageInfo;
+
+            vkUpdateDescriptorSets(a_device, 1, &descrWrite, 0, nullptr);
+        }
+
+        // storage images are accessed in VK_IMAGE_LAYOUT_GENERAL
+        static void CreateOneStorageImageDescriptorSet(VkDevice a_device, const VkDescriptorSetLayout *a_pDSLayout, VkDescriptorPool& a_DSPool,
+                VkDescriptorSet& a_dset, VkImageView a_imageView)
+        {
+            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+            descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            descriptorSetAllocateInfo.descriptorPool     = a_DSPool;
+            descriptorSetAllocateInfo.descriptorSetCount = 1;
+            descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+
+            if (vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, &a_dset) != VK_SUCCESS)
+                throw std::runtime_error("[CreateOneStorageImageDescriptorSet]: failed to allocate descriptor set pool!");
+
+            WriteOneStorageImageDescriptorSet(a_device, a_dset, a_imageView);
+        }
+
+        static void WriteOneStorageImageDescriptorSet(VkDevice a_device, VkDescriptorSet a_dset, VkImageView a_imageView)
+        {
+            VkWriteDescriptorSet descrWrite{};
+            descrWrite.sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descrWrite.dstSet            = a_dset;
+            descrWrite.dstBinding        = 0;
+            descrWrite.dstArrayElement   = 0;
+            descrWrite.descriptorType    = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            descrWrite.descriptorCount   = 1;
+
+            VkDescriptorImageInfo        imageInfo{ VK_NULL_HANDLE, a_imageView, VK_IMAGE_LAYOUT_GENERAL };
+            descrWrite.pImageInfo        = &imageInfo;
+
+            vkUpdateDescriptorSets(a_device, 1, &descrWrite, 0, nullptr);
+        }
+
+        // input attachments are read in the layout of the subpass that reads them, no sampler
+        static void CreateOneInputAttachmentDescriptorSet(VkDevice a_device, const VkDescriptorSetLayout *a_pDSLayout, VkDescriptorPool& a_DSPool,
+                VkDescriptorSet& a_dset, VkImageView a_imageView)
+        {
+            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+            descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            descriptorSetAllocateInfo.descriptorPool     = a_DSPool;
+            descriptorSetAllocateInfo.descriptorSetCount = 1;
+            descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+
+            if (vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, &a_dset) != VK_SUCCESS)
+                throw std::runtime_error("[CreateOneInputAttachmentDescriptorSet]: failed to allocate descriptor set pool!");
+
+            WriteOneInputAttachmentDescriptorSet(a_device, a_dset, a_imageView);
+        }
+
+        static void WriteOneInputAttachmentDescriptorSet(VkDevice a_device, VkDescriptorSet a_dset, VkImageView a_imageView)
+        {
+            VkWriteDescriptorSet descrWrite{};
+            descrWrite.sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descrWrite.dstSet            = a_dset;
+            descrWrite.dstBinding        = 0;
+            descrWrite.dstArrayElement   = 0;
+            descrWrite.descriptorType    = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            descrWrite.descriptorCount   = 1;
+
+            VkDescriptorImageInfo        imageInfo{ VK_NULL_HANDLE, a_imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+            descrWrite.pImageInfo        = &imageInfo;
+
+            vkUpdateDescriptorSets(a_device, 1, &descrWrite, 0, nullptr);
+        }
+
+        static void CreateOneStorageBufferDescriptorSet(VkDevice a_device, const VkDescriptorSetLayout *a_pDSLayout, VkDescriptorPool& a_DSPool,
+                VkDescriptorSet& a_dset, VkBuffer& a_buffer, VkDeviceSize a_bufferSize, VkDeviceSize a_offset = 0)
+        {
+            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+            descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            descriptorSetAllocateInfo.descriptorPool     = a_DSPool;
+            descriptorSetAllocateInfo.descriptorSetCount = 1;
+            descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+
+            if (vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, &a_dset) != VK_SUCCESS)
+                throw std::runtime_error("[CreateOneStorageBufferDescriptorSet]: failed to allocate descriptor set pool!");
+
+            WriteOneStorageBufferDescriptorSet(a_device, a_dset, a_buffer, a_bufferSize, a_offset);
+        }
+
+        static void WriteOneStorageBufferDescriptorSet(VkDevice a_device, VkDescriptorSet a_dset, VkBuffer a_buffer, VkDeviceSize a_bufferSize,
+                VkDeviceSize a_offset)
+        {
+            VkWriteDescriptorSet descrWrite{};
+            descrWrite.sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descrWrite.dstSet            = a_dset;
+            descrWrite.dstBinding        = 0;
+            descrWrite.dstArrayElement   = 0;
+            descrWrite.descriptorType    = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descrWrite.descriptorCount   = 1;
+
+            VkDescriptorBufferInfo bufferInfo{ a_buffer, a_offset, a_bufferSize };
+            descrWrite.pBufferInfo       = &bufferInfo;
+
+            vkUpdateDescriptorSets(a_device, 1, &descrWrite, 0, nullptr);
+        }
+
+        static void CreateStorageBufferDescriptorPool(VkDevice a_device, VkDescriptorPool& a_dsPool, uint32_t a_count)
+        {
+            VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, a_count };
+
+            VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+            descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            descriptorPoolCreateInfo.maxSets       = a_count;
+            descriptorPoolCreateInfo.poolSizeCount = 1;
+            descriptorPoolCreateInfo.pPoolSizes    = &poolSize;
+
+            if (vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, nullptr, &a_dsPool) != VK_SUCCESS)
+                throw std::runtime_error("[CreateStorageBufferDescriptorPool]: failed to create descriptor set pool!");
+        }
+
+        static void CreateInputAttachmentDescriptorPool(VkDevice a_device, VkDescriptorPool& a_dsPool, uint32_t a_count)
+        {
+            VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, a_count };
+
+            VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+            descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            descriptorPoolCreateInfo.maxSets       = a_count;
+            descriptorPoolCreateInfo.poolSizeCount = 1;
+            descriptorPoolCreateInfo.pPoolSizes    = &poolSize;
+
+            if (vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, nullptr, &a_dsPool) != VK_SUCCESS)
+                throw std::runtime_error("[CreateInputAttachmentDescriptorPool]: failed to create descriptor set pool!");
+        }
+
+        static void CreateStorageImageDescriptorPool(VkDevice a_device, VkDescriptorPool& a_dsPool, uint32_t a_count)
+        {
+            VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, a_count };
+
+            VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+            descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            descriptorPoolCreateInfo.maxSets       = a_count;
+            descriptorPoolCreateInfo.poolSizeCount = 1;
+            descriptorPoolCreateInfo.pPoolSizes    = &poolSize;
+
+            if (vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, nullptr, &a_dsPool) != VK_SUCCESS)
+                throw std::runtime_error("[CreateStorageImageDescriptorPool]: failed to create descriptor set pool!");
+        }
+
+        // this suits cubemap texture as well
+        static void CreateUBODescriptorPool(VkDevice a_device, VkDescriptorPool& a_dsPool, uint32_t a_count)
+        {
             VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, a_count };
 
-            VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
-            descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-            descriptorPoolCreateInfo.maxSets       = a_count;
-            descriptorPoolCreateInfo.poolSizeCount = 1;
-            descriptorPoolCreateInfo.pPoolSizes    = &poolSize;
+            VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+            descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            descriptorPoolCreateInfo.maxSets       = a_count;
+            descriptorPoolCreateInfo.poolSizeCount = 1;
+            descriptorPoolCreateInfo.pPoolSizes    = &poolSize;
+
+            if (vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, nullptr, &a_dsPool) != VK_SUCCESS)
+                throw std::runtime_error("[CreateUBODescriptorPool]: failed to create descriptor set pool!");
+        }
+
+        // this suits cubemap texture as well
+        static void CreateTextureDescriptorPool(VkDevice a_device, VkDescriptorPool& a_dsPool, uint32_t a_count)
+        {
+            VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, a_count };
+
+            VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+            descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            descriptorPoolCreateInfo.maxSets       = a_count;
+            descriptorPoolCreateInfo.poolSizeCount = 1;
+            descriptorPoolCreateInfo.pPoolSizes    = &poolSize;
+
+            if (vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, nullptr, &a_dsPool) != VK_SUCCESS)
+                throw std::runtime_error("[CreateTextureDescriptorPool]: failed to create descriptor set pool!");
+        }
+
+        static void CreateDSForEachModelTexture(VkDevice a_device, VkDescriptorSetLayout* a_pDSLayout, VkDescriptorPool& a_dsPool,
+                std::unordered_map<std::string, InputTexture>& a_inputTextures, std::unordered_map<std::string, Texture>& a_textures)
+        {
+            for (auto& texture : a_textures)
+            {
+                Texture* pTextureObj{ &texture.second };
+                InputTexture inputTexture{ pTextureObj, VK_NULL_HANDLE };
+
+                CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, inputTexture.descriptorSet, pTextureObj->getImageView(), pTextureObj->getSampler());
+
+                a_inputTextures[texture.first] = inputTexture;
+            }
+        }
+
+        static void CreateDSForOtherInputAttachments(VkDevice a_device, VkDescriptorSetLayout* a_pDSLayout, VkDescriptorPool& a_dsPool,
+                InputAttachments& a_inputAttachments, Attachments& a_attachments)
+
+        {
+            Texture* pShadowAtlas{ &a_attachments.shadowAtlas };
+            a_inputAttachments.shadowAtlas = InputTexture{ pShadowAtlas, VK_NULL_HANDLE };
+            CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.shadowAtlas.descriptorSet,
+                    pShadowAtlas->getImageView(), pShadowAtlas->getSampler());
+
+            Texture* pDepth{ &a_attachments.presentDepth };
+            a_inputAttachments.gDepth = InputTexture{ pDepth, VK_NULL_HANDLE };
+            CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.gDepth.descriptorSet,
+                    pDepth->getImageView(), pDepth->getSampler());
+
+            Texture* pNormals{ &a_attachments.gNormals };
+            a_inputAttachments.gNormals = InputTexture{ pNormals, VK_NULL_HANDLE };
+            CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.gNormals.descriptorSet,
+                    pNormals->getImageView(), pNormals->getSampler());
+
+            Texture* pSSAO{ &a_attachments.ssao };
+            a_inputAttachments.ssao = InputTexture{ pSSAO, VK_NULL_HANDLE };
+            CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.ssao.descriptorSet,
+                    pSSAO->getImageView(), pSSAO->getSampler());
+
+            Texture* pSSAOBlur{ &a_attachments.blurredSSAO };
+            a_inputAttachments.blurredSSAO = InputTexture{ pSSAOBlur, VK_NULL_HANDLE };
+            CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.blurredSSAO.descriptorSet,
+                    pSSAOBlur->getImageView(), pSSAOBlur->getSampler());
+
+            if (SSAO_DOWNSCALE > 1)
+            {
+                Texture* pLowResDepth{ &a_attachments.lowResDepth };
+                a_inputAttachments.lowResDepth = InputTexture{ pLowResDepth, VK_NULL_HANDLE };
+                CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.lowResDepth.descriptorSet,
+                        pLowResDepth->getImageView(), pLowResDepth->getSampler());
+
+                Texture* pLowResNormals{ &a_attachments.lowResNormals };
+                a_inputAttachments.lowResNormals = InputTexture{ pLowResNormals, VK_NULL_HANDLE };
+                CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.lowResNormals.descriptorSet,
+                        pLowResNormals->getImageView(), pLowResNormals->getSampler());
+
+                Texture* pUpsampledSSAO{ &a_attachments.upsampledSSAO };
+                a_inputAttachments.upsampledSSAO = InputTexture{ pUpsampledSSAO, VK_NULL_HANDLE };
+                CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.upsampledSSAO.descriptorSet,
+                        pUpsampledSSAO->getImageView(), pUpsampledSSAO->getSampler());
+            }
+
+            a_inputAttachments.temporalHistory.resize(a_attachments.temporalHistory.size());
+            for (size_t i{}; i < a_attachments.temporalHistory.size(); ++i)
+            {
+                Texture* pHistory{ &a_attachments.temporalHistory[i] };
+                a_inputAttachments.temporalHistory[i] = InputTexture{ pHistory, VK_NULL_HANDLE };
+                CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.temporalHistory[i].descriptorSet,
+                        pHistory->getImageView(), pHistory->getSampler());
+            }
+
+            Texture* pSceneColor{ &a_attachments.sceneColor };
+            a_inputAttachments.sceneColor = InputTexture{ pSceneColor, VK_NULL_HANDLE };
+            CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.sceneColor.descriptorSet,
+                    pSceneColor->getImageView(), pSceneColor->getSampler());
+
+            a_inputAttachments.bloomChain.resize(a_attachments.bloomChain.size());
+            for (size_t level{}; level < a_attachments.bloomChain.size(); ++level)
+            {
+                Texture* pBloomLevel{ &a_attachments.bloomChain[level] };
+                a_inputAttachments.bloomChain[level] = InputTexture{ pBloomLevel, VK_NULL_HANDLE };
+                CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.bloomChain[level].descriptorSet,
+                        pBloomLevel->getImageView(), pBloomLevel->getSampler());
+            }
+        }
+
+        static void CreateDSForParticleSystems(VkDevice a_device, VkDescriptorSetLayout* a_pDSLayout, VkDescriptorPool& a_dsPool,
+                std::unordered_map<std::string, ParticleSystem>& a_particleSystems)
+        {
+            for (auto& ps : a_particleSystems)
+            {
+                auto& system{ ps.second };
+
+                if (system.isSimulatedOnGPU())
+                {
+                    CreateOneStorageBufferDescriptorSet(a_device, a_pDSLayout, a_dsPool, system.getStorageDescriptorSet(), system.getVBO(),
+                            system.getSize());
+                    CreateOneStorageBufferDescriptorSet(a_device, a_pDSLayout, a_dsPool, system.getVisibleDescriptorSet(),
+                            system.getVisibleVBO(), system.getSize());
+                    CreateOneStorageBufferDescriptorSet(a_device, a_pDSLayout, a_dsPool, system.getIndirectDescriptorSet(),
+                            system.getIndirectBuffer(), sizeof(VkDrawIndirectCommand));
+                }
+            }
+        }
+
+        static void CreateDSForClusters(VkDevice a_device, VkDescriptorSetLayout* a_pDSLayout, VkDescriptorPool& a_dsPool,
+                Clusters& a_clusters)
+        {
+            a_clusters.lightsDS.resize(MAX_FRAMES_IN_FLIGHT);
+            for (uint32_t frame{}; frame < MAX_FRAMES_IN_FLIGHT; ++frame)
+            {
+                CreateOneStorageBufferDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_clusters.lightsDS[frame], a_clusters.lights,
+                        sizeof(PointLightsBuffer), frame * a_clusters.lightsRegionSize);
+            }
+
+            CreateOneStorageBufferDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_clusters.gridDS, a_clusters.grid, CLUSTER_GRID_SIZE);
+        }
+
+        static void CreateDSForShadowFaces(VkDevice a_device, VkDescriptorSetLayout* a_pDSLayout, VkDescriptorPool& a_dsPool,
+                Shadows& a_shadows)
+        {
+            a_shadows.facesDS.resize(MAX_FRAMES_IN_FLIGHT);
+            for (uint32_t frame{}; frame < MAX_FRAMES_IN_FLIGHT; ++frame)
+            {
+                CreateOneStorageBufferDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_shadows.facesDS[frame], a_shadows.facesBuffer,
+                        sizeof(ShadowFacesBuffer), frame * a_shadows.facesRegionSize);
+            }
+        }
+
+        static void CreateDSForHiZ(VkDevice a_device, VkDescriptorSetLayout* a_pDSLayout, VkDescriptorPool& a_dsPool, Culling& a_culling)
+        {
+            a_culling.hiZTilesDS.resize(MAX_FRAMES_IN_FLIGHT);
+            for (uint32_t frame{}; frame < MAX_FRAMES_IN_FLIGHT; ++frame)
+            {
+                CreateOneStorageBufferDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_culling.hiZTilesDS[frame], a_culling.hiZTiles,
+                        a_culling.hiZWidth * a_culling.hiZHeight * sizeof(float), frame * a_culling.hiZRegionSize);
+            }
+        }
+
+        // sets of CreateDSForHiZ are kept, they are pointed at the recreated tiles buffer
+        static void UpdateDSForHiZ(VkDevice a_device, Culling& a_culling)
+        {
+            for (uint32_t frame{}; frame < MAX_FRAMES_IN_FLIGHT; ++frame)
+            {
+                WriteOneStorageBufferDescriptorSet(a_device, a_culling.hiZTilesDS[frame], a_culling.hiZTiles,
+                        a_culling.hiZWidth * a_culling.hiZHeight * sizeof(float), frame * a_culling.hiZRegionSize);
+            }
+        }
+
+        static void CreateDSForStorageImages(VkDevice a_device, VkDescriptorSetLayout* a_pDSLayout, VkDescriptorPool& a_dsPool,
+                InputAttachments& a_inputAttachments, Attachments& a_attachments)
+        {
+            Texture* pSSAO{ &a_attachments.ssao };
+            a_inputAttachments.ssaoStorage = InputTexture{ pSSAO, VK_NULL_HANDLE };
+            CreateOneStorageImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.ssaoStorage.descriptorSet,
+                    pSSAO->getImageView());
+
+            Texture* pSSAOBlur{ &a_attachments.blurredSSAO };
+            a_inputAttachments.blurredSSAOStorage = InputTexture{ pSSAOBlur, VK_NULL_HANDLE };
+            CreateOneStorageImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.blurredSSAOStorage.descriptorSet,
+                    pSSAOBlur->getImageView());
+        }
+
+        static void CreateDSForInputAttachments(VkDevice a_device, VkDescriptorSetLayout* a_pDSLayout, VkDescriptorPool& a_dsPool,
+                InputAttachments& a_inputAttachments, Attachments& a_attachments)
+        {
+            a_inputAttachments.temporalHistoryInput.resize(a_attachments.temporalHistory.size());
+            for (size_t i{}; i < a_attachments.temporalHistory.size(); ++i)
+            {
+                Texture* pHistory{ &a_attachments.temporalHistory[i] };
+                a_inputAttachments.temporalHistoryInput[i] = InputTexture{ pHistory, VK_NULL_HANDLE };
+                CreateOneInputAttachmentDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.temporalHistoryInput[i].descriptorSet,
+                        pHistory->getImageView());
+            }
+
+            Texture* pAccumulation{ &a_attachments.oitAccumulation };
+            a_inputAttachments.oitAccumulationInput = InputTexture{ pAccumulation, VK_NULL_HANDLE };
+            CreateOneInputAttachmentDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.oitAccumulationInput.descriptorSet,
+                    pAccumulation->getImageView());
+
+            Texture* pRevealage{ &a_attachments.oitRevealage };
+            a_inputAttachments.oitRevealageInput = InputTexture{ pRevealage, VK_NULL_HANDLE };
+            CreateOneInputAttachmentDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.oitRevealageInput.descriptorSet,
+                    pRevealage->getImageView());
+        }
+
+        // sets of the three functions above are kept when the attachments are created again,
+        // they are pointed at the new images of their textures (the shadow atlas is not recreated)
+        static void UpdateDSForAttachments(VkDevice a_device, InputAttachments& a_inputAttachments)
+        {
+            std::vector<InputTexture*> sampled{ &a_inputAttachments.gDepth, &a_inputAttachments.gNormals, &a_inputAttachments.ssao,
+                &a_inputAttachments.blurredSSAO, &a_inputAttachments.sceneColor };
+            if (SSAO_DOWNSCALE > 1)
+            {
+                sampled.insert(sampled.end(), { &a_inputAttachments.lowResDepth, &a_inputAttachments.lowResNormals,
+                        &a_inputAttachments.upsampledSSAO });
+            }
+            for (auto& history : a_inputAttachments.temporalHistory)
+            {
+                sampled.push_back(&history);
+            }
+            for (auto& level : a_inputAttachments.bloomChain)
+            {
+                sampled.push_back(&level);
+            }
+            for (auto* input : sampled)
+            {
+                WriteOneImageDescriptorSet(a_device, input->descriptorSet, input->texture->getImageView(), input->texture->getSampler());
+            }
+
+            for (auto* input : { &a_inputAttachments.ssaoStorage, &a_inputAttachments.blurredSSAOStorage })
+            {
+                WriteOneStorageImageDescriptorSet(a_device, input->descriptorSet, input->texture->getImageView());
+            }
+
+            std::vector<InputTexture*> inputs{ &a_inputAttachments.oitAccumulationInput, &a_inputAttachments.oitRevealageInput };
+            for (auto& history : a_inputAttachments.temporalHistoryInput)
+            {
+                inputs.push_back(&history);
+            }
+            for (auto* input : inputs)
+            {
+                WriteOneInputAttachmentDescriptorSet(a_device, input->descriptorSet, input->texture->getImageView());
+            }
+        }
+
+        // NOTE: constant ids match layout(constant_id) of the shaders
+        static SpecializationConstants SSAOConstants(const QualitySettings& a_quality)
+        {
+            SpecializationConstants constants{};
+            constants.set(0, (int32_t)a_quality.ssaoSamplesPerFrame).set(1, SSAO_RADIUS);
+
+            return constants;
+        }
+
+        static SpecializationConstants TemporalConstants(const QualitySettings& a_quality)
+        {
+            SpecializationConstants constants{};
+            constants.set(0, (int32_t)a_quality.pcfTaps).set(1, PCF_DELTA);
+
+            return constants;
+        }
+
+        static SpecializationConstants GBufferDownsampleConstants()
+        {
+            SpecializationConstants constants{};
+            constants.set(0, (int32_t)SSAO_DOWNSCALE);
+
+            return constants;
+        }
+
+        static SpecializationConstants BloomUpsampleConstants()
+        {
+            SpecializationConstants constants{};
+            constants.set(0, BLOOM_FILTER_RADIUS);
+
+            return constants;
+        }
+
+        static SpecializationConstants ParticlesConstants()
+        {
+            SpecializationConstants constants{};
+            constants.set(0, PARTICLES_LOD_DISTANCE);
+
+            return constants;
+        }
+
+        static SpecializationConstants ParticleConstants(bool a_weightedOIT)
+        {
+            SpecializationConstants constants{};
+            constants.set(0, (int32_t)a_weightedOIT); // bool constant (VkBool32)
+
+            return constants;
+        }
+
+        // pipelines are only added to a_batch, see PipelineBatch::create
+        static void CreateGraphicsPipelines(VkDevice a_device, VkExtent2D a_screenExtent, RenderPasses a_renderPasses, DSLayouts a_dsLayouts,
+                ShaderManager& a_shaders, PipelineBatch& a_batch)
+        {
+            VertexInputDescription vertexDescr{ Vertex::getVertexDescription() };
+            VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+            vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+            vertexInputInfo.vertexBindingDescriptionCount   = vertexDescr.bindings.size();
+            vertexInputInfo.vertexAttributeDescriptionCount = vertexDescr.attributes.size();
+            vertexInputInfo.pVertexBindingDescriptions      = vertexDescr.bindings.data();
+            vertexInputInfo.pVertexAttributeDescriptions    = vertexDescr.attributes.data();
+
+            VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+            inputAssembly.sType                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+            inputAssembly.topology               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+            inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+            VkViewport viewport{};
+            viewport.x        = 0.0f;
+            viewport.y        = 0.0f;
+            viewport.width    = (float)a_screenExtent.width;
+            viewport.height   = (float)a_screenExtent.height;
+            viewport.minDepth = 0.0f;
+            viewport.maxDepth = 1.0f;
+
+            VkRect2D scissor{};
+            scissor.extent = a_screenExtent;
+
+            VkPipelineViewportStateCreateInfo viewportState{};
+            viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+            viewportState.viewportCount = 1;
+            viewportState.pViewports    = &viewport;
+            viewportState.scissorCount  = 1;
+            viewportState.pScissors     = &scissor;
+
+            VkPipelineRasterizationStateCreateInfo rasterizer{};
+            rasterizer.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+            rasterizer.depthClampEnable        = VK_FALSE;
+            rasterizer.rasterizerDiscardEnable = VK_FALSE;
+            rasterizer.polygonMode             = VK_POLYGON_MODE_FILL;
+            rasterizer.lineWidth               = 1.0f;
+            rasterizer.cullMode                = VK_CULL_MODE_BACK_BIT;
+            rasterizer.frontFace               = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+            rasterizer.depthBiasEnable         = VK_FALSE;
+
+            VkPipelineMultisampleStateCreateInfo multisampling{};
+            multisampling.sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+            multisampling.sampleShadingEnable  = VK_FALSE;
+            multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+            VkPipelineDepthStencilStateCreateInfo depthAndStencil{};
+            depthAndStencil.sType              = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+            depthAndStencil.depthTestEnable    = VK_TRUE;
+            depthAndStencil.depthWriteEnable   = VK_TRUE;
+            depthAndStencil.depthCompareOp     = VK_COMPARE_OP_LESS_OR_EQUAL;
+            depthAndStencil.depthBoundsTestEnable = VK_FALSE;
+            depthAndStencil.stencilTestEnable  = VK_FALSE;
+
+            VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+            colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+            colorBlendAttachment.blendEnable    = VK_FALSE;
+
+            VkPipelineColorBlendStateCreateInfo colorBlending{};
+            colorBlending.sType             = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+            colorBlending.logicOpEnable     = VK_FALSE;
+            colorBlending.attachmentCount   = 1;
+            colorBlending.pAttachments      = &colorBlendAttachment;
+            colorBlending.blendConstants[0] = 0.0f;
+            colorBlending.blendConstants[1] = 0.0f;
+            colorBlending.blendConstants[2] = 0.0f;
+            colorBlending.blendConstants[3] = 0.0f;
+
+            std::vector<VkPushConstantRange> pushConstants{
+                { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants) }
+            };
+
+            VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+            pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            pipelineLayoutInfo.pushConstantRangeCount = pushConstants.size();
+            pipelineLayoutInfo.pPushConstantRanges    = pushConstants.data();
+
+            std::vector<VkDynamicState> dynamicStates {
+                VK_DYNAMIC_STATE_SCISSOR, VK_DYNAMIC_STATE_VIEWPORT
+            };
+
+            VkPipelineDynamicStateCreateInfo dynamicStatesInfo{};
+            dynamicStatesInfo.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+            dynamicStatesInfo.dynamicStateCount = dynamicStates.size();
+            dynamicStatesInfo.pDynamicStates    = dynamicStates.data();
+
+            VkGraphicsPipelineCreateInfo pipelineInfo{};
+            pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            pipelineInfo.pVertexInputState   = &vertexInputInfo;
+            pipelineInfo.pInputAssemblyState = &inputAssembly;
+            pipelineInfo.pViewportState      = &viewportState;
+            pipelineInfo.pRasterizationState = &rasterizer;
+            pipelineInfo.pMultisampleState   = &multisampling;
+            pipelineInfo.pDepthStencilState  = &depthAndStencil;
+            pipelineInfo.pColorBlendState    = &colorBlending;
+            pipelineInfo.pDynamicState       = &dynamicStatesInfo;
+            pipelineInfo.subpass             = 0;
+            pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE;
+
+            VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+            vertShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            vertShaderStageInfo.stage  = VK_SHADER_STAGE_VERTEX_BIT;
+            vertShaderStageInfo.pName  = "main";
+
+            VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+            fragShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            fragShaderStageInfo.stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
+            fragShaderStageInfo.pName  = "main";
+
+            // a variant per distinct a_fragConstants, named by SpecializationConstants::variantName (presets sharing values share it)
+            auto createPipeline = [&](std::string&& a_pipeName, std::vector<VkDescriptorSetLayout>& a_dsLayouts, std::string&& a_shaderName, VkRenderPass a_renderPass,
+                    SpecializationConstants a_fragConstants = {})
+            {
+                std::string name{ a_fragConstants.variantName(a_pipeName) };
+                if (a_batch.contains(name))
+                {
+                    return;
+                }
+
+                pipelineLayoutInfo.setLayoutCount = a_dsLayouts.size();
+                if (pipelineLayoutInfo.setLayoutCount)
+                {
+                    pipelineLayoutInfo.pSetLayouts = a_dsLayouts.data();
+                }
+                else
+                {
+                    pipelineLayoutInfo.pSetLayouts = nullptr;
+                }
+
+                VkPipelineLayout pipelineLayout{};
+                if (vkCreatePipelineLayout(a_device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+                    throw std::runtime_error("[CreateGraphicsPipeline]: failed to create pipeline layout!");
+
+                auto vertShaderCode = a_shaders.load(a_shaderName + ".vert");
+                auto fragShaderCode = a_shaders.load(a_shaderName + ".frag");
+
+                vertShaderStageInfo.module = vk_utils::CreateShaderModule(a_device, vertShaderCode);
+                fragShaderStageInfo.module = vk_utils::CreateShaderModule(a_device, fragShaderCode);
+                fragShaderStageInfo.pSpecializationInfo = a_fragConstants.info(); // deep copied by the batch
+
+                std::vector<VkPipelineShaderStageCreateInfo> shaderStages {
+                    vertShaderStageInfo, fragShaderStageInfo
+                };
+
+                pipelineInfo.stageCount          = shaderStages.size();
+                pipelineInfo.pStages             = shaderStages.data();
+                pipelineInfo.layout              = pipelineLayout;
+                pipelineInfo.renderPass          = a_renderPass;
+
+                // shader modules are destroyed by the batch
+                a_batch.addGraphics(name, pipelineInfo, { a_shaderName + ".vert", a_shaderName + ".frag" });
+            };
+
+            // render meshes ///////////////////////////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> sceneDSLayouts{
+                a_dsLayouts.textureOnlyLayout,      // texture sapmler (for models)
+                    a_dsLayouts.textureOnlyLayout,  // shadow atlas
+                    a_dsLayouts.inputAttachmentOnlyLayout, // accumulated ssao and shadows (subpass #0)
+                    a_dsLayouts.storageBufferOnlyLayout, // point lights
+                    a_dsLayouts.storageBufferOnlyLayout, // light clusters
+                    a_dsLayouts.storageBufferOnlyLayout  // shadow faces (of the shadowed point lights)
+            };
+            if (DEPTH_PREPASS_REUSE)
+            {
+                depthAndStencil.depthWriteEnable = VK_FALSE;
+                depthAndStencil.depthCompareOp   = VK_COMPARE_OP_EQUAL;
+            }
+
+            pipelineInfo.subpass = 1;
+            createPipeline("scene", sceneDSLayouts, "scene", a_renderPasses.scenePass);
+            pipelineInfo.subpass = 0;
+
+            depthAndStencil.depthWriteEnable = VK_TRUE;
+            depthAndStencil.depthCompareOp   = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+            // fill gbuffer ////////////////////////////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> gBufferDSLayouts(0);
+            createPipeline("g buffer", gBufferDSLayouts, "gbuffer", a_renderPasses.gBufferCreationPass);
+
+            // render a face of the shadow atlas ///////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> shadowCubemapDSLayout(0);
+            createPipeline("shadow cubemap", shadowCubemapDSLayout, "shadowmap", a_renderPasses.shadowCubemapPass);
+
+            rasterizer.cullMode = VK_CULL_MODE_NONE;
+            // display shadow atlas ////////////////////////////////////////////////////
+            VkVertexInputBindingDescription   inputBindings{ 0, sizeof(float) * 2, VK_VERTEX_INPUT_RATE_VERTEX };
+            VkVertexInputAttributeDescription attributes{ 0, 0, VK_FORMAT_R32G32_SFLOAT, 0 };
+            vertexInputInfo = VkPipelineVertexInputStateCreateInfo{};
+            vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+            vertexInputInfo.vertexBindingDescriptionCount   = 1;
+            vertexInputInfo.vertexAttributeDescriptionCount = 1;
+            vertexInputInfo.pVertexBindingDescriptions      = &inputBindings;
+            vertexInputInfo.pVertexAttributeDescriptions    = &attributes;
+
+            std::vector<VkDescriptorSetLayout> showShadowAtlasDSLayout{ a_dsLayouts.textureOnlyLayout };
+            createPipeline("show shadow atlas", showShadowAtlasDSLayout, "showshadowatlas", a_renderPasses.finalRenderPass);
+
+            // calculate ssao //////////////////////////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> ssaoDSLayout{
+                a_dsLayouts.textureOnlyLayout, // depth
+                    a_dsLayouts.textureOnlyLayout, // normals
+                    a_dsLayouts.textureOnlyLayout, // noise
+                    a_dsLayouts.uboOnlyLayout      // full of sampling vectors
+            };
+
+            for (uint32_t preset{}; preset < QUALITY_PRESET_COUNT; ++preset)
+            {
+                createPipeline("ssao", ssaoDSLayout, "ssao", a_renderPasses.ssaoPass, SSAOConstants(QUALITY_SETTINGS[preset]));
+            }
+
+            // blur ssao ///////////////////////////////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> ssaoBlurDSLayout{
+                a_dsLayouts.textureOnlyLayout  // ssao
+            };
+
+            createPipeline("blur ssao", ssaoBlurDSLayout, "blur", a_renderPasses.ssaoBlurPass); //TODO:
+
+            // low resolution ssao /////////////////////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> gBufferDownsampleDSLayout{
+                a_dsLayouts.textureOnlyLayout, // depth
+                    a_dsLayouts.textureOnlyLayout  // normals
+            };
+
+            std::vector<VkPipelineColorBlendAttachmentState> blendAttachmentStates(2, colorBlendAttachment);
+            colorBlending.attachmentCount = blendAttachmentStates.size();
+            colorBlending.pAttachments    = blendAttachmentStates.data();
+
+            createPipeline("g buffer downsample", gBufferDownsampleDSLayout, "gbufferdownsample", a_renderPasses.gBufferDownsamplePass,
+                    GBufferDownsampleConstants());
+
+            colorBlending.attachmentCount = 1;
+            colorBlending.pAttachments    = &colorBlendAttachment;
+
+            std::vector<VkDescriptorSetLayout> ssaoUpsampleDSLayout{
+                a_dsLayouts.textureOnlyLayout, // low resolution blurred ssao
+                    a_dsLayouts.textureOnlyLayout, // depth
+                    a_dsLayouts.textureOnlyLayout  // low resolution depth
+            };
+
+            createPipeline("ssao upsample", ssaoUpsampleDSLayout, "ssaoupsample", a_renderPasses.ssaoBlurPass);
+
+            // temporal accumulation of ssao and shadows ///////////////////////////////
+            std::vector<VkDescriptorSetLayout> temporalDSLayout{
+                a_dsLayouts.textureOnlyLayout, // ssao of this frame
+                    a_dsLayouts.textureOnlyLayout, // depth
+                    a_dsLayouts.textureOnlyLayout, // shadow atlas
+                    a_dsLayouts.textureOnlyLayout, // history
+                    a_dsLayouts.storageBufferOnlyLayout // shadow faces
+            };
+
+            for (uint32_t preset{}; preset < QUALITY_PRESET_COUNT; ++preset)
+            {
+                createPipeline("temporal", temporalDSLayout, "temporal", a_renderPasses.scenePass, TemporalConstants(QUALITY_SETTINGS[preset])); // subpass #0
+            }
+
+            // bloom mip chain /////////////////////////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> bloomDSLayouts{
+                a_dsLayouts.textureOnlyLayout  // scene color or previous mip level
+            };
+
+            createPipeline("bloom extract", bloomDSLayouts, "bloomextract", a_renderPasses.bloomDownsamplePass);
+            createPipeline("bloom downsample", bloomDSLayouts, "bloomdownsample", a_renderPasses.bloomDownsamplePass);
+
+            // compose hdr scene and bloom /////////////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> presentDSLayouts{
+                a_dsLayouts.textureOnlyLayout, // scene color
+                    a_dsLayouts.textureOnlyLayout  // bloom
+            };
+
+            createPipeline("present", presentDSLayouts, "present", a_renderPasses.finalRenderPass);
+
+            depthAndStencil.depthWriteEnable         = VK_FALSE;
+            colorBlendAttachment.blendEnable         = VK_TRUE;
+
+            colorBlendAttachment.colorBlendOp        = VK_BLEND_OP_ADD;
+            colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+            colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+
+            colorBlendAttachment.alphaBlendOp        = VK_BLEND_OP_ADD;
+            colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_DST_ALPHA;
+
+            createPipeline("bloom upsample", bloomDSLayouts, "bloomupsample", a_renderPasses.bloomUpsamplePass, BloomUpsampleConstants());
+
+            // composite weighted blended particles ////////////////////////////////////
+            // (average color, 1 - revealage) over scene color, alpha of scene color is left untouched
+            colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+            colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+            colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+
+            std::vector<VkDescriptorSetLayout> particleCompositeDSLayouts{
+                a_dsLayouts.inputAttachmentOnlyLayout, // accumulation (subpass #2)
+                    a_dsLayouts.inputAttachmentOnlyLayout  // revealage
+            };
+            pipelineInfo.subpass = 3;
+            createPipeline("particle composite", particleCompositeDSLayouts, "oitcomposite", a_renderPasses.scenePass);
+            pipelineInfo.subpass = 0;
+
+            // render particle system //////////////////////////////////////////////////
+            vertexDescr = ParticleSystem::getVertexDescription();
+            vertexInputInfo = VkPipelineVertexInputStateCreateInfo{};
+            vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+            vertexInputInfo.vertexBindingDescriptionCount   = vertexDescr.bindings.size();
+            vertexInputInfo.vertexAttributeDescriptionCount = vertexDescr.attributes.size();
+            vertexInputInfo.pVertexBindingDescriptions      = vertexDescr.bindings.data();
+            vertexInputInfo.pVertexAttributeDescriptions    = vertexDescr.attributes.data();
+
+            // fire is emissive: purely additive blending is commutative, so particles need no sorting (cpu or gpu)
+            // and can be drawn in any order; alpha of scene color is left untouched
+            colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+            colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+
+            colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+            colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+
+            inputAssembly.topology                   = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+
+            std::vector<VkDescriptorSetLayout> particleSystemDSLayout{ a_dsLayouts.textureOnlyLayout };
+            pipelineInfo.subpass = 1;
+            createPipeline("particle system", particleSystemDSLayout, "particle", a_renderPasses.scenePass, ParticleConstants(false));
+
+            // weighted blended variant (subpass #2): weighted colors and coverages are summed,
+            // revealage is multiplied by (1 - coverage) of every particle
+            colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+
+            VkPipelineColorBlendAttachmentState revealageBlendAttachment{ colorBlendAttachment };
+            revealageBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+            revealageBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
+
+            std::vector<VkPipelineColorBlendAttachmentState> oitBlendAttachmentStates{ colorBlendAttachment, revealageBlendAttachment };
+            colorBlending.attachmentCount = oitBlendAttachmentStates.size();
+            colorBlending.pAttachments    = oitBlendAttachmentStates.data();
+
+            pipelineInfo.subpass = 2;
+            createPipeline("particle system", particleSystemDSLayout, "particle", a_renderPasses.scenePass, ParticleConstants(true));
+            pipelineInfo.subpass = 0;
+
+            colorBlending.attachmentCount = 1;
+            colorBlending.pAttachments    = &colorBlendAttachment;
+
+            // particle billboards in the shadow faces /////////////////////////////////
+            // alpha tested, so they write depth and distance like meshes do
+            colorBlendAttachment.blendEnable = VK_FALSE;
+            depthAndStencil.depthWriteEnable = VK_TRUE;
+
+            createPipeline("particle shadow", particleSystemDSLayout, "particleshadow", a_renderPasses.shadowCubemapPass);
+        }
+
+        static void CreateComputePipelines(VkDevice a_device, DSLayouts a_dsLayouts, ShaderManager& a_shaders, PipelineBatch& a_batch)
+        {
+            std::vector<VkPushConstantRange> pushConstants{
+                { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants) }
+            };
+
+            VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+            pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            pipelineLayoutInfo.pushConstantRangeCount = pushConstants.size();
+            pipelineLayoutInfo.pPushConstantRanges    = pushConstants.data();
+
+            VkPipelineShaderStageCreateInfo compShaderStageInfo{};
+            compShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            compShaderStageInfo.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+            compShaderStageInfo.pName  = "main";
+
+            VkComputePipelineCreateInfo pipelineInfo{};
+            pipelineInfo.sType              = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+            auto createPipeline = [&](std::string&& a_pipeName, std::vector<VkDescriptorSetLayout>& a_dsLayouts, std::string&& a_shaderName,
+                    SpecializationConstants a_constants = {})
+            {
+                std::string name{ a_constants.variantName(a_pipeName) };
+                if (a_batch.contains(name))
+                {
+                    return;
+                }
+
+                pipelineLayoutInfo.setLayoutCount = a_dsLayouts.size();
+                pipelineLayoutInfo.pSetLayouts    = a_dsLayouts.data();
+
+                VkPipelineLayout pipelineLayout{};
+                if (vkCreatePipelineLayout(a_device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+                    throw std::runtime_error("[CreateComputePipelines]: failed to create pipeline layout!");
+
+                auto compShaderCode = a_shaders.load(a_shaderName + ".comp");
+
+                compShaderStageInfo.module              = vk_utils::CreateShaderModule(a_device, compShaderCode);
+                compShaderStageInfo.pSpecializationInfo = a_constants.info();
+
+                pipelineInfo.stage  = compShaderStageInfo;
+                pipelineInfo.layout = pipelineLayout;
+
+                // shader module is destroyed by the batch
+                a_batch.addCompute(name, pipelineInfo, a_shaderName + ".comp");
+            };
+
+            // calculate ssao //////////////////////////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> ssaoDSLayout{
+                a_dsLayouts.textureOnlyLayout, // depth
+                    a_dsLayouts.textureOnlyLayout, // normals
+                    a_dsLayouts.textureOnlyLayout, // noise
+                    a_dsLayouts.uboOnlyLayout,     // full of sampling vectors
+                    a_dsLayouts.storageImageOnlyLayout // ssao (output)
+            };
+
+            for (uint32_t preset{}; preset < QUALITY_PRESET_COUNT; ++preset)
+            {
+                createPipeline("ssao compute", ssaoDSLayout, "ssao", SSAOConstants(QUALITY_SETTINGS[preset]));
+            }
+
+            // blur ssao ///////////////////////////////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> ssaoBlurDSLayout{
+                a_dsLayouts.textureOnlyLayout,     // ssao
+                    a_dsLayouts.storageImageOnlyLayout // blurred ssao (output)
+            };
+
+            createPipeline("blur ssao compute", ssaoBlurDSLayout, "blur");
+
+            // simulate particles //////////////////////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> particlesDSLayout{
+                a_dsLayouts.storageBufferOnlyLayout // particles (updated in place)
+            };
+
+            createPipeline("particles compute", particlesDSLayout, "particles", ParticlesConstants());
+
+            // cull and compact particles //////////////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> particlesCullDSLayout{
+                a_dsLayouts.storageBufferOnlyLayout,   // particles
+                    a_dsLayouts.storageBufferOnlyLayout, // visible particles (output)
+                    a_dsLayouts.storageBufferOnlyLayout  // indirect draw command (output)
+            };
+
+            createPipeline("particles cull compute", particlesCullDSLayout, "particlescull", ParticlesConstants());
+
+            // bin point lights into clusters //////////////////////////////////////////
+            std::vector<VkDescriptorSetLayout> clustersDSLayout{
+                a_dsLayouts.storageBufferOnlyLayout,   // point lights
+                    a_dsLayouts.storageBufferOnlyLayout  // light clusters (output)
+            };
+
+            createPipeline("clusters compute", clustersDSLayout, "clusters");
+
+            // max depth tiles for occlusion culling ///////////////////////////////////
+            std::vector<VkDescriptorSetLayout> hiZDSLayout{
+                a_dsLayouts.textureOnlyLayout,         // g buffer depth
+                    a_dsLayouts.storageBufferOnlyLayout  // hi-z tiles (output)
+            };
+
+            createPipeline("hi-z compute", hiZDSLayout, "hiz");
+        }
+
+        static void CreateEyes(std::unordered_map<std::string, Eye*>& a_eyes, Timer* a_pTimer)
+        {
+            Camera* camera = new Camera{a_pTimer};
+            a_eyes["camera"] = camera;
+
+            Light* light = new Light{a_pTimer};
+            a_eyes["light"] = light;
+
+            for (uint32_t i{}; i < SHADOW_POINT_LIGHTS; ++i)
+            {
+                a_eyes["point light " + std::to_string(i)] = new PointLightEye{a_pTimer};
+            }
+        }
+
+        static void CreateScreenFrameBuffers(VkDevice a_device, VkRenderPass a_renderPass, vk_utils::ScreenBufferResources* pScreen)
+        {
+            pScreen->swapChainFramebuffers.resize(pScreen->swapChainImageViews.size());
+
+            for (size_t i = 0; i < pScreen->swapChainImageViews.size(); i++) 
+            {
+                std::vector<VkImageView> attachments{
+                    pScreen->swapChainImageViews[i]
+                };
+
+                VkFramebufferCreateInfo framebufferInfo = {};
+                framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+                framebufferInfo.renderPass      = a_renderPass;
+                framebufferInfo.attachmentCount = attachments.size();
+                framebufferInfo.pAttachments    = attachments.data();
+                framebufferInfo.width           = pScreen->swapChainExtent.width;
+                framebufferInfo.height          = pScreen->swapChainExtent.height;
+                framebufferInfo.layers          = 1;
+
+                if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &pScreen->swapChainFramebuffers[i]) != VK_SUCCESS)
+                    throw std::runtime_error("failed to create framebuffer!");
+            }
+        }
+
+        // one for each history texture (written one alternates every frame)
+        static void CreateSceneFrameBuffers(VkDevice a_device, VkRenderPass a_renderPass, std::vector<VkFramebuffer>& a_frameBuffers,
+                Attachments& a_attachments)
+        {
+            a_frameBuffers.resize(a_attachments.temporalHistory.size());
+
+            for (size_t i{}; i < a_attachments.temporalHistory.size(); ++i)
+            {
+                std::vector<VkImageView> attachments {
+                    a_attachments.temporalHistory[i].getImageView(),
+                        a_attachments.sceneColor.getImageView(),
+                        a_attachments.presentDepth.getImageView(),
+                        a_attachments.oitAccumulation.getImageView(),
+                        a_attachments.oitRevealage.getImageView()
+                };
+
+                VkFramebufferCreateInfo framebufferInfo = {};
+                framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+                framebufferInfo.renderPass      = a_renderPass;
+                framebufferInfo.attachmentCount = attachments.size();
+                framebufferInfo.pAttachments    = attachments.data();
+                framebufferInfo.width           = a_attachments.sceneColor.getExtent().width;
+                framebufferInfo.height          = a_attachments.sceneColor.getExtent().height;
+                framebufferInfo.layers          = 1;
+
+                if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffers[i]) != VK_SUCCESS)
+                    throw std::runtime_error("failed to create framebuffer!");
+            }
+        }
+
+        // downsample and upsample render passes are compatible, so one framebuffer per level suits both
+        // one single attachment framebuffer for each texture (bloom mip chain)
+        static void CreateFrameBuffersForEachTexture(VkDevice a_device, VkRenderPass a_renderPass, std::vector<VkFramebuffer>& a_frameBuffers,
+                std::vector<Texture>& a_textures)
+        {
+            a_frameBuffers.resize(a_textures.size());
+
+            for (size_t level{}; level < a_textures.size(); ++level)
+            {
+                Texture& texture{ a_textures[level] };
+
+                std::vector<VkImageView> attachments {
+                    texture.getImageView()
+                };
+
+                VkFramebufferCreateInfo framebufferInfo = {};
+                framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+                framebufferInfo.renderPass      = a_renderPass;
+                framebufferInfo.attachmentCount = attachments.size();
+                framebufferInfo.pAttachments    = attachments.data();
+                framebufferInfo.width           = texture.getExtent().width;
+                framebufferInfo.height          = texture.getExtent().height;
+                framebufferInfo.layers          = 1;
+
+                if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffers[level]) != VK_SUCCESS)
+                    throw std::runtime_error("failed to create framebuffer!");
+            }
+        }
+
+
+        static void CreateSSAOFrameBuffer(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer& a_frameBuffer, Attachments& a_attachments)
+        {
+            std::vector<VkImageView> attachments {
+                a_attachments.ssao.getImageView(),
+            };
+
+            VkFramebufferCreateInfo framebufferInfo = {};
+            framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass      = a_renderPass;
+            framebufferInfo.attachmentCount = attachments.size();
+            framebufferInfo.pAttachments    = attachments.data();
+            framebufferInfo.width           = a_attachments.ssao.getExtent().width;
+            framebufferInfo.height          = a_attachments.ssao.getExtent().height;
+            framebufferInfo.layers          = 1;
+
+            if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffer) != VK_SUCCESS)
+                throw std::runtime_error("failed to create framebuffer!");
+        }
+
+        static void CreateSSAOBlurFrameBuffer(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer& a_frameBuffer, Attachments& a_attachments)
+        {
+            std::vector<VkImageView> attachments {
+                a_attachments.blurredSSAO.getImageView(),
+            };
+
+            VkFramebufferCreateInfo framebufferInfo = {};
+            framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass      = a_renderPass;
+            framebufferInfo.attachmentCount = attachments.size();
+            framebufferInfo.pAttachments    = attachments.data();
+            framebufferInfo.width           = a_attachments.blurredSSAO.getExtent().width;
+            framebufferInfo.height          = a_attachments.blurredSSAO.getExtent().height;
+            framebufferInfo.layers          = 1;
+
+            if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffer) != VK_SUCCESS)
+                throw std::runtime_error("failed to create framebuffer!");
+        }
+
+        static void CreateSSAOUpsampleFrameBuffer(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer& a_frameBuffer, Attachments& a_attachments)
+        {
+            std::vector<VkImageView> attachments {
+                a_attachments.upsampledSSAO.getImageView(),
+            };
+
+            VkFramebufferCreateInfo framebufferInfo = {};
+            framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass      = a_renderPass;
+            framebufferInfo.attachmentCount = attachments.size();
+            framebufferInfo.pAttachments    = attachments.data();
+            framebufferInfo.width           = a_attachments.upsampledSSAO.getExtent().width;
+            framebufferInfo.height          = a_attachments.upsampledSSAO.getExtent().height;
+            framebufferInfo.layers          = 1;
+
+            if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffer) != VK_SUCCESS)
+                throw std::runtime_error("failed to create framebuffer!");
+        }
+
+        static void CreateGBufferDownsampleFrameBuffer(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer& a_frameBuffer,
+                Attachments& a_attachments)
+        {
+            std::vector<VkImageView> attachments {
+                a_attachments.lowResDepth.getImageView(),
+                    a_attachments.lowResNormals.getImageView()
+            };
+
+            VkFramebufferCreateInfo framebufferInfo = {};
+            framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass      = a_renderPass;
+            framebufferInfo.attachmentCount = attachments.size();
+            framebufferInfo.pAttachments    = attachments.data();
+            framebufferInfo.width           = a_attachments.lowResDepth.getExtent().width;
+            framebufferInfo.height          = a_attachments.lowResDepth.getExtent().height;
+            framebufferInfo.layers          = 1;
+
+            if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffer) != VK_SUCCESS)
+                throw std::runtime_error("failed to create framebuffer!");
+        }
+
+        static void CreateGBufferFrameBuffer(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer& a_frameBuffer, Attachments& a_attachments)
+        {
+            std::vector<VkImageView> attachments {
+                a_attachments.gNormals.getImageView(),
+                    a_attachments.presentDepth.getImageView()
+            };
+
+            VkFramebufferCreateInfo framebufferInfo = {};
+            framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass      = a_renderPass;
+            framebufferInfo.attachmentCount = attachments.size();
+            framebufferInfo.pAttachments    = attachments.data();
+            framebufferInfo.width           = a_attachments.gNormals.getExtent().width;
+            framebufferInfo.height          = a_attachments.gNormals.getExtent().height;
+            framebufferInfo.layers          = 1;
+
+            if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffer) != VK_SUCCESS)
+                throw std::runtime_error("failed to create framebuffer!");
+        }
+
+        static void CreateShadowCubemapFrameBuffer(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer& a_frameBuffer, Attachments& a_attachments)
+        {
+            std::vector<VkImageView> attachments {
+                a_attachments.offscreenColor.getImageView(),
+                    a_attachments.offscreenDepth.getImageView(),
+            };
 
-            if (vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, nullptr, &a_dsPool) != VK_SUCCESS)
-                throw std::runtime_error("[CreateUBODescriptorPool]: failed to create descriptor set pool!");
+            VkFramebufferCreateInfo framebufferInfo = {};
+            framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass      = a_renderPass;
+            framebufferInfo.attachmentCount = attachments.size();
+            framebufferInfo.pAttachments    = attachments.data();
+            framebufferInfo.width           = SHADOW_MAX_FACE_SIDE;
+            framebufferInfo.height          = SHADOW_MAX_FACE_SIDE;
+            framebufferInfo.layers          = 1;
+
+            if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffer) != VK_SUCCESS)
+                throw std::runtime_error("failed to create framebuffer!");
         }
 
-        // this suits cubemap texture as well
-        static void CreateTextureDescriptorPool(VkDevice a_device, VkDescriptorPool& a_dsPool, uint32_t a_count)
+        static void RecordCommandsOfShowingShadowAtlas(VkDevice a_device, Mesh a_squareMesh, VkCommandBuffer a_cmdBuffer, const Pipe* a_atlasPipe,
+                InputTexture a_atlas)
         {
-            VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, a_count };
+            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_atlasPipe->pipeline);
 
-            VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
-            descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-            descriptorPoolCreateInfo.maxSets       = a_count;
-            descriptorPoolCreateInfo.poolSizeCount = 1;
-            descriptorPoolCreateInfo.pPoolSizes    = &poolSize;
+            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_atlasPipe->pipelineLayout, 0, 1,
+                    &a_atlas.descriptorSet, 0, nullptr);
 
-            if (vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, nullptr, &a_dsPool) != VK_SUCCESS)
-                throw std::runtime_error("[CreateTextureDescriptorPool]: failed to create descriptor set pool!");
+            VkBuffer vbo{ a_squareMesh.getVBO().buffer };
+            VkBuffer ibo{ a_squareMesh.getIBO().buffer };
+
+            std::vector<VkDeviceSize> offsets{ 0 };
+
+            vkCmdBindVertexBuffers(a_cmdBuffer, 0, 1, &vbo, offsets.data());
+            vkCmdBindIndexBuffer(a_cmdBuffer, ibo, 0, VK_INDEX_TYPE_UINT32);
+
+            vkCmdDrawIndexed(a_cmdBuffer, 6, 1, 0, 0, 0);
         }
 
-        static void CreateDSForEachModelTexture(VkDevice a_device, VkDescriptorSetLayout* a_pDSLayout, VkDescriptorPool& a_dsPool,
-                std::unordered_map<std::string, InputTexture>& a_inputTextures, std::unordered_map<std::string, Texture>& a_textures)
+        // particles of gpu simulated systems are updated and respawned in place,
+        // then the live ones inside the view frustum are compacted into the visible buffer that is drawn indirectly
+        static void RecordCommandsOfUpdatingParticleSystems(VkCommandBuffer a_cmdBuffer, Pipe& a_pipe, Pipe& a_cullPipe,
+                std::unordered_map<std::string, ParticleSystem>& a_particleSystems, Eye* a_camera, uint32_t a_frame)
         {
-            for (auto& texture : a_textures)
+            for (auto& particleSystem : a_particleSystems)
             {
-                Texture* pTextureObj{ &texture.second };
-                InputTexture inputTexture{ pTextureObj, VK_NULL_HANDLE };
+                auto& system{ particleSystem.second };
 
-                CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, inputTexture.descriptorSet, pTextureObj->getImageView(), pTextureObj->getSampler());
+                if (!system.isSimulatedOnGPU())
+                {
+                    continue;
+                }
 
-                a_inputTextures[texture.first] = inputTexture;
+                VkBufferMemoryBarrier bufBar{};
+                bufBar.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                bufBar.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                bufBar.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                bufBar.buffer              = system.getVBO();
+                bufBar.offset              = 0;
+                bufBar.size                = VK_WHOLE_SIZE;
+
+                // previous frame still may be culling the particles or drawing their shadows
+                bufBar.srcAccessMask = 0;
+                bufBar.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+                vkCmdPipelineBarrier(a_cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &bufBar, 0, nullptr);
+
+                vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipe.pipeline);
+
+                vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipe.pipelineLayout, 0, 1,
+                        &(system.getStorageDescriptorSet()), 0, nullptr);
+
+                // lightPos, emission and frame slots carry emmiter position, time step and random seed (view for lod)
+                PushConstants constants{};
+                constants.view     = a_camera->view(0);
+                constants.lightPos = system.getEmmiterPos();
+                constants.emission = system.getTimeElapsed();
+                constants.frame    = a_frame;
+
+                vkCmdPushConstants(a_cmdBuffer, a_pipe.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &constants);
+
+                uint32_t groupCount{ (system.getParticleCount() + PARTICLES_COMPUTE_GROUP - 1) / PARTICLES_COMPUTE_GROUP };
+                vkCmdDispatch(a_cmdBuffer, groupCount, 1, 1);
+
+                // previous frame still may be drawing the visible particles
+                VkBufferMemoryBarrier visibleBar{ bufBar };
+                visibleBar.buffer        = system.getVisibleVBO();
+                visibleBar.srcAccessMask = 0;
+                visibleBar.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                vkCmdPipelineBarrier(a_cmdBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                        0, nullptr, 1, &visibleBar, 0, nullptr);
+
+                VkBufferMemoryBarrier indirectBar{ bufBar };
+                indirectBar.buffer        = system.getIndirectBuffer();
+                indirectBar.srcAccessMask = 0;
+                indirectBar.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                vkCmdPipelineBarrier(a_cmdBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                        0, nullptr, 1, &indirectBar, 0, nullptr);
+
+                VkDrawIndirectCommand drawCommand{ 0, 1, 0, 0 }; // vertexCount is counted by particlescull.comp
+                vkCmdUpdateBuffer(a_cmdBuffer, system.getIndirectBuffer(), 0, sizeof(VkDrawIndirectCommand), &drawCommand);
+
+                bufBar.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                bufBar.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                indirectBar.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                indirectBar.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+                std::vector<VkBufferMemoryBarrier> cullInputBars{ bufBar, indirectBar };
+                vkCmdPipelineBarrier(a_cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, cullInputBars.size(), cullInputBars.data(), 0, nullptr);
+
+                vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, a_cullPipe.pipeline);
+
+                std::vector<VkDescriptorSet> cullSets{ system.getStorageDescriptorSet(), system.getVisibleDescriptorSet(),
+                    system.getIndirectDescriptorSet() };
+                vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, a_cullPipe.pipelineLayout, 0, cullSets.size(),
+                        cullSets.data(), 0, nullptr);
+
+                // lightPos slot carries the rendered region in pixels and the point size scale of particle.vert
+                // (projection() maps the frustum onto the region, renderProjection() only moves it into the targets)
+                glm::vec2 region{ a_camera->getTargetSize() * a_camera->getRenderScale() };
+
+                PushConstants cullConstants{};
+                cullConstants.view       = a_camera->view(0);
+                cullConstants.projection = a_camera->projection();
+                cullConstants.lightPos   = glm::vec3(region, PointSizeScale(a_camera));
+
+                vkCmdPushConstants(a_cmdBuffer, a_cullPipe.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants),
+                        &cullConstants);
+
+                vkCmdDispatch(a_cmdBuffer, groupCount, 1, 1);
+
+                visibleBar.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                visibleBar.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+                vkCmdPipelineBarrier(a_cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0,
+                        0, nullptr, 1, &visibleBar, 0, nullptr);
+
+                indirectBar.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                indirectBar.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+                vkCmdPipelineBarrier(a_cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0,
+                        0, nullptr, 1, &indirectBar, 0, nullptr);
+
+                // all particles are drawn into the shadow faces
+                bufBar.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                bufBar.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+                vkCmdPipelineBarrier(a_cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0,
+                        0, nullptr, 1, &bufBar, 0, nullptr);
             }
-            
-            s_blackTexutreDS = a_inputTextures["black"].descriptorSet;
         }
 
-        static void CreateDSForOtherInputAttachments(VkDevice a_device, VkDescriptorSetLayout* a_pDSLayout, VkDescriptorPool& a_dsPool,
-                InputAttachments& a_inputAttachments, Attachments& a_attachments)
-
+        // froxel grid of the camera: every cluster gets indices of the point lights whose spheres touch it
+        static void RecordCommandsOfBuildingClusters(VkCommandBuffer a_cmdBuffer, Pipe& a_pipe, Clusters& a_clusters, Eye* a_camera,
+                uint32_t a_frame)
         {
-            CubeTexture* pCubemapTexture{ &a_attachments.shadowCubemap };
-            a_inputAttachments.shadowCubemap = InputCubeTexture{ pCubemapTexture, VK_NULL_HANDLE };
-            CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.shadowCubemap.descriptorSet,
-                    pCubemapTexture->getImageView(), pCubemapTexture->getSampler());
-
-            Texture* pPositionAndDepth{ &a_attachments.gPositionAndDepth };
-            a_inputAttachments.gPositionAndDepth = InputTexture{ pPositionAndDepth, VK_NULL_HANDLE };
-            CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.gPositionAndDepth.descriptorSet,
-                    pPositionAndDepth->getImageView(), pPositionAndDepth->getSampler());
+            VkBufferMemoryBarrier bufBar{};
+            bufBar.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            bufBar.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufBar.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufBar.buffer              = a_clusters.grid;
+            bufBar.offset              = 0;
+            bufBar.size                = VK_WHOLE_SIZE;
+
+            // previous frame still may be shading with the clusters
+            bufBar.srcAccessMask = 0;
+            bufBar.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            vkCmdPipelineBarrier(a_cmdBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                    0, nullptr, 1, &bufBar, 0, nullptr);
+
+            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipe.pipeline);
+
+            std::vector<VkDescriptorSet> sets{ a_clusters.lightsDS[a_frame], a_clusters.gridDS };
+            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipe.pipelineLayout, 0, sets.size(), sets.data(),
+                    0, nullptr);
 
-            Texture* pNormals{ &a_attachments.gNormals };
-            a_inputAttachments.gNormals = InputTexture{ pNormals, VK_NULL_HANDLE };
-            CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.gNormals.descriptorSet,
-                    pNormals->getImageView(), pNormals->getSampler());
+            PushConstants constants{};
+            constants.view       = a_camera->view(0);
+            constants.projection = a_camera->renderProjection(); // froxels follow the pixels of the scene pass
 
-            Texture* pSSAO{ &a_attachments.ssao };
-            a_inputAttachments.ssao = InputTexture{ pSSAO, VK_NULL_HANDLE };
-            CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.ssao.descriptorSet,
-                    pSSAO->getImageView(), pSSAO->getSampler());
+            vkCmdPushConstants(a_cmdBuffer, a_pipe.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &constants);
 
-            Texture* pSSAOBlur{ &a_attachments.blurredSSAO };
-            a_inputAttachments.blurredSSAO = InputTexture{ pSSAOBlur, VK_NULL_HANDLE };
-            CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.blurredSSAO.descriptorSet,
-                    pSSAOBlur->getImageView(), pSSAOBlur->getSampler());
+            vkCmdDispatch(a_cmdBuffer, 1, 1, CLUSTER_Z); // work group is one depth slice
 
-            Texture* pBloom{ &a_attachments.bloom };
-            a_inputAttachments.bloom = InputTexture{ pBloom, VK_NULL_HANDLE };
-            CreateOneImageDescriptorSet(a_device, a_pDSLayout, a_dsPool, a_inputAttachments.bloom.descriptorSet,
-                    pBloom->getImageView(), pBloom->getSampler());
+            bufBar.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            bufBar.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier(a_cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                    0, nullptr, 1, &bufBar, 0, nullptr);
         }
 
-        static void CreateGraphicsPipelines(VkDevice a_device, VkExtent2D a_screenExtent, RenderPasses a_renderPasses,
-                std::unordered_map<std::string, Pipe>& a_pipes, DSLayouts a_dsLayouts)
+        // a_frame: frame in flight, cpu reads its region of tiles after the fence of the frame signals
+        static void RecordCommandsOfBuildingHiZ(VkCommandBuffer a_cmdBuffer, Pipe& a_pipe, Culling& a_culling, InputAttachments& a_attachments,
+                uint32_t a_frame)
         {
-            VertexInputDescription vertexDescr{ Vertex::getVertexDescription() };
-            VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-            vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-            vertexInputInfo.vertexBindingDescriptionCount   = vertexDescr.bindings.size();
-            vertexInputInfo.vertexAttributeDescriptionCount = vertexDescr.attributes.size();
-            vertexInputInfo.pVertexBindingDescriptions      = vertexDescr.bindings.data();
-            vertexInputInfo.pVertexAttributeDescriptions    = vertexDescr.attributes.data();
+            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipe.pipeline);
+
+            std::vector<VkDescriptorSet> sets{ a_attachments.gDepth.descriptorSet, a_culling.hiZTilesDS[a_frame] };
+            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipe.pipelineLayout, 0, sets.size(), sets.data(),
+                    0, nullptr);
+
+            vkCmdDispatch(a_cmdBuffer, a_culling.hiZWidth, a_culling.hiZHeight, 1); // work group is one tile
+
+            VkBufferMemoryBarrier bufBar{};
+            bufBar.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            bufBar.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufBar.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufBar.buffer              = a_culling.hiZTiles;
+            bufBar.offset              = a_frame * a_culling.hiZRegionSize;
+            bufBar.size                = a_culling.hiZRegionSize;
+            bufBar.srcAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+            bufBar.dstAccessMask       = VK_ACCESS_HOST_READ_BIT;
+            vkCmdPipelineBarrier(a_cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                    0, nullptr, 1, &bufBar, 0, nullptr);
+        }
 
-            VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-            inputAssembly.sType                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-            inputAssembly.topology               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-            inputAssembly.primitiveRestartEnable = VK_FALSE;
+        static void RecordCommandsOfDrawingParticleSystems(std::unordered_map<std::string, ParticleSystem>& a_particleSystems, VkCommandBuffer a_cmdBuffer,
+                Pipe& a_pipe, Eye* a_eye, uint32_t a_frame)
+        {
+            VkPipeline&       pipeline = a_pipe.pipeline;
+            VkPipelineLayout& layout   = a_pipe.pipelineLayout;
 
-            VkViewport viewport{};
-            viewport.x        = 0.0f;
-            viewport.y        = 0.0f;
-            viewport.width    = (float)a_screenExtent.width;
-            viewport.height   = (float)a_screenExtent.height;
-            viewport.minDepth = 0.0f;
-            viewport.maxDepth = 1.0f;
+            for (auto& particleSystem : a_particleSystems)
+            {
+                auto& system{ particleSystem.second };
 
-            VkRect2D scissor{};
-            scissor.extent = a_screenExtent;
+                vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
-            VkPipelineViewportStateCreateInfo viewportState{};
-            viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-            viewportState.viewportCount = 1;
-            viewportState.pViewports    = &viewport;
-            viewportState.scissorCount  = 1;
-            viewportState.pScissors     = &scissor;
+                vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &(system.getTexture()->descriptorSet), 0, nullptr);
 
-            VkPipelineRasterizationStateCreateInfo rasterizer{};
-            rasterizer.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-            rasterizer.depthClampEnable        = VK_FALSE;
-            rasterizer.rasterizerDiscardEnable = VK_FALSE;
-            rasterizer.polygonMode             = VK_POLYGON_MODE_FILL;
-            rasterizer.lineWidth               = 1.0f;
-            rasterizer.cullMode                = VK_CULL_MODE_BACK_BIT;
-            rasterizer.frontFace               = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-            rasterizer.depthBiasEnable         = VK_FALSE;
+                // lightPos slot carries render scale and point size scale
+                PushConstants constants{};
+                constants.model      = glm::mat4(1.0f);
+                constants.view       = a_eye->view(0);
+                constants.projection = a_eye->renderProjection();
+                constants.lightPos   = glm::vec3(a_eye->getRenderScale(), PointSizeScale(a_eye));
 
-            VkPipelineMultisampleStateCreateInfo multisampling{};
-            multisampling.sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-            multisampling.sampleShadingEnable  = VK_FALSE;
-            multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+                vkCmdPushConstants(a_cmdBuffer, layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &constants);
 
-            VkPipelineDepthStencilStateCreateInfo depthAndStencil{};
-            depthAndStencil.sType              = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-            depthAndStencil.depthTestEnable    = VK_TRUE;
-            depthAndStencil.depthWriteEnable   = VK_TRUE;
-            depthAndStencil.depthCompareOp     = VK_COMPARE_OP_LESS_OR_EQUAL;
-            depthAndStencil.depthBoundsTestEnable = VK_FALSE;
-            depthAndStencil.stencilTestEnable  = VK_FALSE;
+                if (system.isSimulatedOnGPU())
+                {
+                    VkDeviceSize offsets[1] = { 0 };
+                    vkCmdBindVertexBuffers(a_cmdBuffer, 0, 1, &(system.getVisibleVBO()), offsets);
 
-            VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-            colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-            colorBlendAttachment.blendEnable    = VK_FALSE;
+                    vkCmdDrawIndirect(a_cmdBuffer, system.getIndirectBuffer(), 0, 1, sizeof(VkDrawIndirectCommand));
+                }
+                else
+                {
+                    VkDeviceSize offsets[1] = { system.getVertexOffset(a_frame) };
+                    vkCmdBindVertexBuffers(a_cmdBuffer, 0, 1, &(system.getVBO()), offsets);
 
-            VkPipelineColorBlendStateCreateInfo colorBlending{};
-            colorBlending.sType             = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-            colorBlending.logicOpEnable     = VK_FALSE;
-            colorBlending.attachmentCount   = 1;
-            colorBlending.pAttachments      = &colorBlendAttachment;
-            colorBlending.blendConstants[0] = 0.0f;
-            colorBlending.blendConstants[1] = 0.0f;
-            colorBlending.blendConstants[2] = 0.0f;
-            colorBlending.blendConstants[3] = 0.0f;
+                    vkCmdDraw(a_cmdBuffer, system.getParticleCount(), 1, 0, 0);
+                }
+            }
+        }
 
-            std::vector<VkPushConstantRange> pushConstants{
-                { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants) }
-            };
+        static void RecordCommandsOfDrawingRenderables(const std::vector<const RenderObject*>& a_objects, VkCommandBuffer a_cmdBuffer,
+                const Pipe* a_specialPipeline, Eye* a_eye, glm::vec3 a_lightPos, InputTexture a_shadowAtlas, InputTexture a_SSAOmap,
+                uint32_t a_face, bool a_bindTextures, glm::vec3 a_lightColor = glm::vec3(1.0f))
+        {
+            bool  specialPipeline{ a_specialPipeline != nullptr };
+            Mesh* previousMesh{nullptr};
+            Pipe* previousPipe{nullptr};
 
-            VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-            pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-            pipelineLayoutInfo.pushConstantRangeCount = pushConstants.size();
-            pipelineLayoutInfo.pPushConstantRanges    = pushConstants.data();
+            if (specialPipeline)
+            {
+                vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_specialPipeline->pipeline);
+            }
 
-            std::vector<VkDynamicState> dynamicStates {
-                VK_DYNAMIC_STATE_SCISSOR, VK_DYNAMIC_STATE_VIEWPORT
-            };
+            for (const RenderObject* pObject : a_objects)
+            {
+                const auto& obj{ *pObject };
 
-            VkPipelineDynamicStateCreateInfo dynamicStatesInfo{};
-            dynamicStatesInfo.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-            dynamicStatesInfo.dynamicStateCount = dynamicStates.size();
-            dynamicStatesInfo.pDynamicStates    = dynamicStates.data();
+                const VkPipeline&       pipeline = (!specialPipeline) ? obj.pipe->pipeline       : a_specialPipeline->pipeline;
+                const VkPipelineLayout& pLayout  = (!specialPipeline) ? obj.pipe->pipelineLayout : a_specialPipeline->pipelineLayout;
 
-            VkGraphicsPipelineCreateInfo pipelineInfo{};
-            pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-            pipelineInfo.pVertexInputState   = &vertexInputInfo;
-            pipelineInfo.pInputAssemblyState = &inputAssembly;
-            pipelineInfo.pViewportState      = &viewportState;
-            pipelineInfo.pRasterizationState = &rasterizer;
-            pipelineInfo.pMultisampleState   = &multisampling;
-            pipelineInfo.pDepthStencilState  = &depthAndStencil;
-            pipelineInfo.pColorBlendState    = &colorBlending;
-            pipelineInfo.pDynamicState       = &dynamicStatesInfo;
-            pipelineInfo.subpass             = 0;
-            pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE;
+                if (!specialPipeline && obj.pipe != previousPipe)
+                {
+                    vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                    previousPipe = obj.pipe;
+                }
 
-            VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-            vertShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-            vertShaderStageInfo.stage  = VK_SHADER_STAGE_VERTEX_BIT;
-            vertShaderStageInfo.pName  = "main";
+                std::vector<VkDescriptorSet> setsToBind(0);
 
-            VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-            fragShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-            fragShaderStageInfo.stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
-            fragShaderStageInfo.pName  = "main";
+                if (a_bindTextures)
+                {
+                    setsToBind.push_back(obj.texture->descriptorSet); // #0
+                }
+                if (a_shadowAtlas.texture != nullptr)
+                {
+                    setsToBind.push_back(a_shadowAtlas.descriptorSet); // #1
+                    if (a_SSAOmap.texture != nullptr)
+                    {
+                        setsToBind.push_back(a_SSAOmap.descriptorSet); // #2
+                    }
+                }
 
-            auto createPipeline = [&](std::string&& a_pipeName, std::vector<VkDescriptorSetLayout>& a_dsLayouts, std::string&& a_shaderName, VkRenderPass a_renderPass)
-            {
-                pipelineLayoutInfo.setLayoutCount = a_dsLayouts.size();
-                if (pipelineLayoutInfo.setLayoutCount)
+                if (setsToBind.size())
                 {
-                    pipelineLayoutInfo.pSetLayouts = a_dsLayouts.data();
+                    vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pLayout, 0,
+                            setsToBind.size(),
+                            setsToBind.data(),
+                            0, nullptr);
                 }
-                else
+
+                PushConstants constants{};
+                constants.model      = obj.matrix;
+                constants.view       = a_eye->view(a_face);
+                constants.projection = a_eye->renderProjection();
+                constants.lightPos   = a_lightPos;
+                constants.emission   = (obj.bloom) ? BLOOM_EMISSION : 0.0f;
+                constants.lightColor = glm::vec4(a_lightColor, 1.0f);
+
+                vkCmdPushConstants(a_cmdBuffer, pLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &constants);
+
+                if (obj.mesh != previousMesh)
                 {
-                    pipelineLayoutInfo.pSetLayouts = nullptr;
+                    std::vector<VkBuffer> vertexBuffers{ obj.mesh->getVBO().buffer };
+                    VkBuffer indexBuffers{ obj.mesh->getIBO().buffer };
+                    std::vector<VkDeviceSize> offsets{ 0 };
+
+                    vkCmdBindVertexBuffers(a_cmdBuffer, 0, vertexBuffers.size(), vertexBuffers.data(), offsets.data());
+                    vkCmdBindIndexBuffer(a_cmdBuffer, indexBuffers, 0, VK_INDEX_TYPE_UINT32);
+                    previousMesh = obj.mesh;
                 }
 
-                VkPipelineLayout pipelineLayout{};
-                if (vkCreatePipelineLayout(a_device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
-                    throw std::runtime_error("[CreateGraphicsPipeline]: failed to create pipeline layout!");
+                vkCmdDrawIndexed(a_cmdBuffer, obj.mesh->indices.size(), 1, 0, 0, 0);
+            }
+        }
+
+        static void RecordCommandsOfFillingGBuffer(VkFramebuffer a_frameBuffer, VkRenderPass a_renderPass, Pipe a_pipe,
+                VkCommandBuffer a_cmdBuff, const std::vector<const RenderObject*>& a_objects, Eye* a_camera, VkExtent3D a_extent)
+        {
+            std::vector<VkClearValue> clearValues(2);
+            clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+            clearValues[1].depthStencil = { 1.0f, 0 };
+
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass        = a_renderPass;
+            renderPassInfo.framebuffer       = a_frameBuffer;
+            renderPassInfo.renderArea.offset = { 0, 0 };
+            renderPassInfo.renderArea.extent = { a_extent.width, a_extent.height };
+            renderPassInfo.clearValueCount   = clearValues.size();
+            renderPassInfo.pClearValues      = clearValues.data();
 
-                std::string fileName{};
+            vkCmdBeginRenderPass(a_cmdBuff, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-                fileName = "shaders/.vert.spv";
-                fileName.insert(fileName.find("."), a_shaderName);
-                auto vertShaderCode = vk_utils::ReadFile(fileName.c_str());
+            RecordCommandsOfDrawingRenderables(a_objects, a_cmdBuff, &a_pipe, a_camera, glm::vec3(0.0f), InputTexture{},
+                    InputTexture{}, 0, false);
 
-                fileName = "shaders/.frag.spv";
-                fileName.insert(fileName.find("."), a_shaderName);
-                auto fragShaderCode = vk_utils::ReadFile(fileName.c_str());
+            vkCmdEndRenderPass(a_cmdBuff);
+        }
 
-                vertShaderStageInfo.module = vk_utils::CreateShaderModule(a_device, vertShaderCode);
-                fragShaderStageInfo.module = vk_utils::CreateShaderModule(a_device, fragShaderCode);
+        static void RecordCommandsOfSSAOEvaluation(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer a_frameBuffer,
+                Mesh a_squareMesh, VkCommandBuffer a_cmdBuffer, Pipe a_pipe, InputAttachments& a_attachments,
+                InputTexture& a_noiceTexture, UniformBuffer& a_ssaoKernel, glm::mat4 a_projMatrix, uint32_t a_frame)
+        {
+            std::vector<VkClearValue> clearValues(2);
+            clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+            clearValues[1].depthStencil = { 1.0f, 0 };
 
-                std::vector<VkPipelineShaderStageCreateInfo> shaderStages {
-                    vertShaderStageInfo, fragShaderStageInfo
-                };
+            VkExtent3D extent{ a_attachments.ssao.texture->getExtent() };
 
-                pipelineInfo.stageCount          = shaderStages.size();
-                pipelineInfo.pStages             = shaderStages.data();
-                pipelineInfo.layout              = pipelineLayout;
-                pipelineInfo.renderPass          = a_renderPass;
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass        = a_renderPass;
+            renderPassInfo.framebuffer       = a_frameBuffer;
+            renderPassInfo.renderArea.offset = { 0, 0 };
+            renderPassInfo.renderArea.extent = { extent.width, extent.height };
+            renderPassInfo.clearValueCount   = clearValues.size();
+            renderPassInfo.pClearValues      = clearValues.data();
 
-                VkPipeline pipeline{};
-                if (vkCreateGraphicsPipelines(a_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
-                    throw std::runtime_error("[CreateGraphicsPipeline]: failed to create graphics pipeline!");
-                a_pipes[a_pipeName] = Pipe{ pipeline, pipelineLayout };
+            vkCmdBeginRenderPass(a_cmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-                vkDestroyShaderModule(a_device, fragShaderStageInfo.module, nullptr);
-                vkDestroyShaderModule(a_device, vertShaderStageInfo.module, nullptr);
-            };
+            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipeline);
 
-            // render meshes ///////////////////////////////////////////////////////////
-            std::vector<VkDescriptorSetLayout> sceneDSLayouts{
-                a_dsLayouts.textureOnlyLayout,      // texture sapmler (for models)
-                    a_dsLayouts.textureOnlyLayout,  // shadow map
-                    a_dsLayouts.textureOnlyLayout   // ssao map
-            };
-            createPipeline("scene", sceneDSLayouts, "scene", a_renderPasses.finalRenderPass);
+            bool lowRes{ SSAO_DOWNSCALE > 1 };
 
-            std::vector<VkDescriptorSetLayout> bloomDSLayouts{
-                a_dsLayouts.textureOnlyLayout // texture sapmler (for models)
-            };
-            createPipeline("bloom", bloomDSLayouts, "bloom", a_renderPasses.bloomPass);
+            std::vector<VkDescriptorSet> setsToBind(0);
+            setsToBind.push_back((lowRes) ? a_attachments.lowResDepth.descriptorSet : a_attachments.gDepth.descriptorSet);
+            setsToBind.push_back((lowRes) ? a_attachments.lowResNormals.descriptorSet : a_attachments.gNormals.descriptorSet);
+            setsToBind.push_back(a_noiceTexture.descriptorSet);
+            setsToBind.push_back(a_ssaoKernel.descriptorSet);
 
-            // fill gbuffer ////////////////////////////////////////////////////////////
-            std::vector<VkPipelineColorBlendAttachmentState> blendAttachmentStates(2);
-            for (auto& blend : blendAttachmentStates)
-            {
-                blend.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-                blend.blendEnable    = VK_FALSE;
-            }
+            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipelineLayout, 0,
+                    setsToBind.size(), setsToBind.data(), 0, nullptr);
 
-            colorBlending.attachmentCount = blendAttachmentStates.size();
-            colorBlending.pAttachments    = blendAttachmentStates.data();
+            VkBuffer vbo{ a_squareMesh.getVBO().buffer };
+            VkBuffer ibo{ a_squareMesh.getIBO().buffer };
 
-            std::vector<VkDescriptorSetLayout> gBufferDSLayouts(0);
-            createPipeline("g buffer", gBufferDSLayouts, "gbuffer", a_renderPasses.gBufferCreationPass);
+            std::vector<VkDeviceSize> offsets{ 0 };
 
-            blendAttachmentStates = std::vector<VkPipelineColorBlendAttachmentState>(0);
-            colorBlending.attachmentCount   = 1;
-            colorBlending.pAttachments      = &colorBlendAttachment;
+            vkCmdBindVertexBuffers(a_cmdBuffer, 0, 1, &vbo, offsets.data());
+            vkCmdBindIndexBuffer(a_cmdBuffer, ibo, 0, VK_INDEX_TYPE_UINT32);
 
-            // render to cubemap face //////////////////////////////////////////////////
-            std::vector<VkDescriptorSetLayout> shadowCubemapDSLayout(0);
-            createPipeline("shadow cubemap", shadowCubemapDSLayout, "shadowmap", a_renderPasses.shadowCubemapPass);
+            PushConstants constants{};
+            constants.projection = a_projMatrix;
+            constants.frame      = a_frame;
 
-            rasterizer.cullMode = VK_CULL_MODE_NONE;
-            // display cubemap faces ///////////////////////////////////////////////////
-            VkVertexInputBindingDescription   inputBindings{ 0, sizeof(float) * 2, VK_VERTEX_INPUT_RATE_VERTEX };
-            VkVertexInputAttributeDescription attributes{ 0, 0, VK_FORMAT_R32G32_SFLOAT, 0 };
-            vertexInputInfo = VkPipelineVertexInputStateCreateInfo{};
-            vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-            vertexInputInfo.vertexBindingDescriptionCount   = 1;
-            vertexInputInfo.vertexAttributeDescriptionCount = 1;
-            vertexInputInfo.pVertexBindingDescriptions      = &inputBindings;
-            vertexInputInfo.pVertexAttributeDescriptions    = &attributes;
+            vkCmdPushConstants(a_cmdBuffer, a_pipe.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &constants);
 
-            std::vector<VkDescriptorSetLayout> showCubemapDSLayout{ a_dsLayouts.textureOnlyLayout };
-            createPipeline("show cubemap", showCubemapDSLayout, "showcubemap", a_renderPasses.finalRenderPass);
+            vkCmdDrawIndexed(a_cmdBuffer, 6, 1, 0, 0, 0);
 
-            // calculate ssao //////////////////////////////////////////////////////////
-            std::vector<VkDescriptorSetLayout> ssaoDSLayout{
-                a_dsLayouts.textureOnlyLayout, // position
-                    a_dsLayouts.textureOnlyLayout, // normals
-                    a_dsLayouts.textureOnlyLayout, // noise
-                    a_dsLayouts.uboOnlyLayout      // full of sampling vectors
-            };
+            vkCmdEndRenderPass(a_cmdBuffer);
+        }
 
-            createPipeline("ssao", ssaoDSLayout, "ssao", a_renderPasses.ssaoPass);
+        static void RecordCommandsOfBluringSSAO(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer a_frameBuffer,
+                Mesh a_squareMesh, VkCommandBuffer a_cmdBuffer, Pipe a_pipe, InputTexture& a_ssao, glm::vec2 a_renderScale)
+        {
+            std::vector<VkClearValue> clearValues(2);
+            clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+            clearValues[1].depthStencil = { 1.0f, 0 };
 
-            // blur ssao ///////////////////////////////////////////////////////////////
-            std::vector<VkDescriptorSetLayout> ssaoBlurDSLayout{
-                a_dsLayouts.textureOnlyLayout  // ssao
-            };
+            VkExtent3D extent{ a_ssao.texture->getExtent() };
 
-            createPipeline("blur ssao", ssaoBlurDSLayout, "blur", a_renderPasses.ssaoBlurPass); //TODO:
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass        = a_renderPass;
+            renderPassInfo.framebuffer       = a_frameBuffer;
+            renderPassInfo.renderArea.offset = { 0, 0 };
+            renderPassInfo.renderArea.extent = { extent.width, extent.height };
+            renderPassInfo.clearValueCount   = clearValues.size();
+            renderPassInfo.pClearValues      = clearValues.data();
 
-            // blur bloom //////////////////////////////////////////////////////////////
-            std::vector<VkDescriptorSetLayout> bloomBlurDSLayout{
-                a_dsLayouts.textureOnlyLayout  // bloom
-            };
+            vkCmdBeginRenderPass(a_cmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-            depthAndStencil.depthWriteEnable         = VK_FALSE;
-            colorBlendAttachment.blendEnable         = VK_TRUE;
+            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipeline);
 
-            colorBlendAttachment.colorBlendOp        = VK_BLEND_OP_ADD;
-            colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-            colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+            std::vector<VkDescriptorSet> setsToBind{ a_ssao.descriptorSet };
 
-            colorBlendAttachment.alphaBlendOp        = VK_BLEND_OP_ADD;
-            colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-            colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_DST_ALPHA;
+            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipelineLayout, 0,
+                    setsToBind.size(), setsToBind.data(), 0, nullptr);
 
-            createPipeline("blur bloom", bloomBlurDSLayout, "gauss", a_renderPasses.finalRenderPass);
+            VkBuffer vbo{ a_squareMesh.getVBO().buffer };
+            VkBuffer ibo{ a_squareMesh.getIBO().buffer };
 
-            // render particle system //////////////////////////////////////////////////
-            vertexDescr = ParticleSystem::getVertexDescription();
-            vertexInputInfo = VkPipelineVertexInputStateCreateInfo{};
-            vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-            vertexInputInfo.vertexBindingDescriptionCount   = vertexDescr.bindings.size();
-            vertexInputInfo.vertexAttributeDescriptionCount = vertexDescr.attributes.size();
-            vertexInputInfo.pVertexBindingDescriptions      = vertexDescr.bindings.data();
-            vertexInputInfo.pVertexAttributeDescriptions    = vertexDescr.attributes.data();
+            std::vector<VkDeviceSize> offsets{ 0 };
 
-            colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-            colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            vkCmdBindVertexBuffers(a_cmdBuffer, 0, 1, &vbo, offsets.data());
+            vkCmdBindIndexBuffer(a_cmdBuffer, ibo, 0, VK_INDEX_TYPE_UINT32);
 
-            colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-            colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+            // lightPos slot carries the part of the ssao written by this frame, in uv
+            PushConstants constants{};
+            constants.lightPos = glm::vec3((float)ScaledSize(extent.width, a_renderScale.x) / extent.width,
+                    (float)ScaledSize(extent.height, a_renderScale.y) / extent.height, 0.0f);
 
-            inputAssembly.topology                   = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+            vkCmdPushConstants(a_cmdBuffer, a_pipe.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &constants);
 
-            std::vector<VkDescriptorSetLayout> particleSystemDSLayout{ a_dsLayouts.textureOnlyLayout };
-            createPipeline("particle system", particleSystemDSLayout, "particle", a_renderPasses.finalRenderPass);
+            vkCmdDrawIndexed(a_cmdBuffer, 6, 1, 0, 0, 0);
+
+            vkCmdEndRenderPass(a_cmdBuffer);
         }
 
-        static void CreateEyes(std::unordered_map<std::string, Eye*>& a_eyes, Timer* a_pTimer)
+        // compute path of RecordCommandsOfSSAOEvaluation (occluder depths of a tile are cached in shared memory)
+        static void RecordCommandsOfSSAOEvaluationCompute(VkCommandBuffer a_cmdBuffer, Pipe& a_pipe, InputAttachments& a_attachments,
+                InputTexture& a_noiceTexture, UniformBuffer& a_ssaoKernel, glm::mat4 a_projMatrix, uint32_t a_frame, glm::vec2 a_renderScale)
         {
-            Camera* camera = new Camera{a_pTimer};
-            a_eyes["camera"] = camera;
+            VkExtent3D extent{ a_attachments.ssao.texture->getExtent() };
 
-            Light* light = new Light{a_pTimer};
-            a_eyes["light"] = light;
-        }
+            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipe.pipeline);
 
-        static void CreateScreenFrameBuffers(VkDevice a_device, VkRenderPass a_renderPass, vk_utils::ScreenBufferResources* pScreen,
-                Attachments& a_attachments)
-        {
-            pScreen->swapChainFramebuffers.resize(pScreen->swapChainImageViews.size());
+            bool lowRes{ SSAO_DOWNSCALE > 1 };
 
-            for (size_t i = 0; i < pScreen->swapChainImageViews.size(); i++) 
-            {
-                std::vector<VkImageView> attachments{
-                    pScreen->swapChainImageViews[i],
-                    a_attachments.presentDepth.getImageView()
-                };
+            std::vector<VkDescriptorSet> setsToBind(0);
+            setsToBind.push_back((lowRes) ? a_attachments.lowResDepth.descriptorSet : a_attachments.gDepth.descriptorSet);
+            setsToBind.push_back((lowRes) ? a_attachments.lowResNormals.descriptorSet : a_attachments.gNormals.descriptorSet);
+            setsToBind.push_back(a_noiceTexture.descriptorSet);
+            setsToBind.push_back(a_ssaoKernel.descriptorSet);
+            setsToBind.push_back(a_attachments.ssaoStorage.descriptorSet);
 
-                VkFramebufferCreateInfo framebufferInfo = {};
-                framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-                framebufferInfo.renderPass      = a_renderPass;
-                framebufferInfo.attachmentCount = attachments.size();
-                framebufferInfo.pAttachments    = attachments.data();
-                framebufferInfo.width           = pScreen->swapChainExtent.width;
-                framebufferInfo.height          = pScreen->swapChainExtent.height;
-                framebufferInfo.layers          = 1;
+            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipe.pipelineLayout, 0,
+                    setsToBind.size(), setsToBind.data(), 0, nullptr);
 
-                if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &pScreen->swapChainFramebuffers[i]) != VK_SUCCESS)
-                    throw std::runtime_error("failed to create framebuffer!");
-            }
+            PushConstants constants{};
+            constants.projection = a_projMatrix;
+            constants.frame      = a_frame;
+
+            vkCmdPushConstants(a_cmdBuffer, a_pipe.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &constants);
+
+            vkCmdDispatch(a_cmdBuffer, (ScaledSize(extent.width, a_renderScale.x) + SSAO_COMPUTE_TILE - 1) / SSAO_COMPUTE_TILE,
+                    (ScaledSize(extent.height, a_renderScale.y) + SSAO_COMPUTE_TILE - 1) / SSAO_COMPUTE_TILE, 1);
         }
 
-        static void CreateBloomFrameBuffer(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer& a_frameBuffer, Attachments& a_attachments)
+        // compute path of RecordCommandsOfBluringSSAO (separable box blur, both passes in shared memory)
+        static void RecordCommandsOfBluringSSAOCompute(VkCommandBuffer a_cmdBuffer, Pipe& a_pipe, InputAttachments& a_attachments,
+                glm::vec2 a_renderScale)
         {
-            std::vector<VkImageView> attachments {
-                a_attachments.bloom.getImageView(),
-                    a_attachments.bloomDepth.getImageView()
-            };
+            VkExtent3D extent{ a_attachments.ssao.texture->getExtent() };
 
-            VkFramebufferCreateInfo framebufferInfo = {};
-            framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferInfo.renderPass      = a_renderPass;
-            framebufferInfo.attachmentCount = attachments.size();
-            framebufferInfo.pAttachments    = attachments.data();
-            framebufferInfo.width           = BLOOM_DIM;
-            framebufferInfo.height          = BLOOM_DIM;
-            framebufferInfo.layers          = 1;
+            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipe.pipeline);
 
-            if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffer) != VK_SUCCESS)
-                throw std::runtime_error("failed to create framebuffer!");
-        }
+            std::vector<VkDescriptorSet> setsToBind{ a_attachments.ssao.descriptorSet, a_attachments.blurredSSAOStorage.descriptorSet };
 
+            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipe.pipelineLayout, 0,
+                    setsToBind.size(), setsToBind.data(), 0, nullptr);
 
-        static void CreateSSAOFrameBuffer(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer& a_frameBuffer, Attachments& a_attachments)
-        {
-            std::vector<VkImageView> attachments {
-                a_attachments.ssao.getImageView(),
-            };
+            // lightPos slot carries the texels of the ssao written by this frame
+            PushConstants constants{};
+            constants.lightPos = glm::vec3((float)ScaledSize(extent.width, a_renderScale.x), (float)ScaledSize(extent.height, a_renderScale.y), 0.0f);
 
-            VkFramebufferCreateInfo framebufferInfo = {};
-            framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferInfo.renderPass      = a_renderPass;
-            framebufferInfo.attachmentCount = attachments.size();
-            framebufferInfo.pAttachments    = attachments.data();
-            framebufferInfo.width           = WIDTH;
-            framebufferInfo.height          = HEIGHT;
-            framebufferInfo.layers          = 1;
+            vkCmdPushConstants(a_cmdBuffer, a_pipe.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &constants);
 
-            if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffer) != VK_SUCCESS)
-                throw std::runtime_error("failed to create framebuffer!");
+            vkCmdDispatch(a_cmdBuffer, (ScaledSize(extent.width, a_renderScale.x) + SSAO_COMPUTE_TILE - 1) / SSAO_COMPUTE_TILE,
+                    (ScaledSize(extent.height, a_renderScale.y) + SSAO_COMPUTE_TILE - 1) / SSAO_COMPUTE_TILE, 1);
         }
 
-        static void CreateSSAOBlurFrameBuffer(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer& a_frameBuffer, Attachments& a_attachments)
+        // one (the farthest) of the neighbouring g buffer texels is picked, so no positions are invented on depth edges
+        static void RecordCommandsOfDownsamplingGBuffer(VkRenderPass a_renderPass, VkFramebuffer a_frameBuffer, Mesh a_squareMesh,
+                VkCommandBuffer a_cmdBuffer, Pipe& a_pipe, InputAttachments& a_attachments)
         {
-            std::vector<VkImageView> attachments {
-                a_attachments.blurredSSAO.getImageView(),
-            };
+            VkExtent3D extent{ a_attachments.lowResDepth.texture->getExtent() };
 
-            VkFramebufferCreateInfo framebufferInfo = {};
-            framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferInfo.renderPass      = a_renderPass;
-            framebufferInfo.attachmentCount = attachments.size();
-            framebufferInfo.pAttachments    = attachments.data();
-            framebufferInfo.width           = WIDTH;
-            framebufferInfo.height          = HEIGHT;
-            framebufferInfo.layers          = 1;
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass        = a_renderPass;
+            renderPassInfo.framebuffer       = a_frameBuffer;
+            renderPassInfo.renderArea.offset = { 0, 0 };
+            renderPassInfo.renderArea.extent = { extent.width, extent.height };
+            renderPassInfo.clearValueCount   = 0;
+            renderPassInfo.pClearValues      = nullptr;
 
-            if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffer) != VK_SUCCESS)
-                throw std::runtime_error("failed to create framebuffer!");
+            vkCmdBeginRenderPass(a_cmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+            RecordCommandsOfDrawingQuad(a_squareMesh, a_cmdBuffer, a_pipe,
+                    { a_attachments.gDepth.descriptorSet, a_attachments.gNormals.descriptorSet });
+
+            vkCmdEndRenderPass(a_cmdBuffer);
         }
 
-        static void CreateGBufferFrameBuffer(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer& a_frameBuffer, Attachments& a_attachments)
+        // joint bilateral upsample: low resolution texels with depth far from the full resolution one get small weights
+        static void RecordCommandsOfUpsamplingSSAO(VkRenderPass a_renderPass, VkFramebuffer a_frameBuffer, Mesh a_squareMesh,
+                VkCommandBuffer a_cmdBuffer, Pipe& a_pipe, InputAttachments& a_attachments, glm::mat4 a_projMatrix)
         {
-            std::vector<VkImageView> attachments {
-                a_attachments.gPositionAndDepth.getImageView(),
-                    a_attachments.gNormals.getImageView(),
-                    a_attachments.presentDepth.getImageView()
-            };
+            // blur render pass clears its attachment
+            VkClearValue colorClear;
+            colorClear.color = { { 1.0f, 1.0f, 1.0f, 1.0f } };
 
-            VkFramebufferCreateInfo framebufferInfo = {};
-            framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferInfo.renderPass      = a_renderPass;
-            framebufferInfo.attachmentCount = attachments.size();
-            framebufferInfo.pAttachments    = attachments.data();
-            framebufferInfo.width           = WIDTH;
-            framebufferInfo.height          = HEIGHT;
-            framebufferInfo.layers          = 1;
+            VkExtent3D extent{ a_attachments.upsampledSSAO.texture->getExtent() };
 
-            if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffer) != VK_SUCCESS)
-                throw std::runtime_error("failed to create framebuffer!");
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass        = a_renderPass;
+            renderPassInfo.framebuffer       = a_frameBuffer;
+            renderPassInfo.renderArea.offset = { 0, 0 };
+            renderPassInfo.renderArea.extent = { extent.width, extent.height };
+            renderPassInfo.clearValueCount   = 1;
+            renderPassInfo.pClearValues      = &colorClear;
+
+            vkCmdBeginRenderPass(a_cmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+            // projection is needed to compare depths in view space
+            PushConstants constants{};
+            constants.projection = a_projMatrix;
+
+            vkCmdPushConstants(a_cmdBuffer, a_pipe.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &constants);
+
+            RecordCommandsOfDrawingQuad(a_squareMesh, a_cmdBuffer, a_pipe,
+                    { a_attachments.blurredSSAO.descriptorSet, a_attachments.gDepth.descriptorSet,
+                    a_attachments.lowResDepth.descriptorSet });
+
+            vkCmdEndRenderPass(a_cmdBuffer);
         }
 
-        static void CreateShadowCubemapFrameBuffer(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer& a_frameBuffer, Attachments& a_attachments)
+        // ssao of this frame + shadows with a few rotated taps are blended with the reprojected history of the previous frame
+        // (history is rejected on disocclusion, so the written texture is history[a_frame % 2] and the read one is the other)
+        // recorded inside subpass #0 of the scene pass, the framebuffer decides which history is written
+        // shadows are looked up in the atlas regions of a_shadowFaces (faces as they were last rendered)
+        static void RecordCommandsOfTemporalAccumulation(Mesh a_squareMesh, VkCommandBuffer a_cmdBuffer, Pipe& a_pipe,
+                InputTexture& a_ssao, InputAttachments& a_attachments, VkDescriptorSet a_shadowFaces, Eye* a_camera,
+                glm::mat4 a_prevViewProjection, uint32_t a_frame, bool a_resetHistory)
         {
-            std::vector<VkImageView> attachments {
-                a_attachments.offscreenColor.getImageView(),
-                    a_attachments.offscreenDepth.getImageView(),
-            };
+            size_t previous{ (a_frame + 1) % a_attachments.temporalHistory.size() };
 
-            VkFramebufferCreateInfo framebufferInfo = {};
-            framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferInfo.renderPass      = a_renderPass;
-            framebufferInfo.attachmentCount = attachments.size();
-            framebufferInfo.pAttachments    = attachments.data();
-            framebufferInfo.width           = CUBE_SIDE;
-            framebufferInfo.height          = CUBE_SIDE;
-            framebufferInfo.layers          = 1;
+            // model is not used by fullscreen passes, so it carries previous view projection
+            PushConstants constants{};
+            constants.model      = a_prevViewProjection;
+            constants.view       = a_camera->view(0);
+            constants.projection = a_camera->renderProjection();
+            constants.frame      = (a_resetHistory) ? 0 : a_frame; // frame 0 rejects the history
 
-            if (vkCreateFramebuffer(a_device, &framebufferInfo, nullptr, &a_frameBuffer) != VK_SUCCESS)
-                throw std::runtime_error("failed to create framebuffer!");
+            vkCmdPushConstants(a_cmdBuffer, a_pipe.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &constants);
+
+            RecordCommandsOfDrawingQuad(a_squareMesh, a_cmdBuffer, a_pipe,
+                    { a_ssao.descriptorSet, a_attachments.gDepth.descriptorSet, a_attachments.shadowAtlas.descriptorSet,
+                    a_attachments.temporalHistory[previous].descriptorSet, a_shadowFaces });
         }
 
-        static void RecordCommandsOfShowingCubemap(VkDevice a_device, Mesh a_squareMesh, VkCommandBuffer a_cmdBuffer, const Pipe* a_cubemapPipe,
-                InputCubeTexture a_cubeTexture)
+        static void RecordCommandsOfDrawingQuad(Mesh a_squareMesh, VkCommandBuffer a_cmdBuffer, Pipe& a_pipe,
+                std::vector<VkDescriptorSet> a_setsToBind)
         {
-            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_cubemapPipe->pipeline);
+            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipeline);
 
-            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_cubemapPipe->pipelineLayout, 0, 1,
-                    &a_cubeTexture.descriptorSet, 0, nullptr);
+            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipelineLayout, 0,
+                    a_setsToBind.size(), a_setsToBind.data(), 0, nullptr);
 
             VkBuffer vbo{ a_squareMesh.getVBO().buffer };
             VkBuffer ibo{ a_squareMesh.getIBO().buffer };
@@ -1604,356 +3944,589 @@ class Application
             vkCmdBindVertexBuffers(a_cmdBuffer, 0, 1, &vbo, offsets.data());
             vkCmdBindIndexBuffer(a_cmdBuffer, ibo, 0, VK_INDEX_TYPE_UINT32);
 
-            vkCmdDrawIndexed(a_cmdBuffer, 6, 6, 0, 0, 0); // 6 instances for each cube face
+            vkCmdDrawIndexed(a_cmdBuffer, 6, 1, 0, 0, 0);
         }
 
-        static void RecordCommandsOfDrawingParticleSystems(std::unordered_map<std::string, ParticleSystem> a_particleSystems, VkCommandBuffer a_cmdBuffer,
-                std::unordered_map<std::string, Pipe>& a_pipes, Eye* a_eye)
+        // one level of the bloom chain (see DeclareRenderGraphPasses for the order of levels)
+        static void RecordCommandsOfBloomLevel(VkRenderPass a_renderPass, VkFramebuffer a_frameBuffer, Mesh a_squareMesh,
+                VkCommandBuffer a_cmdBuffer, Pipe& a_pipe, InputTexture& a_level, InputTexture& a_source, glm::vec2 a_renderScale)
         {
-            VkPipeline&       pipeline = a_pipes["particle system"].pipeline;
-            VkPipelineLayout& layout   = a_pipes["particle system"].pipelineLayout;
+            VkExtent3D extent{ a_level.texture->getExtent() };
+            VkExtent3D source{ a_source.texture->getExtent() };
 
-            for (auto& particleSystem : a_particleSystems)
-            {
-                auto& system{ particleSystem.second };
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass        = a_renderPass;
+            renderPassInfo.framebuffer       = a_frameBuffer;
+            renderPassInfo.renderArea.offset = { 0, 0 };
+            renderPassInfo.renderArea.extent = { extent.width, extent.height };
+            renderPassInfo.clearValueCount   = 0;
+            renderPassInfo.pClearValues      = nullptr;
 
-                vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            SetViewportAndScissor(a_cmdBuffer, (float)extent.width, (float)extent.height, true, a_renderScale);
 
-                vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &(system.getTexture()->descriptorSet), 0, nullptr);
+            vkCmdBeginRenderPass(a_cmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-                PushConstants constants{};
-                constants.model      = glm::mat4(1.0f);
-                constants.view       = a_eye->view(0);
-                constants.projection = a_eye->projection();
+            // lightPos slot carries the part of the source written by this frame, in uv
+            PushConstants constants{};
+            constants.lightPos = glm::vec3((float)ScaledSize((int)source.width, a_renderScale.x) / source.width,
+                    (float)ScaledSize((int)source.height, a_renderScale.y) / source.height, 0.0f);
 
-                vkCmdPushConstants(a_cmdBuffer, layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &constants);
+            vkCmdPushConstants(a_cmdBuffer, a_pipe.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &constants);
 
-                VkDeviceSize offsets[1] = { 0 };
-                vkCmdBindVertexBuffers(a_cmdBuffer, 0, 1, &(system.getVBO()), offsets);
+            RecordCommandsOfDrawingQuad(a_squareMesh, a_cmdBuffer, a_pipe, { a_source.descriptorSet });
 
-                vkCmdDraw(a_cmdBuffer, system.getParticleCount(), 1, 0, 0);
-            }
+            vkCmdEndRenderPass(a_cmdBuffer);
         }
 
-        static void RecordCommandsOfDrawingBloomedParts(VkFramebuffer a_frameBuffer, VkRenderPass a_renderPass, Pipe& a_pipe,
-                VkCommandBuffer a_cmdBuff, std::unordered_map<std::string, RenderObject>& a_objects, Eye* a_camera)
+        // a_drawMore: records the rest of the face after the meshes (particle shadows)
+        static void RecordCommandsToRenderForCubemapFace(VkFramebuffer a_frameBuffer, VkRenderPass a_renderPass, Pipe a_pipe,
+                const uint32_t a_face, VkCommandBuffer a_cmdBuff, const std::vector<const RenderObject*>& a_objects,
+                Eye* a_light, uint32_t a_side, const std::function<void(VkCommandBuffer)>& a_drawMore = {})
         {
-            VkClearValue colorClear;
-            colorClear.color = { {  0.0f, 0.0f, 0.0f, 0.0f } };
-
-            VkClearValue depthClear;
-            depthClear.depthStencil.depth = 1.f;
-
-            std::vector<VkClearValue> clearValues{ colorClear, depthClear };
+            std::vector<VkClearValue> clearValues(2);
+            clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+            clearValues[1].depthStencil = { 1.0f, 0 };
 
             VkRenderPassBeginInfo renderPassInfo{};
             renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
             renderPassInfo.renderPass        = a_renderPass;
             renderPassInfo.framebuffer       = a_frameBuffer;
             renderPassInfo.renderArea.offset = { 0, 0 };
-            renderPassInfo.renderArea.extent = { (uint32_t)BLOOM_DIM, (uint32_t)BLOOM_DIM };
+            renderPassInfo.renderArea.extent = { a_side, a_side }; // top left corner of the SHADOW_MAX_FACE_SIDE attachments
             renderPassInfo.clearValueCount   = clearValues.size();
             renderPassInfo.pClearValues      = clearValues.data();
 
-            SetViewportAndScissor(a_cmdBuff, (float)BLOOM_DIM, (float)BLOOM_DIM, true);
-
             vkCmdBeginRenderPass(a_cmdBuff, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-            RecordCommandsOfDrawingRenderables(a_objects, a_cmdBuff, &a_pipe, a_camera, glm::vec3(1.0f),
-                    InputCubeTexture{}, InputTexture{}, 0, true, true);
+            RecordCommandsOfDrawingRenderables(a_objects, a_cmdBuff, &a_pipe, a_light, a_light->position(), InputTexture{},
+                    InputTexture{}, a_face, false);
+
+            if (a_drawMore)
+            {
+                a_drawMore(a_cmdBuff);
+            }
 
             vkCmdEndRenderPass(a_cmdBuff);
         }
 
-        static void RecordCommandsOfDrawingRenderables(std::unordered_map<std::string, RenderObject> a_objects, VkCommandBuffer a_cmdBuffer,
-                const Pipe* a_specialPipeline, Eye* a_eye, glm::vec3 a_lightPos, InputCubeTexture a_shadowCubemap, InputTexture a_SSAOmap,
-                uint32_t a_face, bool a_bindTextures, bool a_glowingOnly)
+        // the first a_fraction of every particle system as alpha tested billboards of the face being rendered
+        // (gpu simulated systems draw all their particles, not only the ones the camera sees; dead ones are dropped
+        // by particleshadow.vert, and far emitters spawn only the first part anyway, see particles.comp)
+        static void RecordCommandsOfDrawingParticleShadows(std::unordered_map<std::string, ParticleSystem>& a_particleSystems,
+                VkCommandBuffer a_cmdBuffer, Pipe& a_pipe, Eye* a_light, uint32_t a_face, uint32_t a_side, float a_fraction, uint32_t a_frame)
         {
-            bool  specialPipeline{ a_specialPipeline != nullptr };
-            Mesh* previousMesh{nullptr};
-            Pipe* previousPipe{nullptr};
+            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipeline);
 
-            if (specialPipeline)
-            {
-                vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_specialPipeline->pipeline);
-            }
+            // emission slot carries pixels of the face per unit of particle size at distance 1
+            PushConstants constants{};
+            constants.model      = glm::mat4(1.0f);
+            constants.view       = a_light->view(a_face);
+            constants.projection = a_light->projection();
+            constants.lightPos   = a_light->position();
+            constants.emission   = PARTICLE_SHADOW_SPRITE_SIZE * std::abs(constants.projection[1][1]) * 0.5f * (float)a_side;
 
-            for (auto& object : a_objects)
-            {
-                auto& obj{ object.second };
+            vkCmdPushConstants(a_cmdBuffer, a_pipe.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &constants);
 
-                const VkPipeline&       pipeline = (!specialPipeline) ? obj.pipe->pipeline       : a_specialPipeline->pipeline;
-                const VkPipelineLayout& pLayout  = (!specialPipeline) ? obj.pipe->pipelineLayout : a_specialPipeline->pipelineLayout;
+            for (auto& particleSystem : a_particleSystems)
+            {
+                auto& system{ particleSystem.second };
 
-                if (!specialPipeline && obj.pipe != previousPipe)
+                uint32_t count{ (uint32_t)std::ceil(a_fraction * (float)system.getParticleCount()) };
+                if (count == 0)
                 {
-                    vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-                    previousPipe = obj.pipe;
+                    continue;
                 }
 
-                std::vector<VkDescriptorSet> setsToBind(0);
-
-                if (a_glowingOnly) // scene shader
-                {
-                    if (obj.bloom)
-                    {
-                        setsToBind.push_back(obj.texture->descriptorSet); // #0
-                    }
-                    else
-                    {
-                        setsToBind.push_back(s_blackTexutreDS); // #0
-                    }
-                }
-                else
-                {
-                    if (a_bindTextures)
-                    {
-                        setsToBind.push_back(obj.texture->descriptorSet); // #0
-                    }
-                    if (a_shadowCubemap.shadowCubemap != nullptr)
-                    {
-                        setsToBind.push_back(a_shadowCubemap.descriptorSet); // #1
-                        if (a_SSAOmap.texture != nullptr)
-                        {
-                            setsToBind.push_back(a_SSAOmap.descriptorSet); // #2
-                        }
-                    }
-                }
+                vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipelineLayout, 0, 1,
+                        &(system.getTexture()->descriptorSet), 0, nullptr);
 
-                if (setsToBind.size())
-                {
-                    vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pLayout, 0,
-                            setsToBind.size(),
-                            setsToBind.data(),
-                            0, nullptr);
-                }
+                VkDeviceSize offsets[1] = { system.getVertexOffset(a_frame) };
+                vkCmdBindVertexBuffers(a_cmdBuffer, 0, 1, &(system.getVBO()), offsets);
 
-                PushConstants constants{};
-                constants.model      = obj.matrix;
-                constants.view       = a_eye->view(a_face);
-                constants.projection = a_eye->projection();
-                constants.lightPos   = a_lightPos;
+                vkCmdDraw(a_cmdBuffer, count, 1, 0, 0);
+            }
+        }
 
-                vkCmdPushConstants(a_cmdBuffer, pLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &constants);
+        // measured gpu time of the particle shadows of one frame (every face is a section of its own, their times are summed)
+        // moves the drawn fraction towards the one that fits PARTICLE_SHADOW_BUDGET_MS (a little way per measurement, they are frames old)
+        static float ParticleShadowFraction(float a_fraction, float a_gpuTime)
+        {
+            if (a_gpuTime <= 0.0f)
+            {
+                return a_fraction;
+            }
 
-                if (obj.mesh != previousMesh)
-                {
-                    std::vector<VkBuffer> vertexBuffers{ obj.mesh->getVBO().buffer };
-                    VkBuffer indexBuffers{ obj.mesh->getIBO().buffer };
-                    std::vector<VkDeviceSize> offsets{ 0 };
+            float step{ std::clamp(std::sqrt(PARTICLE_SHADOW_BUDGET_MS / a_gpuTime), 0.8f, 1.05f) };
 
-                    vkCmdBindVertexBuffers(a_cmdBuffer, 0, vertexBuffers.size(), vertexBuffers.data(), offsets.data());
-                    vkCmdBindIndexBuffer(a_cmdBuffer, indexBuffers, 0, VK_INDEX_TYPE_UINT32);
-                }
+            return std::clamp(a_fraction * step, PARTICLE_SHADOW_MIN_FRACTION, PARTICLE_SHADOW_FRACTION);
+        }
 
-                vkCmdDrawIndexed(a_cmdBuffer, obj.mesh->indices.size(), 1, 0, 0, 0);
-            }
+        // region.side x region.side corner of a_srcTexutre is copied into the region of the face
+        // (source is expected in transfer src layout, atlas in transfer dst layout)
+        static void RecordCommandsOfCopyingToShadowAtlas(VkCommandBuffer a_cmdBuff, Texture& a_srcTexutre, Texture* a_atlas,
+                ShadowAtlas::Region a_region)
+        {
+            VkOffset2D offset{ (int32_t)a_region.offset.x, (int32_t)a_region.offset.y };
+            a_atlas->copyImageToRegion(a_cmdBuff, a_srcTexutre.getImage(), offset, a_region.side);
         }
 
-        static void RecordCommandsOfFillingGBuffer(VkFramebuffer a_frameBuffer, VkRenderPass a_renderPass, Pipe a_pipe,
-                VkCommandBuffer a_cmdBuff, const std::unordered_map<std::string, RenderObject>& a_objects, Eye* a_camera)
+        // temporal accumulation and HDR scene share one render pass, the scene reads the accumulated ao and shadows
+        // of its own pixel straight from the attachment (tile memory on tilers) instead of sampling a texture
+        void RecordCommandsOfDrawingScene(std::vector<VkFramebuffer>& a_frameBuffers, VkRenderPass a_renderPass, VkCommandBuffer a_cmdBuffer,
+                InputTexture& a_ssao, Pipe& a_temporalPipe, Pipe& a_particlePipe, bool a_particleOIT, bool a_resetHistory)
         {
-            std::vector<VkClearValue> clearValues(3);
-            clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
-            clearValues[1].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
-            clearValues[2].depthStencil = { 1.0f, 0 };
+            size_t     current{ m_frameCount % m_attachments.temporalHistory.size() };
+            VkExtent3D extent{ m_attachments.sceneColor.getExtent() };
 
-            VkRenderPassBeginInfo renderPassInfo{};
-            renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassInfo.renderPass        = a_renderPass;
-            renderPassInfo.framebuffer       = a_frameBuffer;
-            renderPassInfo.renderArea.offset = { 0, 0 };
-            renderPassInfo.renderArea.extent = { (uint32_t)WIDTH, (uint32_t)HEIGHT };
-            renderPassInfo.clearValueCount   = clearValues.size();
-            renderPassInfo.pClearValues      = clearValues.data();
+            VkClearValue historyClear;
+            historyClear.color = { { 1.0f, 1.0f, 0.0f, 0.0f } };
 
-            vkCmdBeginRenderPass(a_cmdBuff, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+            VkClearValue colorClear;
+            colorClear.color = { {  0.0f, 0.0f, 0.0f, 1.0f } };
 
-            RecordCommandsOfDrawingRenderables(a_objects, a_cmdBuff, &a_pipe, a_camera, glm::vec3(0.0f), InputCubeTexture{},
-                    InputTexture{}, 0, false, false);
+            VkClearValue depthClear;
+            depthClear.depthStencil.depth = 1.f;
 
-            vkCmdEndRenderPass(a_cmdBuff);
-        }
+            VkClearValue accumulationClear;
+            accumulationClear.color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
 
-        static void RecordCommandsOfSSAOEvaluation(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer a_frameBuffer,
-                Mesh a_squareMesh, VkCommandBuffer a_cmdBuffer, Pipe a_pipe, InputAttachments& a_attachments,
-                InputTexture& a_noiceTexture, UniformBuffer& a_ssaoKernel, glm::mat4 a_projMatrix)
-        {
-            std::vector<VkClearValue> clearValues(2);
-            clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
-            clearValues[1].depthStencil = { 1.0f, 0 };
+            VkClearValue revealageClear;
+            revealageClear.color = { { 1.0f, 0.0f, 0.0f, 0.0f } };
+
+            std::vector<VkClearValue> clearValues{ historyClear, colorClear, depthClear, accumulationClear, revealageClear };
 
             VkRenderPassBeginInfo renderPassInfo{};
             renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
             renderPassInfo.renderPass        = a_renderPass;
-            renderPassInfo.framebuffer       = a_frameBuffer;
+            renderPassInfo.framebuffer       = a_frameBuffers[current];
             renderPassInfo.renderArea.offset = { 0, 0 };
-            renderPassInfo.renderArea.extent = { (uint32_t)WIDTH, (uint32_t)HEIGHT };
+            renderPassInfo.renderArea.extent = { extent.width, extent.height };
             renderPassInfo.clearValueCount   = clearValues.size();
             renderPassInfo.pClearValues      = clearValues.data();
 
+            SetViewportAndScissor(a_cmdBuffer, (float)extent.width, (float)extent.height, true, m_renderScale);
+
             vkCmdBeginRenderPass(a_cmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipeline);
+            // subpass #0: TEMPORAL ACCUMULATION (ssao + shadows)
+            RecordCommandsOfTemporalAccumulation(m_meshes["quad"], a_cmdBuffer, a_temporalPipe, a_ssao, m_inputAttachments,
+                    m_shadows.facesDS[m_currentFrame], m_pEyes["camera"], m_prevViewProjection, m_frameCount, a_resetHistory);
 
-            std::vector<VkDescriptorSet> setsToBind(0);
-            setsToBind.push_back(a_attachments.gPositionAndDepth.descriptorSet);
-            setsToBind.push_back(a_attachments.gNormals.descriptorSet);
-            setsToBind.push_back(a_noiceTexture.descriptorSet);
-            setsToBind.push_back(a_ssaoKernel.descriptorSet);
+            vkCmdNextSubpass(a_cmdBuffer, VK_SUBPASS_CONTENTS_INLINE);
 
-            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipelineLayout, 0,
-                    setsToBind.size(), setsToBind.data(), 0, nullptr);
+            // subpass #1: HDR SCENE
+            // sets #0..#2 are bound per object, point lights, clusters and shadow faces stay bound (same layout)
+            std::vector<VkDescriptorSet> lightSets{ m_clusters.lightsDS[m_currentFrame], m_clusters.gridDS,
+                m_shadows.facesDS[m_currentFrame] };
+            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipes["scene"].pipelineLayout, 3,
+                    lightSets.size(), lightSets.data(), 0, nullptr);
 
-            VkBuffer vbo{ a_squareMesh.getVBO().buffer };
-            VkBuffer ibo{ a_squareMesh.getIBO().buffer };
+            RecordCommandsOfDrawingRenderables(m_culling.camera, a_cmdBuffer, nullptr, m_pEyes["camera"], m_pEyes["light"]->position(),
+                    m_inputAttachments.shadowAtlas, m_inputAttachments.temporalHistoryInput[current],
+                    0, true, m_particleSystems.at("fire").getLightColor());
 
-            std::vector<VkDeviceSize> offsets{ 0 };
+            if (!a_particleOIT)
+            {
+                RecordCommandsOfDrawingParticleSystems(m_particleSystems, a_cmdBuffer, a_particlePipe, m_pEyes["camera"], (uint32_t)m_currentFrame);
+            }
 
-            vkCmdBindVertexBuffers(a_cmdBuffer, 0, 1, &vbo, offsets.data());
-            vkCmdBindIndexBuffer(a_cmdBuffer, ibo, 0, VK_INDEX_TYPE_UINT32);
+            vkCmdNextSubpass(a_cmdBuffer, VK_SUBPASS_CONTENTS_INLINE);
 
-            PushConstants constants{};
-            constants.projection = a_projMatrix;
+            // subpass #2: WEIGHTED BLENDED PARTICLES (any order)
+            if (a_particleOIT)
+            {
+                RecordCommandsOfDrawingParticleSystems(m_particleSystems, a_cmdBuffer, a_particlePipe, m_pEyes["camera"], (uint32_t)m_currentFrame);
+            }
 
-            vkCmdPushConstants(a_cmdBuffer, a_pipe.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &constants);
+            vkCmdNextSubpass(a_cmdBuffer, VK_SUBPASS_CONTENTS_INLINE);
 
-            vkCmdDrawIndexed(a_cmdBuffer, 6, 1, 0, 0, 0);
+            // subpass #3: COMPOSITE OF WEIGHTED BLENDED PARTICLES over scene color
+            if (a_particleOIT)
+            {
+                RecordCommandsOfDrawingQuad(m_meshes["quad"], a_cmdBuffer, m_pipes["particle composite"],
+                        { m_inputAttachments.oitAccumulationInput.descriptorSet, m_inputAttachments.oitRevealageInput.descriptorSet });
+            }
 
             vkCmdEndRenderPass(a_cmdBuffer);
         }
 
-        static void RecordCommandsOfBluringSSAO(VkDevice a_device, VkRenderPass a_renderPass, VkFramebuffer a_frameBuffer,
-                Mesh a_squareMesh, VkCommandBuffer a_cmdBuffer, Pipe a_pipe, InputTexture& a_ssao)
+        // particle point sizes are in pixels of a HEIGHT tall screen, scaled to the rendered part of the targets of a_eye
+        static float PointSizeScale(Eye* a_eye)
         {
-            std::vector<VkClearValue> clearValues(2);
-            clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
-            clearValues[1].depthStencil = { 1.0f, 0 };
+            return a_eye->getRenderScale().y * a_eye->getTargetSize().y / (float)HEIGHT;
+        }
 
-            VkRenderPassBeginInfo renderPassInfo{};
-            renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassInfo.renderPass        = a_renderPass;
-            renderPassInfo.framebuffer       = a_frameBuffer;
-            renderPassInfo.renderArea.offset = { 0, 0 };
-            renderPassInfo.renderArea.extent = { (uint32_t)WIDTH, (uint32_t)HEIGHT };
-            renderPassInfo.clearValueCount   = clearValues.size();
-            renderPassInfo.pClearValues      = clearValues.data();
+        // rendered part of a_size pixels at a_scale (dynamic resolution)
+        static uint32_t ScaledSize(int a_size, float a_scale)
+        {
+            return std::min((uint32_t)std::ceil((float)a_size * a_scale), (uint32_t)a_size);
+        }
 
-            vkCmdBeginRenderPass(a_cmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        // a_scissorScale: only the top left part of the viewport is drawn (see Eye::renderProjection)
+        static void SetViewportAndScissor(VkCommandBuffer a_cmdBuffer, const float&& a_width, const float&& a_height, const bool&& a_flipViewport,
+                glm::vec2 a_scissorScale = glm::vec2(1.0f))
+        {
+            VkViewport viewport{};
 
-            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipeline);
+            if (a_flipViewport)
+            {
+                viewport.x = 0;
+                viewport.y = (float)a_height - 0;
+                viewport.width = (float)a_width;
+                viewport.height = -(float)a_height;
+            }
+            else
+            {
+                viewport.x        = 0;
+                viewport.y        = 0;
+                viewport.width    = (float)a_width;
+                viewport.height   = (float)a_height;
+            }
 
-            std::vector<VkDescriptorSet> setsToBind{ a_ssao.descriptorSet };
+            viewport.minDepth = 0.0f;
+            viewport.maxDepth = 1.0f;
+            vkCmdSetViewport(a_cmdBuffer, 0, 1, &viewport);
 
-            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipelineLayout, 0,
-                    setsToBind.size(), setsToBind.data(), 0, nullptr);
+            VkRect2D scissor{};
+            scissor.extent = { ScaledSize((int)a_width, a_scissorScale.x), ScaledSize((int)a_height, a_scissorScale.y) };
+            vkCmdSetScissor(a_cmdBuffer, 0, 1, &scissor);
+        }
 
-            VkBuffer vbo{ a_squareMesh.getVBO().buffer };
-            VkBuffer ibo{ a_squareMesh.getIBO().buffer };
+        // effects rendered by a frame, passes of disabled ones (and the passes only they read from) are not declared at all
+        struct FrameEffects {
+            bool        scene;       // g buffer, hi-z, temporal accumulation and hdr scene (not shown by the shadow atlas debug view)
+            bool        ssao;
+            bool        bloom;
+            uint32_t    bloomLevels; // first levels of the bloom chain
+            std::string ssaoPipe;    // pipeline variants of the quality preset (see SpecializationConstants::variantName)
+            std::string temporalPipe;
+            std::string bloomUpsamplePipe;
+            bool        particleOIT; // weighted blended particles instead of additive ones
+            bool        particleShadows;
+            std::string particlePipe;
+        };
 
-            std::vector<VkDeviceSize> offsets{ 0 };
+        // a_allPasses: every pass that may ever run, regardless of toggles and quality preset
+        static FrameEffects GetFrameEffects(bool a_allPasses)
+        {
+            const QualitySettings& quality{ QUALITY_SETTINGS[s_qualityPreset] };
+
+            FrameEffects effects{};
+            effects.scene             = a_allPasses || !s_shadowmapDebug;
+            effects.ssao              = a_allPasses || (effects.scene && s_ssaoEnabled);
+            effects.bloom             = a_allPasses || (effects.scene && s_bloomEnabled);
+            effects.bloomLevels       = std::clamp((a_allPasses) ? (uint32_t)BLOOM_MIP_LEVELS : quality.bloomLevels, 1u, (uint32_t)BLOOM_MIP_LEVELS);
+            effects.ssaoPipe          = SSAOConstants(quality).variantName((s_ssaoCompute) ? "ssao compute" : "ssao");
+            effects.temporalPipe      = TemporalConstants(quality).variantName("temporal");
+            effects.bloomUpsamplePipe = BloomUpsampleConstants().variantName("bloom upsample");
+            effects.particleOIT       = s_particleOIT;
+            effects.particleShadows   = s_particleShadows;
+            effects.particlePipe      = ParticleConstants(s_particleOIT).variantName("particle system");
+
+            return effects;
+        }
 
-            vkCmdBindVertexBuffers(a_cmdBuffer, 0, 1, &vbo, offsets.data());
-            vkCmdBindIndexBuffer(a_cmdBuffer, ibo, 0, VK_INDEX_TYPE_UINT32);
+        // passes of one frame in submission order, with the images each of them reads and writes
+        // a_allPasses: every pass that may ever run, regardless of toggles (used to plan memory aliasing)
+        void DeclareRenderGraphPasses(VkFramebuffer a_swapChainFramebuffer, bool a_allPasses)
+        {
+            Attachments& a{ m_attachments };
+            RenderGraph& graph{ m_renderGraph };
 
-            vkCmdDrawIndexed(a_cmdBuffer, 6, 1, 0, 0, 0);
+            FrameEffects effects{ GetFrameEffects(a_allPasses) };
+            bool         lowRes{ SSAO_DOWNSCALE > 1 };
+            VkExtent3D   full{ a.sceneColor.getExtent() }; // camera targets follow the swapchain
+            VkExtent3D   low{ a.ssao.getExtent() };
 
-            vkCmdEndRenderPass(a_cmdBuffer);
-        }
+            // PARTICLES (simulated on gpu) and LIGHT CLUSTERS, buffers only (barriers of their own)
+            graph.addPass("particles", {}, [this](VkCommandBuffer a_cmdBuffer)
+            {
+                RecordCommandsOfUpdatingParticleSystems(a_cmdBuffer, m_pipes[ParticlesConstants().variantName("particles compute")],
+                        m_pipes[ParticlesConstants().variantName("particles cull compute")], m_particleSystems, m_pEyes["camera"], m_frameCount);
+            }, true);
 
-        static void RecordCommandsOfBluringBloom(Mesh a_squareMesh, VkCommandBuffer a_cmdBuffer, Pipe a_pipe, InputTexture& a_bloom)
-        {
-            vkCmdBindPipeline(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipeline);
+            graph.addPass("clusters", {}, [this](VkCommandBuffer a_cmdBuffer)
+            {
+                RecordCommandsOfBuildingClusters(a_cmdBuffer, m_pipes["clusters compute"], m_clusters, m_pEyes["camera"],
+                        (uint32_t)m_currentFrame);
+            }, true);
 
-            std::vector<VkDescriptorSet> setsToBind{ a_bloom.descriptorSet };
+            // SHADOW ATLAS (faces and their regions planned by PlanShadowFaces)
+            for (uint32_t shadowFace{}; shadowFace < SHADOW_LIGHTS * SHADOW_FACES; ++shadowFace)
+            {
+                if (!a_allPasses && !m_shadows.faces[shadowFace].update)
+                {
+                    continue;
+                }
 
-            vkCmdBindDescriptorSets(a_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, a_pipe.pipelineLayout, 0,
-                    setsToBind.size(), setsToBind.data(), 0, nullptr);
+                ShadowAtlas::Region region{ m_shadows.faces[shadowFace].region };
+                uint32_t            side{ region.side };
+                uint32_t            face{ shadowFace % SHADOW_FACES };
+                Eye*                light{ m_shadows.lights[shadowFace / SHADOW_FACES] };
 
-            VkBuffer vbo{ a_squareMesh.getVBO().buffer };
-            VkBuffer ibo{ a_squareMesh.getIBO().buffer };
+                // particles are lit by the fire only
+                bool particleShadows{ effects.particleShadows && shadowFace < SHADOW_FACES };
 
-            std::vector<VkDeviceSize> offsets{ 0 };
+                graph.addPass("shadow face", { Access::colorAttachment(&a.offscreenColor), Access::depthAttachment(&a.offscreenDepth) },
+                        [this, shadowFace, face, light, side, particleShadows](VkCommandBuffer a_cmdBuffer)
+                {
+                    // timed face by face, the sum of a frame steers m_particleShadowFraction
+                    auto drawParticles = [this, face, light, side](VkCommandBuffer a_cmdBuffer)
+                    {
+                        m_gpuTimer.beginSection(a_cmdBuffer, (uint32_t)m_currentFrame, face);
+                        RecordCommandsOfDrawingParticleShadows(m_particleSystems, a_cmdBuffer, m_pipes["particle shadow"], light,
+                                face, side, m_particleShadowFraction, (uint32_t)m_currentFrame);
+                        m_gpuTimer.endSection(a_cmdBuffer, (uint32_t)m_currentFrame, face);
+                    };
+
+                    SetViewportAndScissor(a_cmdBuffer, (float)side, (float)side, true);
+                    RecordCommandsToRenderForCubemapFace(m_framebuffersOffscreen.shadowCubemapFrameBuffer, m_renderPasses.shadowCubemapPass,
+                            m_pipes["shadow cubemap"], face, a_cmdBuffer, m_culling.shadowFaces[shadowFace], light, side,
+                            (particleShadows) ? drawParticles : std::function<void(VkCommandBuffer)>{});
+                });
+
+                // only the region of the face is written, so the rest of the atlas is kept
+                graph.addPass("copy to shadow atlas", { Access::transferSrc(&a.offscreenColor), Access::transferDst(&a.shadowAtlas, false) },
+                        [this, region](VkCommandBuffer a_cmdBuffer)
+                {
+                    RecordCommandsOfCopyingToShadowAtlas(a_cmdBuffer, m_attachments.offscreenColor, &m_attachments.shadowAtlas, region);
+                });
+            }
 
-            vkCmdBindVertexBuffers(a_cmdBuffer, 0, 1, &vbo, offsets.data());
-            vkCmdBindIndexBuffer(a_cmdBuffer, ibo, 0, VK_INDEX_TYPE_UINT32);
+            // G BUFFER (depth doubles as the depth pre-pass of the scene)
+            if (effects.scene)
+            {
+                graph.addPass("g buffer", { Access::colorAttachment(&a.gNormals), Access::depthAttachment(&a.presentDepth) },
+                        [this, full](VkCommandBuffer a_cmdBuffer)
+                {
+                    SetViewportAndScissor(a_cmdBuffer, (float)full.width, (float)full.height, true, m_renderScale);
+                    RecordCommandsOfFillingGBuffer(m_framebuffersOffscreen.gBufferCreationFrameBuffer, m_renderPasses.gBufferCreationPass,
+                            m_pipes["g buffer"], a_cmdBuffer, m_culling.camera, m_pEyes["camera"], full);
+                });
+
+                // read back by the cpu for occlusion culling of the frame that reuses this frame in flight
+                graph.addPass("hi-z", { Access::sampled(&a.presentDepth, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT) },
+                        [this](VkCommandBuffer a_cmdBuffer)
+                {
+                    RecordCommandsOfBuildingHiZ(a_cmdBuffer, m_pipes["hi-z compute"], m_culling, m_inputAttachments, (uint32_t)m_currentFrame);
+                    m_culling.hiZViewProjection[m_currentFrame] = m_pEyes["camera"]->renderProjection() * m_pEyes["camera"]->view(0);
+                    m_culling.hiZWritten[m_currentFrame]        = true;
+                }, true);
+            }
+            else
+            {
+                // nothing fresh to read back, and the history misses this frame
+                m_culling.hiZWritten[m_currentFrame] = false;
+                m_historyValid                       = false;
+            }
 
-            vkCmdDrawIndexed(a_cmdBuffer, 6, 1, 0, 0, 0);
-        }
+            // SSAO
+            if (effects.ssao)
+            {
+                if (lowRes)
+                {
+                    graph.addPass("g buffer downsample", { Access::sampled(&a.presentDepth), Access::sampled(&a.gNormals),
+                            Access::colorAttachment(&a.lowResDepth), Access::colorAttachment(&a.lowResNormals) },
+                            [this, low](VkCommandBuffer a_cmdBuffer)
+                    {
+                        SetViewportAndScissor(a_cmdBuffer, (float)low.width, (float)low.height, true, m_renderScale);
+                        RecordCommandsOfDownsamplingGBuffer(m_renderPasses.gBufferDownsamplePass, m_framebuffersOffscreen.gBufferDownsampleFrameBuffer,
+                                m_meshes["quad"], a_cmdBuffer, m_pipes[GBufferDownsampleConstants().variantName("g buffer downsample")], m_inputAttachments);
+                    });
+                }
 
-        static void RecordCommandsToRenderForCubemapFace(VkFramebuffer a_frameBuffer, VkRenderPass a_renderPass, Pipe a_pipe,
-                const uint32_t a_face, VkCommandBuffer a_cmdBuff, const std::unordered_map<std::string, RenderObject>& a_objects,
-                Eye* a_light)
-        {
-            std::vector<VkClearValue> clearValues(2);
-            clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
-            clearValues[1].depthStencil = { 1.0f, 0 };
+                Texture* ssaoDepth{ (lowRes) ? &a.lowResDepth : &a.presentDepth };
+                Texture* ssaoNormals{ (lowRes) ? &a.lowResNormals : &a.gNormals };
+
+                if (s_ssaoCompute)
+                {
+                    VkPipelineStageFlags compute{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT };
+
+                    graph.addPass("ssao", { Access::sampled(ssaoDepth, compute), Access::sampled(ssaoNormals, compute), Access::storageWrite(&a.ssao) },
+                            [this, effects](VkCommandBuffer a_cmdBuffer)
+                    {
+                        RecordCommandsOfSSAOEvaluationCompute(a_cmdBuffer, m_pipes[effects.ssaoPipe], m_inputAttachments, m_inputTextures["noise"],
+                                m_roUniformBuffers["ssao kernel"], m_pEyes["camera"]->renderProjection(), m_frameCount, m_renderScale);
+                    });
+
+                    graph.addPass("blur ssao", { Access::sampled(&a.ssao, compute), Access::storageWrite(&a.blurredSSAO) },
+                            [this](VkCommandBuffer a_cmdBuffer)
+                    {
+                        RecordCommandsOfBluringSSAOCompute(a_cmdBuffer, m_pipes["blur ssao compute"], m_inputAttachments, m_renderScale);
+                    });
+                }
+                else
+                {
+                    graph.addPass("ssao", { Access::sampled(ssaoDepth), Access::sampled(ssaoNormals), Access::colorAttachment(&a.ssao) },
+                            [this, effects, low](VkCommandBuffer a_cmdBuffer)
+                    {
+                        SetViewportAndScissor(a_cmdBuffer, (float)low.width, (float)low.height, true, m_renderScale);
+                        RecordCommandsOfSSAOEvaluation(m_device, m_renderPasses.ssaoPass, m_framebuffersOffscreen.ssaoFrameBuffer, m_meshes["quad"],
+                                a_cmdBuffer, m_pipes[effects.ssaoPipe], m_inputAttachments, m_inputTextures["noise"], m_roUniformBuffers["ssao kernel"],
+                                m_pEyes["camera"]->renderProjection(), m_frameCount);
+                    });
+
+                    graph.addPass("blur ssao", { Access::sampled(&a.ssao), Access::colorAttachment(&a.blurredSSAO) },
+                            [this, low](VkCommandBuffer a_cmdBuffer)
+                    {
+                        SetViewportAndScissor(a_cmdBuffer, (float)low.width, (float)low.height, true, m_renderScale);
+                        RecordCommandsOfBluringSSAO(m_device, m_renderPasses.ssaoBlurPass, m_framebuffersOffscreen.ssaoBlurFrameBuffer,
+                                m_meshes["quad"], a_cmdBuffer, m_pipes["blur ssao"], m_inputAttachments.ssao, m_renderScale);
+                    });
+                }
+
+                if (lowRes)
+                {
+                    graph.addPass("ssao upsample", { Access::sampled(&a.blurredSSAO), Access::sampled(&a.presentDepth),
+                            Access::sampled(&a.lowResDepth), Access::colorAttachment(&a.upsampledSSAO) },
+                            [this, full](VkCommandBuffer a_cmdBuffer)
+                    {
+                        SetViewportAndScissor(a_cmdBuffer, (float)full.width, (float)full.height, true, m_renderScale);
+                        RecordCommandsOfUpsamplingSSAO(m_renderPasses.ssaoBlurPass, m_framebuffersOffscreen.ssaoUpsampleFrameBuffer,
+                                m_meshes["quad"], a_cmdBuffer, m_pipes["ssao upsample"], m_inputAttachments, m_pEyes["camera"]->renderProjection());
+                    });
+                }
+            }
+
+            // TEMPORAL ACCUMULATION (ssao + shadows) + HDR SCENE
+            // history is persistent, so once declared the pass is never culled
+            if (effects.scene)
+            {
+                size_t current{ m_frameCount % a.temporalHistory.size() };
+                size_t previous{ (m_frameCount + 1) % a.temporalHistory.size() };
+
+                Access historyWrite{ Access::colorAttachment(&a.temporalHistory[current]) };
+                historyWrite.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+                // sampled by subpass #0, tested against (and written without the depth pre-pass) by subpass #1
+                Access depth{ Access::make(&a.presentDepth, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+                        | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) };
+                depth.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+                if (!DEPTH_PREPASS_REUSE)
+                {
+                    depth.access      |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+                    depth.finalLayout  = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+                }
 
-            VkRenderPassBeginInfo renderPassInfo{};
-            renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassInfo.renderPass        = a_renderPass;
-            renderPassInfo.framebuffer       = a_frameBuffer;
-            renderPassInfo.renderArea.offset = { 0, 0 };
-            renderPassInfo.renderArea.extent = { (uint32_t)CUBE_SIDE, (uint32_t)CUBE_SIDE };
-            renderPassInfo.clearValueCount   = clearValues.size();
-            renderPassInfo.pClearValues      = clearValues.data();
+                // oit attachments are cleared and dropped by the pass whether particles are weighted blended or not
+                std::vector<Access> accesses{ historyWrite, Access::sampled(&a.temporalHistory[previous]), Access::colorAttachment(&a.sceneColor),
+                    depth, Access::sampled(&a.shadowAtlas), Access::colorAttachment(&a.oitAccumulation),
+                    Access::colorAttachment(&a.oitRevealage) };
+                if (effects.ssao)
+                {
+                    accesses.push_back(Access::sampled((lowRes) ? &a.upsampledSSAO : &a.blurredSSAO));
+                }
 
-            vkCmdBeginRenderPass(a_cmdBuff, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+                graph.addPass("scene", accesses, [this, effects](VkCommandBuffer a_cmdBuffer)
+                {
+                    InputTexture& ssao{ (effects.ssao) ? ((SSAO_DOWNSCALE > 1) ? m_inputAttachments.upsampledSSAO : m_inputAttachments.blurredSSAO)
+                                                       : m_inputTextures["white"] };
 
-            RecordCommandsOfDrawingRenderables(a_objects, a_cmdBuff, &a_pipe, a_light, a_light->position(), InputCubeTexture{},
-                    InputTexture{}, a_face, false, false);
+                    bool resetHistory{ !m_historyValid };
+                    m_historyValid = true;
 
-            vkCmdEndRenderPass(a_cmdBuff);
-        }
+                    RecordCommandsOfDrawingScene(m_framebuffersOffscreen.sceneFrameBuffers, m_renderPasses.scenePass, a_cmdBuffer, ssao,
+                            m_pipes[effects.temporalPipe], m_pipes[effects.particlePipe], effects.particleOIT, resetHistory);
+                });
+            }
 
-        static void RecordCommandsOfCopyingToCubemapFace(const uint32_t a_face, VkCommandBuffer a_cmdBuff, Texture& a_srcTexutre,
-                CubeTexture* a_cubemap)
-        {
-            VkImageMemoryBarrier imgBar = a_srcTexutre.makeBarrier(a_srcTexutre.wholeImageRange(), 0, VK_ACCESS_TRANSFER_READ_BIT,
-                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-            a_srcTexutre.changeImageLayout(a_cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+            // BLOOM
+            // bright parts of hdr scene color --> level 0 --> ... --> level N-1 (13 tap downsample)
+            // level N-1 --> ... --> level 0 (3x3 tent upsample, added on top of the downsampled level)
+            // N is set by the quality preset, deeper levels of the chain are left alone
+            if (effects.bloom)
+            {
+                auto&  chain{ a.bloomChain };
+                size_t levels{ effects.bloomLevels };
 
-            imgBar = a_cubemap->makeBarrier(a_cubemap->oneFaceRange(a_face), 0, VK_ACCESS_TRANSFER_WRITE_BIT,
-                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-            a_cubemap->changeImageLayout(a_cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+                auto addLevel = [&](const std::string& a_name, size_t a_level, Texture* a_source, bool a_upsample)
+                {
+                    std::string pipe{ (a_upsample) ? effects.bloomUpsamplePipe : a_name };
 
-            a_cubemap->copyImageToCubeface(a_cmdBuff, a_srcTexutre.getImage(), a_face);
+                    graph.addPass(a_name, { Access::sampled(a_source), Access::colorAttachment(&chain[a_level], !a_upsample) },
+                            [this, a_level, a_upsample, pipe](VkCommandBuffer a_cmdBuffer)
+                    {
+                        InputAttachments& inputs{ m_inputAttachments };
+                        InputTexture&     source{ (a_upsample) ? inputs.bloomChain[a_level + 1]
+                                                               : ((a_level == 0) ? inputs.sceneColor : inputs.bloomChain[a_level - 1]) };
+
+                        RecordCommandsOfBloomLevel((a_upsample) ? m_renderPasses.bloomUpsamplePass : m_renderPasses.bloomDownsamplePass,
+                                m_framebuffersOffscreen.bloomFrameBuffers[a_level], m_meshes["quad"], a_cmdBuffer, m_pipes[pipe],
+                                inputs.bloomChain[a_level], source, m_renderScale);
+                    });
+                };
 
-            imgBar = a_srcTexutre.makeBarrier(a_srcTexutre.wholeImageRange(), 0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-            a_srcTexutre.changeImageLayout(a_cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+                addLevel("bloom extract", 0, &a.sceneColor, false);
 
-            imgBar = a_cubemap->makeBarrier(a_cubemap->oneFaceRange(a_face), 0, VK_ACCESS_SHADER_READ_BIT,
-                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-            a_cubemap->changeImageLayout(a_cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
-        }
+                for (size_t level{ 1 }; level < levels; ++level)
+                {
+                    addLevel("bloom downsample", level, &chain[level - 1], false);
+                }
 
-        static void SetViewportAndScissor(VkCommandBuffer a_cmdBuffer, const float&& a_width, const float&& a_height, const bool&& a_flipViewport)
-        {
-            VkViewport viewport{};
+                for (size_t level{ levels - 1 }; level > 0; --level)
+                {
+                    addLevel("bloom upsample", level - 1, &chain[level], true);
+                }
+            }
 
-            if (a_flipViewport)
+            // PRESENT (swapchain image is synchronized by the final render pass itself)
+            std::vector<Access> presentAccesses{};
+            if (!effects.scene)
             {
-                viewport.x = 0;
-                viewport.y = (float)a_height - 0;
-                viewport.width = (float)a_width;
-                viewport.height = -(float)a_height;
+                presentAccesses.push_back(Access::sampled(&a.shadowAtlas));
             }
             else
             {
-                viewport.x        = 0;
-                viewport.y        = 0;
-                viewport.width    = (float)a_width;
-                viewport.height   = (float)a_height;
+                presentAccesses.push_back(Access::sampled(&a.sceneColor));
+                if (effects.bloom)
+                {
+                    presentAccesses.push_back(Access::sampled(&a.bloomChain[0]));
+                }
             }
 
-            viewport.minDepth = 0.0f;
-            viewport.maxDepth = 1.0f;
-            vkCmdSetViewport(a_cmdBuffer, 0, 1, &viewport);
+            graph.addPass("present", presentAccesses, [this, a_swapChainFramebuffer, effects](VkCommandBuffer a_cmdBuffer)
+            {
+                VkClearValue colorClear;
+                colorClear.color = { {  0.0f, 0.0f, 0.0f, 1.0f } };
 
-            VkRect2D scissor{};
-            scissor.extent = { (uint32_t)a_width, (uint32_t)a_height };
-            vkCmdSetScissor(a_cmdBuffer, 0, 1, &scissor);
+                std::vector<VkClearValue> clearValues{ colorClear };
+
+                VkRenderPassBeginInfo renderPassInfo{};
+                renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                renderPassInfo.renderPass        = m_renderPasses.finalRenderPass;
+                renderPassInfo.framebuffer       = a_swapChainFramebuffer;
+                renderPassInfo.renderArea.offset = { 0, 0 };
+                renderPassInfo.renderArea.extent = m_screen.swapChainExtent;
+                renderPassInfo.clearValueCount   = clearValues.size();
+                renderPassInfo.pClearValues      = clearValues.data();
+
+                SetViewportAndScissor(a_cmdBuffer, (float)m_screen.swapChainExtent.width, (float)m_screen.swapChainExtent.height, true);
+
+                vkCmdBeginRenderPass(a_cmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+                if (!effects.scene)
+                {
+                    RecordCommandsOfShowingShadowAtlas(m_device, m_meshes["quad"], a_cmdBuffer, &m_pipes["show shadow atlas"],
+                            m_inputAttachments.shadowAtlas);
+                }
+                else
+                {
+                    InputTexture& bloom{ (effects.bloom) ? m_inputAttachments.bloomChain[0] : m_inputTextures["black"] };
+
+                    // lightPos slot carries render scale (part of the targets to upscale)
+                    PushConstants constants{};
+                    constants.lightPos = glm::vec3(m_renderScale, 0.0f);
+                    vkCmdPushConstants(a_cmdBuffer, m_pipes["present"].pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants),
+                            &constants);
+
+                    RecordCommandsOfDrawingQuad(m_meshes["quad"], a_cmdBuffer, m_pipes["present"],
+                            { m_inputAttachments.sceneColor.descriptorSet, bloom.descriptorSet });
+                }
+
+                vkCmdEndRenderPass(a_cmdBuffer);
+            }, true);
         }
 
         void RecordDrawingBuffer(VkFramebuffer a_swapChainFramebuffer, VkCommandBuffer a_cmdBuffer)
@@ -1965,83 +4538,41 @@ class Application
             if (vkBeginCommandBuffer(a_cmdBuffer, &beginInfo) != VK_SUCCESS) 
                 throw std::runtime_error("[CreateCommandPoolAndBuffers]: failed to begin recording command buffer!");
 
-            SetViewportAndScissor(a_cmdBuffer, (float)CUBE_SIDE, (float)CUBE_SIDE, true);
-
-            for (uint32_t face{}; face < 6; ++face)
-            {
-                RecordCommandsToRenderForCubemapFace(m_framebuffersOffscreen.shadowCubemapFrameBuffer, m_renderPasses.shadowCubemapPass,
-                        m_pipes["shadow cubemap"], face, a_cmdBuffer, m_renderables, m_pEyes["light"]);
-                RecordCommandsOfCopyingToCubemapFace(face, a_cmdBuffer, m_attachments.offscreenColor, m_inputAttachments.shadowCubemap.shadowCubemap);
-            }
-
-            // SSAO
-            {
-                SetViewportAndScissor(a_cmdBuffer, (float)WIDTH, (float)HEIGHT, true);
-                RecordCommandsOfFillingGBuffer(m_framebuffersOffscreen.gBufferCreationFrameBuffer, m_renderPasses.gBufferCreationPass,
-                        m_pipes["g buffer"], a_cmdBuffer, m_renderables, m_pEyes["camera"]);
-                RecordCommandsOfSSAOEvaluation(m_device, m_renderPasses.ssaoPass, m_framebuffersOffscreen.ssaoFrameBuffer, m_meshes["quad"],
-                        a_cmdBuffer, m_pipes["ssao"], m_inputAttachments, m_inputTextures["noise"], m_roUniformBuffers["ssao kernel"],
-                        m_pEyes["camera"]->projection());
-                RecordCommandsOfBluringSSAO(m_device, m_renderPasses.ssaoBlurPass, m_framebuffersOffscreen.ssaoBlurFrameBuffer, m_meshes["quad"],
-                        a_cmdBuffer, m_pipes["blur ssao"], m_inputAttachments.ssao);
-            }
-
-            // BLOOM
-            RecordCommandsOfDrawingBloomedParts(m_framebuffersOffscreen.bloomFrameBuffer, m_renderPasses.bloomPass,
-                    m_pipes["bloom"], a_cmdBuffer, m_renderables, m_pEyes["camera"]);
-
-            VkClearValue colorClear;
-            colorClear.color = { {  0.0f, 0.0f, 0.0f, 1.0f } };
-
-            VkClearValue depthClear;
-            depthClear.depthStencil.depth = 1.f;
-
-            std::vector<VkClearValue> clearValues{ colorClear, depthClear };
-
-            VkRenderPassBeginInfo renderPassInfo{};
-            renderPassInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassInfo.renderPass        = m_renderPasses.finalRenderPass;
-            renderPassInfo.framebuffer       = a_swapChainFramebuffer;
-            renderPassInfo.renderArea.offset = { 0, 0 };
-            renderPassInfo.renderArea.extent = m_screen.swapChainExtent;
-            renderPassInfo.clearValueCount   = clearValues.size();
-            renderPassInfo.pClearValues      = clearValues.data();
-
-            SetViewportAndScissor(a_cmdBuffer, (float)WIDTH, (float)HEIGHT, true);
-
-            vkCmdBeginRenderPass(a_cmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-            if (s_shadowmapDebug)
-            {
-                RecordCommandsOfShowingCubemap(m_device, m_meshes["quad"], a_cmdBuffer, &m_pipes["show cubemap"], m_inputAttachments.shadowCubemap);
-            }
-            else
-            {
-                RecordCommandsOfDrawingRenderables(m_renderables, a_cmdBuffer, nullptr, m_pEyes["camera"], m_pEyes["light"]->position(),
-                        m_inputAttachments.shadowCubemap,
-                        (s_ssaoEnabled) ? m_inputAttachments.blurredSSAO : m_inputTextures["white"],
-                        0, true, false);
-                RecordCommandsOfDrawingParticleSystems(m_particleSystems, a_cmdBuffer, m_pipes, m_pEyes["camera"]);
+            m_gpuTimer.begin(a_cmdBuffer, (uint32_t)m_currentFrame);
 
-                if (s_bloomEnabled)
-                {
-                    RecordCommandsOfBluringBloom(m_meshes["quad"], a_cmdBuffer, m_pipes["blur bloom"], m_inputAttachments.bloom);
-                }
-            }
+            // passes nothing reads are culled, barriers and layout transitions in between the rest are inferred
+            m_renderGraph.clearPasses();
+            DeclareRenderGraphPasses(a_swapChainFramebuffer, false);
+            m_renderGraph.compile();
+            m_renderGraph.execute(a_cmdBuffer);
 
-            vkCmdEndRenderPass(a_cmdBuffer);
+            m_gpuTimer.end(a_cmdBuffer, (uint32_t)m_currentFrame);
 
             if (vkEndCommandBuffer(a_cmdBuffer) != VK_SUCCESS) {
                 throw std::runtime_error("failed to record command buffer!");
             }
         }
 
-        static void UpdateParticleSystems(std::unordered_map<std::string, ParticleSystem>& a_particleSystems, glm::vec3 a_emmiterPos)
+        // chunks of all cpu simulated systems go to the same job queue, so small emitters run in parallel with each other
+        // and big ones are split across threads (every chunk writes its own region of the mapped vbo)
+        // a_frame: frame in flight whose fence has signaled, its region of the vertex ring is free to write
+        static void UpdateParticleSystems(JobSystem& a_jobSystem, std::unordered_map<std::string, ParticleSystem>& a_particleSystems,
+                glm::vec3 a_emmiterPos, uint32_t a_frame)
         {
             for (auto& ps : a_particleSystems)
             {
-                ps.second.updateParticles(a_emmiterPos);
+                auto& system{ ps.second };
+
+                system.setWriteRegion(a_frame);
+                system.beginUpdate(a_emmiterPos);
+
+                for (uint32_t chunk{}; chunk < system.getChunkCount(); ++chunk)
+                {
+                    a_jobSystem.submit([&system, chunk]() { system.updateChunk(chunk); });
+                }
             }
+
+            a_jobSystem.wait();
         }
 
         static void CreateDrawCommandBuffers(VkDevice a_device, VkCommandPool a_cmdPool, std::vector<VkFramebuffer> a_swapChainFramebuffers,
@@ -2084,8 +4615,8 @@ class Application
             }
         }
 
-        static void CreateShadowmapTexture(VkDevice a_device, VkPhysicalDevice a_physDevice, VkCommandPool a_pool, VkQueue a_queue,
-                CubeTexture& a_cubemap)
+        static void CreateShadowAtlasTexture(VkDevice a_device, VkPhysicalDevice a_physDevice, VkCommandPool a_pool, VkQueue a_queue,
+                Texture& a_atlas)
         {
             VkCommandBufferAllocateInfo allocInfo = {};
             allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -2103,12 +4634,15 @@ class Application
 
             VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuff, &beginInfo));
             {
-                a_cubemap.setExtent(VkExtent3D{uint32_t(CUBE_SIDE), uint32_t(CUBE_SIDE), 1});
-                a_cubemap.create(a_device, a_physDevice, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R32_SFLOAT);
+                // distances are not interpolated (neighbouring texels may belong to another face)
+                a_atlas.setExtent(VkExtent3D{ SHADOW_ATLAS_SIDE, SHADOW_ATLAS_SIDE, 1 });
+                a_atlas.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+                a_atlas.setFilter(VK_FILTER_NEAREST);
+                a_atlas.create(a_device, a_physDevice, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R32_SFLOAT);
 
-                VkImageMemoryBarrier imgBar = a_cubemap.makeBarrier(a_cubemap.wholeImageRange(), 0, VK_ACCESS_SHADER_READ_BIT,
+                VkImageMemoryBarrier imgBar = a_atlas.makeBarrier(a_atlas.wholeImageRange(), 0, VK_ACCESS_SHADER_READ_BIT,
                         VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-                a_cubemap.changeImageLayout(cmdBuff, imgBar, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+                a_atlas.changeImageLayout(cmdBuff, imgBar, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
             }
             VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuff));
 
@@ -2117,110 +4651,221 @@ class Application
             vkFreeCommandBuffers(a_device, a_pool, 1, &cmdBuff);
         }
 
-        static void CreateAttachments(VkDevice a_device, VkPhysicalDevice a_physDevice, VkCommandPool a_pool, VkQueue a_queue, Attachments& a_attachments)
+        // images the render graph may alias (see CreateAliasedAttachmentMemory) get no memory here,
+        // all of them are left in undefined layout: the render graph transitions them on first use;
+        // targets of the camera passes are a_extent (swapchain) large and are created again when it changes
+        static void CreateAttachments(VkDevice a_device, VkPhysicalDevice a_physDevice, Attachments& a_attachments, VkExtent2D a_extent)
         {
-            VkCommandBufferAllocateInfo allocInfo = {};
-            allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-            allocInfo.commandPool        = a_pool;
-            allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-            allocInfo.commandBufferCount = 1;
-
-            VkCommandBuffer cmdBuff{};
-            if (vkAllocateCommandBuffers(a_device, &allocInfo, &cmdBuff) != VK_SUCCESS)
-                throw std::runtime_error("[CopyBufferToTexure]: failed to allocate command buffer!");
+            const VkExtent3D full{ a_extent.width, a_extent.height, 1 };
+            const VkExtent3D low{ std::max(a_extent.width / SSAO_DOWNSCALE, 1u), std::max(a_extent.height / SSAO_DOWNSCALE, 1u), 1 };
+
+            // Shadow face renderpass - color attachment (copied into the region of the face)
+            Texture& offscreenColor = a_attachments.offscreenColor;
+            offscreenColor.setExtent(VkExtent3D{ SHADOW_MAX_FACE_SIDE, SHADOW_MAX_FACE_SIDE, 1 });
+            offscreenColor.createImage(a_device, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_FORMAT_R32_SFLOAT);
+
+            // Shadow face renderpass - depth attachment (never leaves the render pass)
+            Texture& offscreenDepth = a_attachments.offscreenDepth;
+            offscreenDepth.setExtent(VkExtent3D{ SHADOW_MAX_FACE_SIDE, SHADOW_MAX_FACE_SIDE, 1 });
+            offscreenDepth.create(a_device, a_physDevice, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+                    VK_FORMAT_D32_SFLOAT);
+
+            // SSAO - color attachments
+            Texture& gBufferN = a_attachments.gNormals;
+            gBufferN.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+            gBufferN.setExtent(full);
+            gBufferN.createImage(a_device, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R16G16_SFLOAT);
+
+            Texture& ssao = a_attachments.ssao;
+            ssao.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+            ssao.setExtent(low);
+            ssao.createImage(a_device, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+                    VK_FORMAT_R32_SFLOAT);
+
+            Texture& blurredSSAO = a_attachments.blurredSSAO;
+            blurredSSAO.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+            blurredSSAO.setExtent(low);
+            blurredSSAO.createImage(a_device, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+                    VK_FORMAT_R32_SFLOAT);
+
+            // SSAO - low resolution g buffer + upsampled result
+            if (SSAO_DOWNSCALE > 1)
+            {
+                Texture& lowResD = a_attachments.lowResDepth;
+                lowResD.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+                lowResD.setFilter(VK_FILTER_NEAREST); // depth must not be interpolated across edges
+                lowResD.setExtent(low);
+                lowResD.createImage(a_device, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R32_SFLOAT);
+
+                Texture& lowResN = a_attachments.lowResNormals;
+                lowResN.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+                lowResN.setExtent(low);
+                lowResN.createImage(a_device, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R16G16_SFLOAT);
+
+                Texture& upsampledSSAO = a_attachments.upsampledSSAO;
+                upsampledSSAO.setExtent(full);
+                upsampledSSAO.createImage(a_device, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R32_SFLOAT);
+            }
 
-            VkCommandBufferBeginInfo beginInfo{};
-            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            // Temporal accumulation - history is read before it is ever written (rejected by the shader on frame 0)
+            // written one is an input attachment of the scene subpass, read one is sampled
+            a_attachments.temporalHistory.resize(2);
 
-            VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuff, &beginInfo));
+            for (auto& history : a_attachments.temporalHistory)
             {
-                // Shadow cubemap renderpass - color attachment
-                Texture& offscreenColor = a_attachments.offscreenColor;
-                offscreenColor.setExtent(VkExtent3D{uint32_t(CUBE_SIDE), uint32_t(CUBE_SIDE), 1});
-                offscreenColor.create(a_device, a_physDevice, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_FORMAT_R32_SFLOAT);
+                history.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+                history.setExtent(full);
+                history.create(a_device, a_physDevice, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT
+                        | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R16G16B16A16_SFLOAT);
+            }
+
+            // Weighted blended particles - written and read back (input attachments) within the scene pass
+            Texture& oitAccumulation = a_attachments.oitAccumulation;
+            oitAccumulation.setExtent(full);
+            oitAccumulation.create(a_device, a_physDevice, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT
+                    | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, VK_FORMAT_R16G16B16A16_SFLOAT);
+
+            Texture& oitRevealage = a_attachments.oitRevealage;
+            oitRevealage.setExtent(full);
+            oitRevealage.create(a_device, a_physDevice, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT
+                    | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, VK_FORMAT_R16_SFLOAT);
+
+            // Bloom - mip chain color attachments
+            a_attachments.bloomChain.resize(BLOOM_MIP_LEVELS);
 
-                VkImageMemoryBarrier imgBar = offscreenColor.makeBarrier(offscreenColor.wholeImageRange(), 0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-                offscreenColor.changeImageLayout(cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            VkExtent3D levelExtent{ std::max(full.width / 2, 1u), std::max(full.height / 2, 1u), 1 };
+            for (auto& level : a_attachments.bloomChain)
+            {
+                level.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+                level.setExtent(levelExtent);
+                level.createImage(a_device, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R16G16B16A16_SFLOAT);
 
-                // Shadow cubemap renderpass - depth attachment
-                Texture& offscreenDepth = a_attachments.offscreenDepth;
-                offscreenDepth.setExtent(VkExtent3D{uint32_t(CUBE_SIDE), uint32_t(CUBE_SIDE), 1});
-                offscreenDepth.create(a_device, a_physDevice, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_FORMAT_D32_SFLOAT);
+                levelExtent.width  = std::max(levelExtent.width / 2, 1u);
+                levelExtent.height = std::max(levelExtent.height / 2, 1u);
+            }
 
-                imgBar = offscreenDepth.makeBarrier(offscreenDepth.wholeImageRange(), 0, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
-                offscreenDepth.changeImageLayout(cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT);
+            // Scene renderpass - HDR color attachment
+            Texture& sceneColor = a_attachments.sceneColor;
+            sceneColor.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+            sceneColor.setExtent(full);
+            sceneColor.createImage(a_device, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R16G16B16A16_SFLOAT);
+
+            // Scene renderpass - depth attachment (shared with g buffer, sampled by ssao)
+            Texture& presentDepth = a_attachments.presentDepth;
+            presentDepth.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+            presentDepth.setFilter(VK_FILTER_NEAREST); // linear filtering of depth formats is optional
+            presentDepth.setExtent(full);
+            presentDepth.create(a_device, a_physDevice, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                    VK_FORMAT_D32_SFLOAT);
+        }
 
-                // SSAO - color attachments
-                Texture& gBufferPD = a_attachments.gPositionAndDepth;
-                gBufferPD.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
-                gBufferPD.setExtent(VkExtent3D{uint32_t(WIDTH), uint32_t(HEIGHT), 1});
-                gBufferPD.create(a_device, a_physDevice, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R32G32B32A32_SFLOAT);
+        // everything of CreateAttachments and CreateAliasedAttachmentMemory, the shadow atlas is not one of them
+        static void DestroyAttachments(VkDevice a_device, Attachments& a_attachments)
+        {
+            a_attachments.sceneColor.cleanup();
+            a_attachments.presentDepth.cleanup();
+            a_attachments.offscreenDepth.cleanup();
+            a_attachments.oitAccumulation.cleanup();
+            a_attachments.oitRevealage.cleanup();
+            a_attachments.offscreenColor.cleanup();
+            a_attachments.gNormals.cleanup();
+            a_attachments.ssao.cleanup();
+            a_attachments.blurredSSAO.cleanup();
+
+            if (SSAO_DOWNSCALE > 1)
+            {
+                a_attachments.lowResDepth.cleanup();
+                a_attachments.lowResNormals.cleanup();
+                a_attachments.upsampledSSAO.cleanup();
+            }
 
-                imgBar = gBufferPD.makeBarrier(gBufferPD.wholeImageRange(), 0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-                gBufferPD.changeImageLayout(cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            for (auto& level : a_attachments.bloomChain)
+            {
+                level.cleanup();
+            }
 
-                Texture& gBufferN = a_attachments.gNormals;
-                gBufferN.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
-                gBufferN.setExtent(VkExtent3D{uint32_t(WIDTH), uint32_t(HEIGHT), 1});
-                gBufferN.create(a_device, a_physDevice, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R32G32B32A32_SFLOAT);
+            for (auto& history : a_attachments.temporalHistory)
+            {
+                history.cleanup();
+            }
 
-                imgBar = gBufferN.makeBarrier(gBufferN.wholeImageRange(), 0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-                gBufferN.changeImageLayout(cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            for (auto memory : a_attachments.aliasedMemory)
+            {
+                vkFreeMemory(a_device, memory, nullptr);
+            }
+            a_attachments.aliasedMemory.clear();
+        }
 
-                Texture& ssao = a_attachments.ssao;
-                ssao.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
-                ssao.setExtent(VkExtent3D{uint32_t(WIDTH), uint32_t(HEIGHT), 1});
-                ssao.create(a_device, a_physDevice, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R32_SFLOAT);
+        // transient attachments with lifetimes (over the passes of a frame with everything enabled) that do not overlap
+        // share one allocation, e.g. shadow face color with g buffer normals and ssao with bloom levels;
+        // runs again for recreated attachments, registering them again starts them in undefined layout
+        void CreateAliasedAttachmentMemory()
+        {
+            Attachments& a{ m_attachments };
 
-                imgBar = ssao.makeBarrier(ssao.wholeImageRange(), 0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-                ssao.changeImageLayout(cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            for (auto& history : a.temporalHistory)
+            {
+                m_renderGraph.addImage(&history, RenderGraph::PERSISTENT);
+            }
+            m_renderGraph.addImage(&a.presentDepth);
+            m_renderGraph.addImage(&a.offscreenDepth);
+            m_renderGraph.addImage(&a.oitAccumulation);
+            m_renderGraph.addImage(&a.oitRevealage);
 
-                Texture& blurredSSAO = a_attachments.blurredSSAO;
-                blurredSSAO.setExtent(VkExtent3D{uint32_t(WIDTH), uint32_t(HEIGHT), 1});
-                blurredSSAO.create(a_device, a_physDevice, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R32_SFLOAT);
+            std::vector<Texture*> transient{ &a.offscreenColor, &a.gNormals, &a.ssao, &a.blurredSSAO, &a.sceneColor };
+            if (SSAO_DOWNSCALE > 1)
+            {
+                transient.insert(transient.end(), { &a.lowResDepth, &a.lowResNormals, &a.upsampledSSAO });
+            }
+            for (auto& level : a.bloomChain)
+            {
+                transient.push_back(&level);
+            }
+            for (auto* texture : transient)
+            {
+                m_renderGraph.addImage(texture, RenderGraph::TRANSIENT);
+            }
 
-                imgBar = blurredSSAO.makeBarrier(blurredSSAO.wholeImageRange(), 0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-                blurredSSAO.changeImageLayout(cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            m_renderGraph.clearPasses();
+            DeclareRenderGraphPasses(VK_NULL_HANDLE, true);
 
-                // Bloom - color attachments + depth attachment
+            VkDeviceSize aliasedSize{};
+            VkDeviceSize totalSize{};
 
-                Texture& bloom = a_attachments.bloom;
-                bloom.setAddressMode(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
-                bloom.setExtent(VkExtent3D{uint32_t(BLOOM_DIM), uint32_t(BLOOM_DIM), 1});
-                bloom.create(a_device, a_physDevice, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_FORMAT_R32G32B32A32_SFLOAT);
+            for (const auto& group : m_renderGraph.planAliasing())
+            {
+                VkMemoryRequirements requirements{};
+                requirements.memoryTypeBits = ~0u;
 
-                imgBar = bloom.makeBarrier(bloom.wholeImageRange(), 0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-                bloom.changeImageLayout(cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+                for (auto* texture : group)
+                {
+                    VkMemoryRequirements textureRequirements{ texture->getMemoryRequirements() };
+                    requirements.size            = std::max(requirements.size, textureRequirements.size);
+                    requirements.alignment       = std::max(requirements.alignment, textureRequirements.alignment);
+                    requirements.memoryTypeBits &= textureRequirements.memoryTypeBits;
+                    totalSize                   += textureRequirements.size;
+                }
 
-                Texture& bloomDepth = a_attachments.bloomDepth;
-                bloomDepth.setExtent(VkExtent3D{uint32_t(BLOOM_DIM), uint32_t(BLOOM_DIM), 1});
-                bloomDepth.create(a_device, a_physDevice, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_FORMAT_D32_SFLOAT);
+                VkMemoryAllocateInfo allocateInfo{};
+                allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+                allocateInfo.allocationSize  = requirements.size;
+                allocateInfo.memoryTypeIndex = vk_utils::FindMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                        physicalDevice);
 
-                imgBar = bloomDepth.makeBarrier(bloomDepth.wholeImageRange(), 0, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
-                bloomDepth.changeImageLayout(cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT);
+                VkDeviceMemory memory{};
+                VK_CHECK_RESULT(vkAllocateMemory(m_device, &allocateInfo, nullptr, &memory));
+                a.aliasedMemory.push_back(memory);
 
-                // Final renderpass - depth attachment
-                Texture& presentDepth = a_attachments.presentDepth;
-                presentDepth.setExtent(VkExtent3D{uint32_t(WIDTH), uint32_t(HEIGHT), 1});
-                presentDepth.create(a_device, a_physDevice, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_FORMAT_D32_SFLOAT);
+                for (auto* texture : group)
+                {
+                    texture->bindMemory(memory, 0);
+                }
 
-                imgBar = presentDepth.makeBarrier(presentDepth.wholeImageRange(), 0, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
-                presentDepth.changeImageLayout(cmdBuff, imgBar, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT);
+                aliasedSize += requirements.size;
             }
-            VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuff));
-            RunCommandBuffer(cmdBuff, a_queue, a_device);
 
-            vkFreeCommandBuffers(a_device, a_pool, 1, &cmdBuff);
+            std::cout << "		" << transient.size() << " transient attachments in " << a.aliasedMemory.size() << " allocations: "
+                << aliasedSize / (1024 * 1024) << " MiB instead of " << totalSize / (1024 * 1024) << " MiB\n";
         }
 
         static void CreateHostVisibleBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, const size_t a_bufferSize,
@@ -2328,13 +4973,204 @@ class Application
             vkDestroyFence(a_device, fence, NULL);
         }
 
+        // pipelines of shaders edited since they were loaded are rebuilt and swapped in place (renderables point into m_pipes)
+        void ReloadChangedShaders()
+        {
+            std::vector<std::string> changed{ m_shaders.poll() };
+            if (changed.empty())
+            {
+                return;
+            }
+
+            for (const auto& source : changed)
+            {
+                std::cout << "reloading " << source << "...\n";
+            }
+
+            std::vector<PipelineBatch::Created> rebuilt{ m_pipelineBatch.rebuild(m_device, m_pipelineCache.get(), m_jobSystem, m_shaders,
+                    changed) };
+
+            // old pipelines may still be used by frames in flight
+            vkDeviceWaitIdle(m_device);
+
+            for (auto& created : rebuilt)
+            {
+                Pipe& pipe{ m_pipes[created.name] };
+                vkDestroyPipeline(m_device, pipe.pipeline, nullptr);
+                pipe.pipeline = created.pipeline;
+            }
+        }
+
+        // attachments of the camera passes, their memory, framebuffers and the hi-z tiles are created again at a_extent,
+        // descriptor sets are kept and rewritten; device must be idle
+        void RecreateCameraTargets(VkExtent2D a_extent)
+        {
+            DestroyOffscreenFrameBuffers();
+            DestroyAttachments(m_device, m_attachments);
+
+            CreateAttachments(m_device, physicalDevice, m_attachments, a_extent);
+            CreateAliasedAttachmentMemory();
+            UpdateDSForAttachments(m_device, m_inputAttachments);
+            CreateOffscreenFrameBuffers();
+
+            vkDestroyBuffer(m_device, m_culling.hiZTiles, nullptr);
+            vkFreeMemory   (m_device, m_culling.hiZTilesMemory, nullptr);
+            CreateHiZBuffers(m_device, physicalDevice, m_culling, m_attachments.presentDepth.getExtent());
+            UpdateDSForHiZ(m_device, m_culling);
+
+            // contents of the old targets are gone
+            for (uint32_t frame{}; frame < MAX_FRAMES_IN_FLIGHT; ++frame)
+            {
+                m_culling.hiZWritten[frame] = false;
+            }
+            m_historyValid = false;
+
+            m_pEyes["camera"]->setTargetSize(glm::vec2(a_extent.width, a_extent.height));
+        }
+
+        // the swapchain follows the window, targets of the camera passes follow the swapchain (see RecreateCameraTargets)
+        void RecreateSwapChain()
+        {
+            int width{}, height{};
+            glfwGetFramebufferSize(m_window, &width, &height);
+
+            // minimized
+            while ((width == 0 || height == 0) && !glfwWindowShouldClose(m_window))
+            {
+                glfwWaitEvents();
+                glfwGetFramebufferSize(m_window, &width, &height);
+            }
+            if (width == 0 || height == 0)
+            {
+                return;
+            }
+
+            // the old swapchain is retired by the new one and keeps its images on screen until the first present
+            vk_utils::ScreenBufferResources oldScreen{ m_screen };
+            m_presentMode = s_presentMode;
+            vk_utils::CreateCwapChain(physicalDevice, m_device, m_surface, width, height, m_presentMode, &m_screen, oldScreen.swapChain);
+
+            if (m_screen.swapChainImageFormat != oldScreen.swapChainImageFormat)
+            {
+                throw std::runtime_error("[RecreateSwapChain]: surface format changed, final render pass does not match!");
+            }
+
+            vk_utils::CreateScreenImageViews(m_device, &m_screen);
+            CreateScreenFrameBuffers(m_device, m_renderPasses.finalRenderPass, &m_screen);
+
+            // frames in flight may still render to or present images of the old swapchain
+            vkDeviceWaitIdle(m_device);
+
+            for (auto framebuffer : oldScreen.swapChainFramebuffers)
+            {
+                vkDestroyFramebuffer(m_device, framebuffer, nullptr);
+            }
+            for (auto imageView : oldScreen.swapChainImageViews)
+            {
+                vkDestroyImageView(m_device, imageView, nullptr);
+            }
+            vkDestroySwapchainKHR(m_device, oldScreen.swapChain, nullptr);
+            m_latency.discard();
+
+            VkExtent3D targets{ m_attachments.sceneColor.getExtent() };
+            if (targets.width != m_screen.swapChainExtent.width || targets.height != m_screen.swapChainExtent.height)
+            {
+                RecreateCameraTargets(m_screen.swapChainExtent);
+            }
+
+            // one command buffer per swapchain image
+            if (m_drawCommandBuffers.size() != m_screen.swapChainFramebuffers.size())
+            {
+                vkFreeCommandBuffers(m_device, m_commandPool, m_drawCommandBuffers.size(), m_drawCommandBuffers.data());
+                CreateDrawCommandBuffers(m_device, m_commandPool, m_screen.swapChainFramebuffers, &m_drawCommandBuffers);
+            }
+
+            std::cout << "swapchain: " << m_screen.swapChainExtent.width << "x" << m_screen.swapChainExtent.height << ", "
+                      << PresentModeName(m_screen.presentMode) << "\n";
+        }
+
+        // latency of the frames measured since the last report, with the pacing they ran with
+        void ReportLatency()
+        {
+            float    average{}, worst{};
+            uint32_t count{};
+            if (m_latency.report(average, worst, count))
+            {
+                std::cout << "input to present latency: " << average << " ms average, " << worst << " ms max over " << count
+                          << " frames (" << ((m_latency.presentWait()) ? "present wait" : "cpu estimate, until the gpu is done")
+                          << "; " << PresentModeName(m_screen.presentMode) << ", " << m_framesInFlight << " frames in flight, limiter "
+                          << ((s_frameLimiter) ? "on" : "off") << ")\n";
+            }
+        }
+
+        // per frame resources stay allocated for MAX_FRAMES_IN_FLIGHT slots, only the first m_framesInFlight are used
+        void ChangeFramesInFlight(uint32_t a_count)
+        {
+            vkDeviceWaitIdle(m_device);
+
+            // slots that were not used for a while hold results of old frames
+            for (uint32_t frame{}; frame < MAX_FRAMES_IN_FLIGHT; ++frame)
+            {
+                float stale{};
+                m_gpuTimer.read(frame, stale);
+                m_gpuTimer.readSections(frame, stale);
+                m_culling.hiZWritten[frame] = false;
+            }
+            m_latency.discard();
+
+            m_framesInFlight = a_count;
+            m_currentFrame   = 0;
+        }
+
         void DrawFrame() 
         {
+            if (s_framesInFlight != m_framesInFlight)
+            {
+                ChangeFramesInFlight(s_framesInFlight);
+            }
+
             vkWaitForFences(m_device, 1, &m_sync.inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
-            vkResetFences  (m_device, 1, &m_sync.inFlightFences[m_currentFrame]);
+            m_latency.poll(m_screen.swapChain);
+            m_latency.frameRetired((uint32_t)m_currentFrame);
+
+            // gpu time of the frame that used this slot m_framesInFlight frames ago steers the render scale of this one
+            float gpuTime{};
+            if (m_gpuTimer.read((uint32_t)m_currentFrame, gpuTime) && s_dynamicResolution)
+            {
+                m_dynamicResolution.update(gpuTime);
+            }
+            float particleShadowTime{};
+            if (m_gpuTimer.readSections((uint32_t)m_currentFrame, particleShadowTime))
+            {
+                m_particleShadowFraction = ParticleShadowFraction(m_particleShadowFraction, particleShadowTime);
+            }
+            m_renderScale = glm::vec2((s_dynamicResolution) ? m_dynamicResolution.scale() : 1.0f);
+            m_pEyes["camera"]->setRenderScale(m_renderScale);
+
+            // previous frames may still be drawing their own regions of particle vertex rings
+            UpdateParticleSystems(m_jobSystem, m_particleSystems, m_pEyes["light"]->position(), m_currentFrame);
+            AssignShadowedPointLights(m_shadows, m_pointLights, m_pEyes["camera"]);
+            UploadPointLights(m_clusters, m_pointLights, m_currentFrame);
+            PlanShadowFaces(m_shadows, m_pEyes["camera"], m_frameCount, QUALITY_SETTINGS[s_qualityPreset].shadowTexelBudget);
+            UploadShadowFaces(m_shadows, m_currentFrame);
+            CullRenderables(m_culling, m_renderables, m_pEyes["camera"], m_shadows, m_currentFrame);
 
             uint32_t imageIndex;
-            vkAcquireNextImageKHR(m_device, m_screen.swapChain, UINT64_MAX, m_sync.imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
+            VkResult acquired{ vkAcquireNextImageKHR(m_device, m_screen.swapChain, UINT64_MAX, m_sync.imageAvailableSemaphores[m_currentFrame],
+                    VK_NULL_HANDLE, &imageIndex) };
+
+            // nothing is submitted for this frame, its semaphore is left unsignaled and its fence signaled
+            if (acquired == VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                RecreateSwapChain();
+                return;
+            }
+            if (acquired != VK_SUCCESS && acquired != VK_SUBOPTIMAL_KHR)
+            {
+                throw std::runtime_error("[DrawFrame]: failed to acquire swapchain image!");
+            }
+
+            vkResetFences(m_device, 1, &m_sync.inFlightFences[m_currentFrame]);
 
             if (vkResetCommandBuffer(m_drawCommandBuffers[imageIndex], 0) != VK_SUCCESS)
             {
@@ -2343,6 +5179,10 @@ class Application
 
             RecordDrawingBuffer(m_screen.swapChainFramebuffers[imageIndex], m_drawCommandBuffers[imageIndex]);
 
+            // next frame reprojects into this one
+            m_prevViewProjection = m_pEyes["camera"]->renderProjection() * m_pEyes["camera"]->view(0);
+            ++m_frameCount;
+
             VkSemaphore      waitSemaphores[]{ m_sync.imageAvailableSemaphores[m_currentFrame] };
             VkPipelineStageFlags waitStages[]{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
@@ -2375,8 +5215,40 @@ class Application
             presentInfo.pSwapchains     = swapChains;
             presentInfo.pImageIndices   = &imageIndex;
 
-            vkQueuePresentKHR(m_presentQueue, &presentInfo);
-            m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+            // frame count only grows, so ids increase on every swapchain
+            uint64_t presentId{ m_frameCount };
+
+            VkPresentIdKHR presentIdInfo{};
+            presentIdInfo.sType          = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+            presentIdInfo.swapchainCount = 1;
+            presentIdInfo.pPresentIds    = &presentId;
+
+            if (m_latency.presentWait())
+            {
+                presentInfo.pNext = &presentIdInfo;
+            }
+
+            VkResult presented{ vkQueuePresentKHR(m_presentQueue, &presentInfo) };
+            m_latency.frameQueued((uint32_t)m_currentFrame, presentId, m_sync.inFlightFences[m_currentFrame]);
+            m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+
+            if (LATENCY_REPORT_SECONDS > 0.0f && m_timer.getTime() - m_latencyReportTime >= LATENCY_REPORT_SECONDS)
+            {
+                m_latencyReportTime = m_timer.getTime();
+                ReportLatency();
+            }
+
+            // suboptimal swapchains still present, they are replaced after the frame anyway (as are those of another present mode)
+            if (presented == VK_ERROR_OUT_OF_DATE_KHR || presented == VK_SUBOPTIMAL_KHR || s_framebufferResized ||
+                    s_presentMode != m_presentMode)
+            {
+                s_framebufferResized = false;
+                RecreateSwapChain();
+            }
+            else if (presented != VK_SUCCESS)
+            {
+                throw std::runtime_error("[DrawFrame]: failed to present swapchain image!");
+            }
         }
 
     public:
@@ -2387,11 +5259,12 @@ class Application
             glfwInit();
 
             glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-            glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+            glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
             m_window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
 
             glfwSetKeyCallback(m_window, keyCallback);
+            glfwSetFramebufferSizeCallback(m_window, framebufferSizeCallback);
 
             std::cout << "\tinitializing vulkan devices and queue...\n";
 
@@ -2420,7 +5293,28 @@ class Application
             if (!presentSupport)
                 throw std::runtime_error("vkGetPhysicalDeviceSurfaceSupportKHR: no present support for the target device and graphics queue");
 
-            m_device = vk_utils::CreateLogicalDevice(queueFID, physicalDevice, m_enabledLayers, deviceExtensions);
+            // present wait is optional, latency is estimated on the cpu without it
+            bool presentWait{ IsPresentWaitSupported(physicalDevice) };
+            std::vector<const char*> deviceExtensionNames{ deviceExtensions };
+
+            VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+            presentWaitFeatures.sType       = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+            presentWaitFeatures.presentWait = VK_TRUE;
+
+            VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+            presentIdFeatures.sType     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+            presentIdFeatures.pNext     = &presentWaitFeatures;
+            presentIdFeatures.presentId = VK_TRUE;
+
+            if (presentWait)
+            {
+                deviceExtensionNames.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+                deviceExtensionNames.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+            }
+
+            m_device = vk_utils::CreateLogicalDevice(queueFID, physicalDevice, m_enabledLayers, deviceExtensionNames,
+                    (presentWait) ? &presentIdFeatures : nullptr);
+            m_latency.create(m_device, presentWait, MAX_FRAMES_IN_FLIGHT);
             vkGetDeviceQueue(m_device, queueFID, 0, &m_graphicsQueue);
             vkGetDeviceQueue(m_device, queueFID, 0, &m_presentQueue);
 
@@ -2435,7 +5329,11 @@ class Application
                     throw std::runtime_error("[CreateCommandPoolAndBuffers]: failed to create command pool!");
             }
 
-            vk_utils::CreateCwapChain(physicalDevice, m_device, m_surface, WIDTH, HEIGHT, &m_screen);
+            int width{}, height{};
+            glfwGetFramebufferSize(m_window, &width, &height);
+            vk_utils::CreateCwapChain(physicalDevice, m_device, m_surface, width, height, m_presentMode, &m_screen);
+            std::cout << "\tpresent mode: " << PresentModeName(m_screen.presentMode) << ", latency: "
+                      << ((presentWait) ? "present wait" : "cpu estimate") << "\n";
 
             vk_utils::CreateScreenImageViews(m_device, &m_screen);
         }
@@ -2455,7 +5353,7 @@ class Application
                 tex.second.cleanup();
             }
 
-            for (auto ps : m_particleSystems)
+            for (auto& ps : m_particleSystems)
             {
                 ps.second.cleanup(m_device);
             }
@@ -2466,16 +5364,19 @@ class Application
                 vkFreeMemory   (m_device, ubo.second.memory, nullptr);
             }
 
-            m_attachments.shadowCubemap.cleanup();
-            m_attachments.bloom.cleanup();
-            m_attachments.bloomDepth.cleanup();
-            m_attachments.presentDepth.cleanup();
-            m_attachments.offscreenDepth.cleanup();
-            m_attachments.offscreenColor.cleanup();
-            m_attachments.gPositionAndDepth.cleanup();
-            m_attachments.gNormals.cleanup();
-            m_attachments.ssao.cleanup();
-            m_attachments.blurredSSAO.cleanup();
+            vkDestroyBuffer(m_device, m_clusters.lights, nullptr);
+            vkFreeMemory   (m_device, m_clusters.lightsMemory, nullptr);
+            vkDestroyBuffer(m_device, m_clusters.grid, nullptr);
+            vkFreeMemory   (m_device, m_clusters.gridMemory, nullptr);
+
+            vkDestroyBuffer(m_device, m_culling.hiZTiles, nullptr);
+            vkFreeMemory   (m_device, m_culling.hiZTilesMemory, nullptr);
+
+            vkDestroyBuffer(m_device, m_shadows.facesBuffer, nullptr);
+            vkFreeMemory   (m_device, m_shadows.facesMemory, nullptr);
+
+            m_attachments.shadowAtlas.cleanup();
+            DestroyAttachments(m_device, m_attachments);
 
             for (auto pipe : m_pipes)
             {
@@ -2483,17 +5384,31 @@ class Application
                 vkDestroyPipelineLayout(m_device, pipe.second.pipelineLayout, nullptr);
             }
 
+            m_pipelineCache.save();
+            m_pipelineCache.cleanup();
+
+            m_gpuTimer.cleanup();
+
             vkDestroyDescriptorPool(m_device, m_DSPools.textureDSPool, nullptr);
             vkDestroyDescriptorPool(m_device, m_DSPools.uboDSPool, nullptr);
+            vkDestroyDescriptorPool(m_device, m_DSPools.storageImageDSPool, nullptr);
+            vkDestroyDescriptorPool(m_device, m_DSPools.storageBufferDSPool, nullptr);
+            vkDestroyDescriptorPool(m_device, m_DSPools.inputAttachmentDSPool, nullptr);
             vkDestroyDescriptorSetLayout(m_device, m_DSLayouts.textureOnlyLayout, nullptr);
             vkDestroyDescriptorSetLayout(m_device, m_DSLayouts.uboOnlyLayout, nullptr);
+            vkDestroyDescriptorSetLayout(m_device, m_DSLayouts.storageImageOnlyLayout, nullptr);
+            vkDestroyDescriptorSetLayout(m_device, m_DSLayouts.storageBufferOnlyLayout, nullptr);
+            vkDestroyDescriptorSetLayout(m_device, m_DSLayouts.inputAttachmentOnlyLayout, nullptr);
 
             vkDestroyRenderPass(m_device, m_renderPasses.finalRenderPass, nullptr);
             vkDestroyRenderPass(m_device, m_renderPasses.shadowCubemapPass, nullptr);
             vkDestroyRenderPass(m_device, m_renderPasses.ssaoPass, nullptr);
             vkDestroyRenderPass(m_device, m_renderPasses.ssaoBlurPass, nullptr);
             vkDestroyRenderPass(m_device, m_renderPasses.gBufferCreationPass, nullptr);
-            vkDestroyRenderPass(m_device, m_renderPasses.bloomPass, nullptr);
+            vkDestroyRenderPass(m_device, m_renderPasses.gBufferDownsamplePass, nullptr);
+            vkDestroyRenderPass(m_device, m_renderPasses.scenePass, nullptr);
+            vkDestroyRenderPass(m_device, m_renderPasses.bloomDownsamplePass, nullptr);
+            vkDestroyRenderPass(m_device, m_renderPasses.bloomUpsamplePass, nullptr);
 
             for (auto& eyePtr : m_pEyes)
             {
@@ -2519,11 +5434,7 @@ class Application
             for (auto framebuffer : m_screen.swapChainFramebuffers) {
                 vkDestroyFramebuffer(m_device, framebuffer, nullptr);
             }
-            vkDestroyFramebuffer(m_device, m_framebuffersOffscreen.shadowCubemapFrameBuffer, nullptr);
-            vkDestroyFramebuffer(m_device, m_framebuffersOffscreen.ssaoFrameBuffer, nullptr);
-            vkDestroyFramebuffer(m_device, m_framebuffersOffscreen.ssaoBlurFrameBuffer, nullptr);
-            vkDestroyFramebuffer(m_device, m_framebuffersOffscreen.gBufferCreationFrameBuffer, nullptr);
-            vkDestroyFramebuffer(m_device, m_framebuffersOffscreen.bloomFrameBuffer, nullptr);
+            DestroyOffscreenFrameBuffers();
 
             for (auto imageView : m_screen.swapChainImageViews) {
                 vkDestroyImageView(m_device, imageView, nullptr);
@@ -2553,7 +5464,15 @@ class Application
 bool Application::s_shadowmapDebug;
 bool Application::s_ssaoEnabled{true};
 bool Application::s_bloomEnabled{true};
-VkDescriptorSet Application::s_blackTexutreDS;
+bool Application::s_ssaoCompute;
+QualityPreset Application::s_qualityPreset{QUALITY_MEDIUM};
+bool Application::s_dynamicResolution{true};
+bool Application::s_framebufferResized;
+VkPresentModeKHR Application::s_presentMode{PRESENT_MODE};
+uint32_t Application::s_framesInFlight{FRAMES_IN_FLIGHT};
+bool Application::s_frameLimiter{FRAME_LIMITER};
+bool Application::s_particleOIT{PARTICLES_WEIGHTED_OIT};
+bool Application::s_particleShadows{PARTICLE_SHADOWS};
 
 int main() 
 {
@@ -0,0 +1,67 @@
+// measures cpu particle update (simulation + vertex write) throughput
+
+#include <cstdio>
+#include <vector>
+#include <chrono>
+
+#include "ParticleSystem.hpp"
+#include "JobSystem.hpp"
+
+// a_pJobSystem = nullptr: single threaded update
+static void Benchmark(uint32_t a_particleCount, JobSystem* a_pJobSystem)
+{
+    Timer timer{};
+
+    ParticleSystem particles{};
+    particles.setTimer(&timer);
+    particles.initParticles(glm::vec3(0.0f), a_particleCount);
+
+    // host memory stands in for the mapped vbo
+    std::vector<glm::vec4> vertices(particles.getSize() / sizeof(glm::vec4) + 1);
+    particles.getMappedMemory() = vertices.data();
+
+    const uint32_t iterations{ glm::max(10u, 100000000u / a_particleCount) };
+    const float    timeStep{ 1.0f / 60.0f };
+
+    // warm up
+    particles.updateParticles(glm::vec3(0.0f), timeStep);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (uint32_t i{}; i < iterations; ++i)
+    {
+        if (a_pJobSystem)
+        {
+            particles.beginUpdate(glm::vec3(0.0f), timeStep);
+
+            for (uint32_t chunk{}; chunk < particles.getChunkCount(); ++chunk)
+            {
+                a_pJobSystem->submit([&particles, chunk]() { particles.updateChunk(chunk); });
+            }
+
+            a_pJobSystem->wait();
+        }
+        else
+        {
+            particles.updateParticles(glm::vec3(0.0f), timeStep);
+        }
+    }
+
+    float seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+
+    printf("%2u thread(s) %8u particles: %8.3f ms per update, %8.1f M particles/s\n",
+            a_pJobSystem ? a_pJobSystem->getThreadCount() : 1u, a_particleCount, 1000.0f * seconds / iterations, float(a_particleCount) * iterations / seconds / 1000000.0f);
+}
+
+int main()
+{
+    JobSystem jobSystem{};
+
+    for (uint32_t count : { 1000u, 100000u, 1000000u })
+    {
+        Benchmark(count, nullptr);
+        Benchmark(count, &jobSystem);
+    }
+
+    return 0;
+}
@@ -279,7 +279,8 @@ uint32_t vk_utils::GetQueueFamilyIndex(VkPhysicalDevice a_physicalDevice, VkQueu
 }
 
 
-VkDevice vk_utils::CreateLogicalDevice(uint32_t queueFamilyIndex, VkPhysicalDevice physicalDevice, const std::vector<const char *>& a_enabledLayers, std::vector<const char *> a_extentions)
+VkDevice vk_utils::CreateLogicalDevice(uint32_t queueFamilyIndex, VkPhysicalDevice physicalDevice, const std::vector<const char *>& a_enabledLayers, std::vector<const char *> a_extentions,
+        const void* a_pNext)
 {
     VkDeviceQueueCreateInfo queueCreateInfo = {};
     queueCreateInfo.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
@@ -293,6 +294,7 @@ VkDevice vk_utils::CreateLogicalDevice(uint32_t queueFamilyIndex, VkPhysicalDevi
     VkPhysicalDeviceFeatures deviceFeatures = {};
 
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceCreateInfo.pNext = a_pNext;
     deviceCreateInfo.enabledLayerCount    = uint32_t(a_enabledLayers.size());  // need to specify validation layers here as well.
     deviceCreateInfo.ppEnabledLayerNames  = a_enabledLayers.data();
     deviceCreateInfo.pQueueCreateInfos    = &queueCreateInfo;        // when creating the logical device, we also specify what queues it has.
@@ -307,6 +309,23 @@ VkDevice vk_utils::CreateLogicalDevice(uint32_t queueFamilyIndex, VkPhysicalDevi
     return device;
 }
 
+bool vk_utils::IsDeviceExtensionSupported(VkPhysicalDevice a_physicalDevice, const char* a_extension)
+{
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(a_physicalDevice, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(a_physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    for (const auto& extension : extensions)
+    {
+        if (strcmp(extension.extensionName, a_extension) == 0)
+            return true;
+    }
+
+    return false;
+}
+
 
 uint32_t vk_utils::FindMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags properties, VkPhysicalDevice physicalDevice)
 {
@@ -419,13 +438,11 @@ VkSurfaceFormatKHR ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>
     return availableFormats[0];
 }
 
-VkPresentModeKHR ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) 
+VkPresentModeKHR ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, VkPresentModeKHR a_preferred) 
 {
     for (const auto& availablePresentMode : availablePresentModes) 
     {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-            return availablePresentMode;
-        else if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
+        if (availablePresentMode == a_preferred)
             return availablePresentMode;
     }
 
@@ -451,12 +468,12 @@ VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, int a_
 
 
 void vk_utils::CreateCwapChain(VkPhysicalDevice a_physDevice, VkDevice a_device, VkSurfaceKHR a_surface, int a_width, int a_height,
-        ScreenBufferResources* a_buff)
+        VkPresentModeKHR a_presentMode, ScreenBufferResources* a_buff, VkSwapchainKHR a_oldSwapChain)
 {
     SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(a_physDevice, a_surface);
 
     VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat(swapChainSupport.formats);
-    VkPresentModeKHR presentMode     = ChooseSwapPresentMode(swapChainSupport.presentModes);
+    VkPresentModeKHR presentMode     = ChooseSwapPresentMode(swapChainSupport.presentModes, a_presentMode);
     VkExtent2D extent                = ChooseSwapExtent(swapChainSupport.capabilities, a_width, a_height);
 
     uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -478,7 +495,7 @@ void vk_utils::CreateCwapChain(VkPhysicalDevice a_physDevice, VkDevice a_device,
     createInfo.compositeAlpha   = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     createInfo.presentMode      = presentMode;
     createInfo.clipped          = VK_TRUE;
-    createInfo.oldSwapchain     = VK_NULL_HANDLE;
+    createInfo.oldSwapchain     = a_oldSwapChain;
 
     if (vkCreateSwapchainKHR(a_device, &createInfo, nullptr, &a_buff->swapChain) != VK_SUCCESS)
         throw std::runtime_error("[vk_utils::CreateCwapChain]: failed to create swap chain!");
@@ -489,6 +506,7 @@ void vk_utils::CreateCwapChain(VkPhysicalDevice a_physDevice, VkDevice a_device,
 
     a_buff->swapChainImageFormat = surfaceFormat.format;
     a_buff->swapChainExtent      = extent;
+    a_buff->presentMode          = presentMode;
 }
 
 void vk_utils::CreateScreenImageViews(VkDevice a_device, ScreenBufferResources* pScreen)
@@ -37,7 +37,10 @@ namespace vk_utils
 
   uint32_t GetQueueFamilyIndex(VkPhysicalDevice a_physicalDevice, VkQueueFlagBits a_bits);
   uint32_t GetComputeQueueFamilyIndex(VkPhysicalDevice a_physicalDevice);
-  VkDevice CreateLogicalDevice(uint32_t queueFamilyIndex, VkPhysicalDevice physicalDevice, const std::vector<const char *>& a_enabledLayers, std::vector<const char *> a_extentions = std::vector<const char *>());
+  // a_pNext: feature structures of the enabled extensions
+  VkDevice CreateLogicalDevice(uint32_t queueFamilyIndex, VkPhysicalDevice physicalDevice, const std::vector<const char *>& a_enabledLayers, std::vector<const char *> a_extentions = std::vector<const char *>(),
+          const void* a_pNext = nullptr);
+  bool     IsDeviceExtensionSupported(VkPhysicalDevice a_physicalDevice, const char* a_extension);
   uint32_t FindMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags properties, VkPhysicalDevice physicalDevice);
 
   //// FrameBuffer and SwapChain issues
@@ -48,12 +51,16 @@ namespace vk_utils
       std::vector<VkImage>       swapChainImages;
       VkFormat                   swapChainImageFormat;
       VkExtent2D                 swapChainExtent;
+      VkPresentModeKHR           presentMode;
       std::vector<VkImageView>   swapChainImageViews;
       std::vector<VkFramebuffer> swapChainFramebuffers;
   };
 
+  // a_presentMode: preferred, FIFO (supported everywhere) is used when the surface does not support it
+  // a_oldSwapChain: swapchain being replaced (it is retired, not destroyed), its presented images stay on screen until
+  // the new one presents
   void CreateCwapChain(VkPhysicalDevice a_physDevice, VkDevice a_device, VkSurfaceKHR a_surface, int a_width, int a_height,
-          ScreenBufferResources* a_buff);
+          VkPresentModeKHR a_presentMode, ScreenBufferResources* a_buff, VkSwapchainKHR a_oldSwapChain = VK_NULL_HANDLE);
 
   void CreateScreenImageViews(VkDevice a_device, ScreenBufferResources* pScreen);
 